@@ -7,17 +7,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "../interpreter/interpreter.h"
+#include "../parser/cache.h"
+#include "../parser/location.h"
 #include "../parser/parser.h"
+#include "../parser/serialize.h"
 #include "../parser/syntax.h"
+#include "../utils/alloc.h"
 #include "../utils/logger.h"
+#include "stats.h"
 
 extern ParserState PARSER_STATE;
 extern bool ParseFile(const char *filename);
+extern bool LexFile(const char *filename);
+
+typedef enum {
+  PHASE_LEX,
+  PHASE_PARSE,
+  PHASE_EXECUTE,
+} Phase;
 
 static const struct option LONG_OPTIONS[] = {
     {"syntax", no_argument, NULL, 's'},
+    {"format", required_argument, NULL, 'f'},
+    {"no-cache", no_argument, NULL, 'n'},
+    {"stop-after", required_argument, NULL, 'S'},
+    {"stream", no_argument, NULL, 'c'},
+    {"repl", no_argument, NULL, 'i'},
+    {"stats", no_argument, NULL, 'r'},
+    {"alloc-report", no_argument, NULL, 'a'},
+    {"profile", required_argument, NULL, 'p'},
     {"debug", no_argument, NULL, 'd'},
     {"help", no_argument, NULL, 'h'},
     {NULL, 0, NULL, 0},
@@ -25,6 +46,14 @@ static const struct option LONG_OPTIONS[] = {
 
 static const char *const DESCRIPTIONS[] = {
     "print syntax tree",
+    "syntax tree format (xml, json or sexp)",
+    "always parse SOURCE, bypassing the syntax tree cache",
+    "stop after phase (lex or parse), implies --no-cache",
+    "execute each statement as soon as it is parsed, implies --no-cache",
+    "read and execute statements interactively from stdin",
+    "print time, memory and syntax tree statistics to stderr",
+    "print allocations by call site and leaked memory to stderr at exit",
+    "write an execution profile in folded stack format to FILE",
     "enable debug logging",
     "print help message",
 };
@@ -32,7 +61,14 @@ static const char *const DESCRIPTIONS[] = {
 static void PrintHelp(void) {
   printf("%s\n\n", PACKAGE_STRING);
 
-  printf("Usage: %s [OPTIONS] SOURCE\n\n", PACKAGE_NAME);
+  printf("Usage: %s [OPTIONS] [SOURCE]\n\n", PACKAGE_NAME);
+  printf("SOURCE may be '-' to read from stdin. Without SOURCE, %s starts an\n"
+         "interactive session, see --repl.\n\n",
+         PACKAGE_NAME);
+  printf("With --stream or --repl, the syntax tree of each statement is\n"
+         "printed on its own. In the json and sexp formats, each tree takes a\n"
+         "single line, e.g., --format json emits one JSON document per "
+         "line.\n\n");
 
   size_t longest = 0;
   for (int i = 0; LONG_OPTIONS[i].val != 0; i++) {
@@ -55,16 +91,258 @@ static void PrintHelp(void) {
   printf("%s home page: <%s>\n", PACKAGE_NAME, PACKAGE_URL);
 }
 
+static bool WriteProfile(const Profiler *const profiler,
+                         const char *const filename) {
+  FILE *const file = fopen(filename, "w");
+  if (file == NULL) {
+    LOG_ERROR("Failed to open file '%s': %s", filename, strerror(errno));
+    return false;
+  }
+
+  if (!ProfilerWrite(profiler, file)) {
+    LOG_ERROR("Failed to write profile to '%s': %s", filename,
+              strerror(errno));
+    fclose(file);
+    return false;
+  }
+
+  if (fclose(file) != 0) {
+    LOG_ERROR("Failed to close file '%s': %s", filename, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+static void PrintAllocReport(void) { AllocReport(stderr); }
+
+/* How to run the source, shared by Run() and StreamStatement(). */
+static struct {
+  SyntaxTreeFormat format;
+  Profiler *profiler;
+  LineTable *lines; // Recorded while parsing, NULL if nothing is located
+  bool count_symbols;
+  bool execute; // Otherwise, stop after parsing
+} RUN;
+
+/**
+ * @brief Execute a statement of a streamed source as soon as it is parsed,
+ *        and release it along with the lines it spans. Hence, a source of any
+ *        length is executed in constant memory.
+ */
+static void StreamStatement(SymbolStatement *const statement) {
+  StatsEndPhase(STATS_PHASE_PARSE);
+
+  if (RUN.count_symbols) {
+    StatsCountSymbols(statement);
+  }
+
+  if (RUN.execute) {
+    StatsBeginPhase(STATS_PHASE_EXECUTE);
+    WalkSyntaxTree(statement, RUN.format, RUN.profiler, RUN.lines);
+    StatsEndPhase(STATS_PHASE_EXECUTE);
+  } else {
+    SyntaxTreeFree((Symbol *)statement);
+  }
+
+  if (RUN.lines != NULL) {
+    LineTableDiscard(RUN.lines, PARSER_STATE.offset);
+  }
+
+  StatsBeginPhase(STATS_PHASE_PARSE);
+}
+
+static bool RunStreamed(const char *const filename) {
+  PARSER_STATE.on_statement = StreamStatement;
+
+  StatsBeginPhase(STATS_PHASE_PARSE);
+  const bool success = ParseFile(filename);
+  StatsEndPhase(STATS_PHASE_PARSE);
+  return success;
+}
+
+/* Input of an interactive session, see ReadLine(). */
+static struct {
+  char *line; // Allocated by getline(3)
+  size_t capacity;
+  size_t length;
+  size_t offset; // Bytes of the line already handed to the lexer
+  bool prompt;   // Whether stdin is a terminal
+} REPL;
+
+/**
+ * @brief Hand the next line of an interactive session to the lexer, which
+ *        hence never lexes a line twice nor waits for more than one line.
+ *        Prompts for the line if stdin is a terminal, with "... " while a
+ *        statement is unfinished.
+ */
+static size_t ReadLine(char *const buf, const size_t size) {
+  if (REPL.offset == REPL.length) {
+    if (REPL.prompt) {
+      fputs(PARSER_STATE.in_statement ? "... " : "> ", stdout);
+      fflush(stdout);
+    }
+
+    const ssize_t length = getline(&REPL.line, &REPL.capacity, stdin);
+    if (length <= 0) {
+      if (REPL.prompt) {
+        putchar('\n');
+      }
+      return 0;
+    }
+    REPL.length = (size_t)length;
+    REPL.offset = 0;
+  }
+
+  const size_t available = REPL.length - REPL.offset;
+  const size_t length = (available < size) ? available : size;
+  memcpy(buf, REPL.line + REPL.offset, length);
+  REPL.offset += length;
+  return length;
+}
+
+/**
+ * @brief Read, parse and execute statements from stdin until its end. The
+ *        statements share the same parser, lexer and interpreter, and a
+ *        syntax error only discards the statement it occurs in.
+ */
+static bool RunInteractive(void) {
+  REPL.prompt = isatty(STDIN_FILENO);
+  PARSER_STATE.read_input = ReadLine;
+  PARSER_STATE.interactive = true;
+
+  const bool success = RunStreamed("-");
+  free(REPL.line); // Allocated by getline(3)
+  return success;
+}
+
+/**
+ * @brief Parse the source (or load its syntax tree from the cache), and then
+ *        execute it.
+ */
+static bool Run(const char *const filename, const bool use_cache) {
+  StatsBeginPhase(STATS_PHASE_LOAD);
+  CacheEntry *const cache = use_cache ? CacheOpen(filename) : NULL;
+  SymbolStatement *statement;
+  const bool cache_hit = (cache != NULL) && CacheLoad(cache, &statement);
+  StatsEndPhase(STATS_PHASE_LOAD);
+
+  if (!cache_hit) {
+    StatsBeginPhase(STATS_PHASE_PARSE);
+    const bool success = ParseFile(filename);
+    StatsEndPhase(STATS_PHASE_PARSE);
+    if (!success) {
+      CacheClose(cache);
+      return false;
+    }
+    statement = PARSER_STATE.statement;
+
+    if (cache != NULL) {
+      StatsBeginPhase(STATS_PHASE_LOAD);
+      CacheStore(cache, statement);
+      StatsEndPhase(STATS_PHASE_LOAD);
+    }
+  }
+  CacheClose(cache);
+
+  if (RUN.count_symbols) {
+    StatsCountSymbols(statement);
+  }
+
+  if (!RUN.execute) {
+    // The process exits right away, there is no point in freeing the tree
+    return true;
+  }
+
+  // The lines of a cached syntax tree were never lexed
+  if (cache_hit && RUN.lines != NULL &&
+      !LineTableReadFile(RUN.lines, filename)) {
+    SyntaxTreeFree((Symbol *)statement);
+    return false;
+  }
+
+  StatsBeginPhase(STATS_PHASE_EXECUTE);
+  WalkSyntaxTree(statement, RUN.format, RUN.profiler, RUN.lines);
+  StatsEndPhase(STATS_PHASE_EXECUTE);
+  return true;
+}
+
+static int Exit(const bool success, const bool print_stats) {
+  if (print_stats) {
+    StatsSetLexTime(PARSER_STATE.lex_time);
+    StatsPrint(stderr);
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[]) {
   bool print_syntax_tree = false;
+  SyntaxTreeFormat format = SYNTAX_TREE_FORMAT_XML;
+  bool use_cache = true;
+  Phase stop_after = PHASE_EXECUTE;
+  bool stream = false;
+  bool repl = false;
+  bool print_stats = false;
+  bool print_alloc_report = false;
+  const char *profile = NULL;
 
   int c;
-  while ((c = getopt_long(argc, argv, "sdht", LONG_OPTIONS, NULL)) != -1) {
+  while ((c = getopt_long(argc, argv, "sf:nS:cirap:dht", LONG_OPTIONS, NULL)) !=
+         -1) {
     switch (c) {
     case 's':
       print_syntax_tree = true;
       break;
 
+    case 'f':
+      if (strcmp(optarg, "xml") == 0) {
+        format = SYNTAX_TREE_FORMAT_XML;
+      } else if (strcmp(optarg, "json") == 0) {
+        format = SYNTAX_TREE_FORMAT_JSON;
+      } else if (strcmp(optarg, "sexp") == 0) {
+        format = SYNTAX_TREE_FORMAT_SEXP;
+      } else {
+        LOG_ERROR("Unknown syntax tree format '%s'", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+
+    case 'n':
+      use_cache = false;
+      break;
+
+    case 'S':
+      if (strcmp(optarg, "lex") == 0) {
+        stop_after = PHASE_LEX;
+      } else if (strcmp(optarg, "parse") == 0) {
+        stop_after = PHASE_PARSE;
+      } else {
+        LOG_ERROR("Unknown phase '%s'", optarg);
+        return EXIT_FAILURE;
+      }
+      use_cache = false;
+      break;
+
+    case 'c':
+      stream = true;
+      use_cache = false;
+      break;
+
+    case 'i':
+      repl = true;
+      break;
+
+    case 'r':
+      print_stats = true;
+      break;
+
+    case 'a':
+      print_alloc_report = true;
+      break;
+
+    case 'p':
+      profile = optarg;
+      break;
+
     case 'd':
       LoggerSetDebug(true);
       break;
@@ -82,17 +360,60 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  const char *filename = "-";
   if (optind >= argc) {
-    LOG_ERROR("Missing argument SOURCE ...");
+    repl = true;
+  } else if (repl) {
+    LOG_ERROR("Option --repl does not take a SOURCE");
     return EXIT_FAILURE;
+  } else {
+    filename = argv[optind++];
   }
-  const char *filename = argv[optind++];
 
-  if (!ParseFile(filename)) {
-    return EXIT_FAILURE;
+  PARSER_STATE.measure_lexer = print_stats;
+  AllocSetTracking((print_stats ? ALLOC_TRACK_TOTALS : 0) |
+                   (print_alloc_report ? ALLOC_TRACK_SITES : 0));
+  if (print_alloc_report) {
+    atexit(PrintAllocReport);
   }
 
-  WalkSyntaxTree(PARSER_STATE.statement, print_syntax_tree);
+  if (stop_after == PHASE_LEX) {
+    StatsBeginPhase(STATS_PHASE_PARSE);
+    const bool success = LexFile(filename);
+    StatsEndPhase(STATS_PHASE_PARSE);
+    return Exit(success, print_stats);
+  }
+
+  if (strcmp(filename, "-") == 0) {
+    use_cache = false;
+  }
+
+  /* Symbols only store byte offsets into the source. Their lines and columns
+   * are only needed when they are printed, and are recorded while parsing. */
+  LineTable lines;
+  LineTableInit(&lines);
+
+  RUN.format = print_syntax_tree ? format : SYNTAX_TREE_FORMAT_NONE;
+  RUN.execute = (stop_after == PHASE_EXECUTE);
+  RUN.profiler = (profile != NULL && RUN.execute) ? ProfilerCreate() : NULL;
+  RUN.lines = (print_syntax_tree || RUN.profiler != NULL) ? &lines : NULL;
+  RUN.count_symbols = print_stats;
+  PARSER_STATE.lines = RUN.lines;
+
+  bool success;
+  if (repl) {
+    success = RunInteractive();
+  } else if (stream) {
+    success = RunStreamed(filename);
+  } else {
+    success = Run(filename, use_cache);
+  }
+  LineTableDeinit(&lines);
+
+  if (RUN.profiler != NULL) {
+    success = success && WriteProfile(RUN.profiler, profile);
+    ProfilerDestroy(RUN.profiler);
+  }
 
-  return EXIT_SUCCESS;
+  return Exit(success, print_stats);
 }
@@ -0,0 +1,154 @@
+#include "stats.h"
+#include "config.h"
+
+#include <assert.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "../parser/serialize.h"
+#include "../utils/alloc.h"
+
+typedef struct {
+  double wall; // Seconds
+  double cpu;  // Seconds
+} StatsTime;
+
+static struct {
+  StatsTime start[NUM_STATS_PHASES];
+  StatsTime phases[NUM_STATS_PHASES];
+  double lex_time;
+  size_t symbols[NUM_SYMBOL_TYPES];
+} STATS;
+
+static const char *const PHASE_NAMES[] = {
+    [STATS_PHASE_LOAD] = "load",
+    [STATS_PHASE_PARSE] = "parse",
+    [STATS_PHASE_EXECUTE] = "execute",
+};
+
+#define NAME(type) [SYMBOL_TYPE_##type] = #type
+
+static const char *const SYMBOL_NAMES[NUM_SYMBOL_TYPES] = {
+    NAME(STATEMENT),
+    NAME(ASSIGNMENT),
+    NAME(VARIABLE),
+    NAME(DECLARATION),
+    NAME(REFERENCE),
+    NAME(MUTABLE),
+    NAME(DATATYPE),
+    NAME(EXPRESSION),
+    NAME(OR),
+    NAME(CONDITION),
+    NAME(AND),
+    NAME(COMPARISON),
+    NAME(LESS_THAN),
+    NAME(GREATER_THAN),
+    NAME(EQUAL),
+    NAME(LESS_EQUAL),
+    NAME(GREATER_EQUAL),
+    NAME(NOT_EQUAL),
+    NAME(TERM),
+    NAME(ADD),
+    NAME(SUBTRACT),
+    NAME(FACTOR),
+    NAME(MULTIPLY),
+    NAME(DIVIDE),
+    NAME(MODULO),
+    NAME(UNARY),
+    NAME(MINUS),
+    NAME(NEGATE),
+    NAME(PRIMARY),
+    NAME(FNCALL),
+    NAME(SUBSCRIPTION),
+    NAME(SLICE),
+    NAME(ATOM),
+    NAME(IDENTIFIER),
+    NAME(INTEGER_LITERAL),
+    NAME(FLOAT_LITERAL),
+    NAME(STRING_LITERAL),
+    NAME(BOOLEAN_LITERAL),
+    NAME(NONE_LITERAL),
+    NAME(DICT),
+    NAME(LIST),
+    NAME(INNER_EXPRESSION),
+};
+
+/****************************************************************************/
+
+static double Seconds(const clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+void StatsBeginPhase(const StatsPhase phase) {
+  assert(phase < NUM_STATS_PHASES);
+  STATS.start[phase].wall = Seconds(CLOCK_MONOTONIC);
+  STATS.start[phase].cpu = Seconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void StatsEndPhase(const StatsPhase phase) {
+  assert(phase < NUM_STATS_PHASES);
+  STATS.phases[phase].wall +=
+      Seconds(CLOCK_MONOTONIC) - STATS.start[phase].wall;
+  STATS.phases[phase].cpu +=
+      Seconds(CLOCK_PROCESS_CPUTIME_ID) - STATS.start[phase].cpu;
+}
+
+void StatsSetLexTime(const double seconds) { STATS.lex_time = seconds; }
+
+void StatsCountSymbols(const SymbolStatement *const statement) {
+  SyntaxTreeCountSymbols(statement, STATS.symbols);
+}
+
+/****************************************************************************/
+
+void StatsPrint(FILE *const stream) {
+  assert(stream != NULL);
+
+  StatsTime total = {0};
+  fprintf(stream, "%-16s %12s %12s\n", "Phase", "Wall (ms)", "CPU (ms)");
+  for (int i = 0; i < NUM_STATS_PHASES; i++) {
+    fprintf(stream, "%-16s %12.3f %12.3f\n", PHASE_NAMES[i],
+            STATS.phases[i].wall * 1e3, STATS.phases[i].cpu * 1e3);
+    total.wall += STATS.phases[i].wall;
+    total.cpu += STATS.phases[i].cpu;
+
+    // The lexer is run by the parser, only its wall time is measured
+    if (i == STATS_PHASE_PARSE) {
+      fprintf(stream, "%-16s %12.3f %12s\n", "  lex", STATS.lex_time * 1e3,
+              "-");
+      fprintf(stream, "%-16s %12.3f %12s\n", "  grammar",
+              (STATS.phases[i].wall - STATS.lex_time) * 1e3, "-");
+    }
+  }
+  fprintf(stream, "%-16s %12.3f %12.3f\n\n", "total", total.wall * 1e3,
+          total.cpu * 1e3);
+
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // Kilobytes on Linux, but bytes on macOS
+#ifdef __APPLE__
+    const long max_rss = usage.ru_maxrss / 1024;
+#else
+    const long max_rss = usage.ru_maxrss;
+#endif
+    fprintf(stream, "Peak RSS: %ld kB\n", max_rss);
+  }
+  AllocStats alloc_stats;
+  AllocGetStats(&alloc_stats);
+  fprintf(stream, "Allocations: %zu calls, %zu bytes\n\n", alloc_stats.calls,
+          alloc_stats.bytes);
+
+  size_t num_symbols = 0;
+  for (int i = 0; i < NUM_SYMBOL_TYPES; i++) {
+    num_symbols += STATS.symbols[i];
+  }
+  fprintf(stream, "%-16s %12s\n", "Symbol", "Count");
+  for (int i = 0; i < NUM_SYMBOL_TYPES; i++) {
+    if (STATS.symbols[i] > 0) {
+      fprintf(stream, "%-16s %12zu\n", SYMBOL_NAMES[i], STATS.symbols[i]);
+    }
+  }
+  fprintf(stream, "%-16s %12zu\n", "total", num_symbols);
+}
@@ -0,0 +1,47 @@
+#ifndef _AETHER_STATS_H
+#define _AETHER_STATS_H
+
+#include <stdio.h>
+
+#include "../parser/syntax.h"
+
+typedef enum {
+  STATS_PHASE_LOAD,    // Reading the source and the syntax tree cache
+  STATS_PHASE_PARSE,   // Lexing and parsing, the lexer is also timed apart
+  STATS_PHASE_EXECUTE, // Walking the syntax tree
+  NUM_STATS_PHASES,
+} StatsPhase;
+
+/**
+ * @brief Start timing a phase.
+ * @param phase The phase.
+ * @note A phase may be timed multiple times, the times are summed up.
+ */
+void StatsBeginPhase(StatsPhase phase);
+
+/**
+ * @brief Stop timing a phase.
+ * @param phase The phase, as passed to StatsBeginPhase().
+ */
+void StatsEndPhase(StatsPhase phase);
+
+/**
+ * @brief Record the wall time spent in the lexer, as part of the parse phase.
+ * @param seconds Wall time in seconds.
+ */
+void StatsSetLexTime(double seconds);
+
+/**
+ * @brief Count the symbols of a syntax tree by type.
+ * @param statement Root of the syntax tree, may be NULL.
+ */
+void StatsCountSymbols(const SymbolStatement *statement);
+
+/**
+ * @brief Print the phase times, the peak resident set size, the allocations
+ *        made through xmalloc() and the symbol counts.
+ * @param stream Stream to print to.
+ */
+void StatsPrint(FILE *stream);
+
+#endif // _AETHER_STATS_H
@@ -2,1204 +2,879 @@
 #include "config.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
+#include "../parser/location.h"
+#include "../utils/alloc.h"
+#include "../utils/buffer.h"
 #include "../utils/logger.h"
+#include "../utils/pool.h"
+#include "profiler.h"
+
+/**
+ * Accumulates the serialized syntax tree in a single buffer, which is handed
+ * to write(2) in large chunks instead of issuing one printf(3) per line.
+ */
+typedef struct Printer {
+  SyntaxTreeFormat format;
+  int depth;         // Number of currently open symbols
+  bool tag_open;     // XML: start tag of innermost symbol is not terminated
+  bool has_children; // JSON: innermost symbol has emitted a child
+  Buffer buffer;
+} Printer;
+
+/* Profiler of the walk in progress, or NULL when not profiling. */
+static Profiler *PROFILER = NULL;
+
+/* Line table of the source of the walk in progress, used to locate symbols
+ * when printing or profiling. */
+static const LineTable *LINES = NULL;
+
+/**
+ * Work left to do by the walk in progress. Instead of recursing into its
+ * children, each symbol pushes them onto this stack, followed by the task of
+ * closing the symbol itself. Hence, the depth of the syntax tree (e.g., a
+ * chain of 50000 additions) is bounded by memory rather than by the C stack.
+ */
+typedef enum TaskType {
+  TASK_WALK,      // Walk the symbol
+  TASK_ARGUMENTS, // Open the arguments of a call, count is their number
+  TASK_ENTRY,     // Open an entry of a dictionary
+  TASK_END,       // Close the symbol called name
+} TaskType;
+
+typedef struct Task {
+  TaskType type;
+  Symbol *symbol;
+  const char *name;
+  size_t count;
+} Task;
+
+static struct {
+  Task *tasks;
+  size_t length;
+  size_t capacity;
+} TASKS = {0};
+
+/****************************************************************************/
+
+static void PrinterFlush(Printer *const printer) {
+  const char *data = BufferData(&printer->buffer);
+  size_t length = BufferLength(&printer->buffer);
+
+  while (length > 0) {
+    const ssize_t ret = write(STDOUT_FILENO, data, length);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_CRITICAL("write(2): Failed to write syntax tree: %s",
+                   strerror(errno));
+    }
+    data += ret;
+    length -= (size_t)ret;
+  }
+
+  BufferClear(&printer->buffer);
+}
+
+static void PrintIndent(Printer *const printer) {
+  static const char SPACES[] = "                                ";
+  size_t n = (size_t)printer->depth * DEFAULT_SYNTAX_TREE_INDENT;
+
+  while (n > 0) {
+    const size_t chunk = (n < sizeof(SPACES) - 1) ? n : sizeof(SPACES) - 1;
+    BufferPrintN(&printer->buffer, SPACES, chunk);
+    n -= chunk;
+  }
+}
+
+static void TerminateStartTag(Printer *const printer) {
+  if (printer->tag_open) {
+    BufferPrint(&printer->buffer, ">\n");
+    printer->tag_open = false;
+  }
+}
+
+static void PrintQuoted(Printer *const printer, const char *const str) {
+  Buffer *const buf = &printer->buffer;
+  BufferAppend(buf, '"');
+
+  const char *run = str;
+  for (const char *ch = str; *ch != '\0'; ch++) {
+    const unsigned char c = (unsigned char)*ch;
+    /* Control characters are escaped in either format, so that a tree is
+     * always printed on a single line. */
+    if (c != '"' && c != '\\' && c >= 0x20) {
+      continue;
+    }
+
+    BufferPrintN(buf, run, (size_t)(ch - run));
+    run = ch + 1;
+
+    if (c == '"' || c == '\\') {
+      BufferAppend(buf, '\\');
+      BufferAppend(buf, (char)c);
+    } else if (c == '\n') {
+      BufferPrint(buf, "\\n");
+    } else if (c == '\t') {
+      BufferPrint(buf, "\\t");
+    } else if (c == '\r') {
+      BufferPrint(buf, "\\r");
+    } else {
+      BufferPrintFormat(buf, "\\u%04x", c);
+    }
+  }
+  BufferPrint(buf, run);
+
+  BufferAppend(buf, '"');
+}
+
+/**
+ * @brief Open a symbol. Symbols must be closed in reverse order using
+ *        EndSymbol().
+ * @param printer Printer, or NULL if nothing is to be printed.
+ * @param name Name of the symbol.
+ * @param symbol The symbol (of any type) to locate, or NULL for symbols that
+ *               only group other symbols.
+ */
+static void BeginSymbol(Printer *const printer, const char *const name,
+                        const void *const symbol) {
+  if (PROFILER == NULL && printer == NULL) {
+    return;
+  }
+
+  SymbolLocation where;
+  const SymbolLocation *location = NULL;
+  if (symbol != NULL) {
+    assert(LINES != NULL);
+    where = LineTableLookup(LINES, ((const Symbol *)symbol)->offset);
+    location = &where;
+  }
+
+  if (PROFILER != NULL) {
+    ProfilerEnter(PROFILER, name, location);
+  }
+  if (printer == NULL) {
+    return;
+  }
+  Buffer *const buf = &printer->buffer;
+
+  switch (printer->format) {
+  case SYNTAX_TREE_FORMAT_XML:
+    TerminateStartTag(printer);
+    PrintIndent(printer);
+    BufferAppend(buf, '<');
+    BufferPrint(buf, name);
+    if (location != NULL) {
+      BufferPrint(buf, " ln=\"");
+      BufferPrintInt(buf, location->line);
+      BufferPrint(buf, "\" col=\"");
+      BufferPrintInt(buf, location->column);
+      BufferAppend(buf, '"');
+    }
+    printer->tag_open = true;
+    break;
+
+  case SYNTAX_TREE_FORMAT_JSON:
+    if (printer->depth > 0) {
+      if (printer->has_children) {
+        BufferAppend(buf, ',');
+      } else {
+        BufferPrint(buf, ",\"children\":[");
+      }
+    }
+    BufferPrint(buf, "{\"type\":\"");
+    BufferPrint(buf, name);
+    BufferAppend(buf, '"');
+    if (location != NULL) {
+      BufferPrint(buf, ",\"ln\":");
+      BufferPrintInt(buf, location->line);
+      BufferPrint(buf, ",\"col\":");
+      BufferPrintInt(buf, location->column);
+    }
+    printer->has_children = false;
+    break;
+
+  case SYNTAX_TREE_FORMAT_SEXP:
+    if (printer->depth > 0) {
+      BufferAppend(buf, ' ');
+    }
+    BufferAppend(buf, '(');
+    BufferPrint(buf, name);
+    if (location != NULL) {
+      BufferPrint(buf, " :ln ");
+      BufferPrintInt(buf, location->line);
+      BufferPrint(buf, " :col ");
+      BufferPrintInt(buf, location->column);
+    }
+    break;
 
-static void WalkSymbolExpression(SymbolExpression *expression, bool print_tree,
-                                 int indent);
-static void WalkSymbolCondition(SymbolCondition *condition, bool print_tree,
-                                int indent);
-static void WalkSymbolComparison(SymbolComparison *comparison, bool print_tree,
-                                 int indent);
-static void WalkSymbolTerm(SymbolTerm *term, bool print_tree, int indent);
-static void WalkSymbolFactor(SymbolFactor *factor, bool print_tree, int indent);
-static void WalkSymbolUnary(SymbolUnary *unary, bool print_tree, int indent);
-static void WalkSymbolPrimary(SymbolPrimary *primary, bool print_tree,
-                              int indent);
-static void WalkSymbolEntries(SymbolEntries *entries, bool print_tree,
-                              int indent);
-static void WalkSymbolElements(SymbolElements *elements, bool print_tree,
-                               int indent);
-
-/****************************************************************************/
-
-static void WalkSymbolIdentifier(SymbolIdentifier *const identifier,
-                                 const bool print_tree, const int indent) {
-  assert(identifier->type == SYMBOL_TYPE_IDENTIFIER);
-
-  if (print_tree) {
-    printf("%*s<IDENTIFIER ln=\"%d\" col=\"%d\">\n", indent, "",
-           identifier->first.line, identifier->first.column);
-    printf("%*s  %s\n", indent, "", identifier->value);
-  }
-
-  free(identifier->value);
-  free(identifier);
-
-  if (print_tree) {
-    printf("%*s</IDENTIFIER>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void
-WalkSymbolIntegerLiteral(SymbolIntegerLiteral *const integer_literal,
-                         const bool print_tree, const int indent) {
-  assert(integer_literal->type == SYMBOL_TYPE_INTEGER_LITERAL);
-
-  if (print_tree) {
-    printf("%*s<INTEGER_LITERAL ln=\"%d\" col=\"%d\">\n", indent, "",
-           integer_literal->first.line, integer_literal->first.line);
-    printf("%*s  %lld\n", indent, "", integer_literal->value);
-  }
-
-  free(integer_literal);
-
-  if (print_tree) {
-    printf("%*s</INTEGER_LITERAL>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolFloatLiteral(SymbolFloatLiteral *const float_literal,
-                                   const bool print_tree, const int indent) {
-  assert(float_literal->type == SYMBOL_TYPE_FLOAT_LITERAL);
-
-  if (print_tree) {
-    printf("%*s<FLOAT_LITERAL ln=\"%d\" col=\"%d\">\n", indent, "",
-           float_literal->first.line, float_literal->first.column);
-    printf("%*s  %lf\n", indent, "", float_literal->value);
-  }
-
-  free(float_literal);
-
-  if (print_tree) {
-    printf("%*s</FLOAT_LITERAL>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolStringLiteral(SymbolStringLiteral *const string_literal,
-                                    const bool print_tree, const int indent) {
-  assert(string_literal->type == SYMBOL_TYPE_STRING_LITERAL);
-
-  if (print_tree) {
-    printf("%*s<STRING_LITERAL ln=\"%d\" col=\"%d\">\n", indent, "",
-           string_literal->first.line, string_literal->first.column);
-    printf("%*s  \"%s\"\n", indent, "", string_literal->value);
-  }
-
-  free(string_literal->value);
-  free(string_literal);
-
-  if (print_tree) {
-    printf("%*s</STRING_LITERAL>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void
-WalkSymbolBooleanLiteral(SymbolBooleanLiteral *const boolean_literal,
-                         const bool print_tree, const int indent) {
-  assert(boolean_literal->type == SYMBOL_TYPE_BOOLEAN_LITERAL);
-
-  if (print_tree) {
-    printf("%*s<BOOLEAN_LITERAL ln=\"%d\" col=\"%d\">\n", indent, "",
-           boolean_literal->first.line, boolean_literal->first.column);
-    printf("%*s  %s\n", indent, "", boolean_literal->value ? "true" : "false");
-  }
-
-  free(boolean_literal);
-
-  if (print_tree) {
-    printf("%*s</BOOLEAN_LITERAL>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolNoneLiteral(SymbolNoneLiteral *const none_literal,
-                                  const bool print_tree, const int indent) {
-  assert(none_literal->type == SYMBOL_TYPE_NONE_LITERAL);
-
-  if (print_tree) {
-    printf("%*s<NONE_LITERAL ln=\"%d\" col=\"%d\">\n", indent, "",
-           none_literal->first.line, none_literal->first.column);
-  }
-
-  free(none_literal);
-
-  if (print_tree) {
-    printf("%*s</NONE_LITERAL>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolDict(SymbolDict *const dict, const bool print_tree,
-                           const int indent) {
-  assert(dict->type == SYMBOL_TYPE_DICT);
-
-  if (print_tree) {
-    printf("%*s<dict ln=\"%d\" col=\"%d\">\n", indent, "", dict->first.line,
-           dict->first.column);
+  default:
+    LOG_CRITICAL("Unexpected syntax tree format %d", printer->format);
   }
 
-  WalkSymbolEntries(dict->entries, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(dict);
-
-  if (print_tree) {
-    printf("%*s<dict>\n", indent, "");
-  }
+  printer->depth += 1;
 }
 
-/****************************************************************************/
-
-static void WalkSymbolEntries(SymbolEntries *const entries,
-                              const bool print_tree, const int indent) {
-  assert(entries->type == SYMBOL_TYPE_ENTRIES);
-
-  if (print_tree) {
-    printf("%*s<entries ln=\"%d\" col=\"%d\">\n", indent, "",
-           entries->first.line, entries->first.column);
+/**
+ * @brief Close the symbol most recently opened by BeginSymbol().
+ * @param printer Printer, or NULL if nothing is to be printed.
+ * @param name Name of the symbol.
+ */
+static void EndSymbol(Printer *const printer, const char *const name) {
+  if (PROFILER != NULL) {
+    ProfilerLeave(PROFILER);
   }
-
-  if (entries->entries != NULL) {
-    WalkSymbolEntries(entries->entries, print_tree,
-                      indent + DEFAULT_SYNTAX_TREE_INDENT);
+  if (printer == NULL) {
+    return;
   }
+  Buffer *const buf = &printer->buffer;
 
-  WalkSymbolStringLiteral(entries->string_literal, print_tree,
-                          indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolExpression(entries->expression, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(entries);
+  assert(printer->depth > 0);
+  printer->depth -= 1;
 
-  if (print_tree) {
-    printf("%*s<entries>\n", indent, "");
-  }
-}
+  switch (printer->format) {
+  case SYNTAX_TREE_FORMAT_XML:
+    TerminateStartTag(printer);
+    PrintIndent(printer);
+    BufferPrint(buf, "</");
+    BufferPrint(buf, name);
+    BufferPrint(buf, ">\n");
+    break;
 
-/****************************************************************************/
+  case SYNTAX_TREE_FORMAT_JSON:
+    if (printer->has_children) {
+      BufferAppend(buf, ']');
+    }
+    BufferAppend(buf, '}');
+    printer->has_children = true;
+    break;
 
-static void WalkSymbolList(SymbolList *const list, const bool print_tree,
-                           const int indent) {
-  assert(list->type == SYMBOL_TYPE_LIST);
+  case SYNTAX_TREE_FORMAT_SEXP:
+    BufferAppend(buf, ')');
+    break;
 
-  if (print_tree) {
-    printf("%*s<list ln=\"%d\" col=\"%d\">\n", indent, "", list->first.line,
-           list->first.column);
+  default:
+    LOG_CRITICAL("Unexpected syntax tree format %d", printer->format);
   }
 
-  if (list->elements != NULL) {
-    WalkSymbolElements(list->elements, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+  if (printer->depth == 0 && printer->format != SYNTAX_TREE_FORMAT_XML) {
+    BufferAppend(buf, '\n');
   }
 
-  free(list);
-
-  if (print_tree) {
-    printf("%*s</list>\n", indent, "");
+  if (BufferLength(buf) >= DEFAULT_SYNTAX_TREE_FLUSH_SIZE) {
+    PrinterFlush(printer);
   }
 }
 
-static void WalkSymbolElements(SymbolElements *const elements,
-                               const bool print_tree, const int indent) {
-  assert(elements->type == SYMBOL_TYPE_ELEMENTS);
-
-  if (print_tree) {
-    printf("%*s<elements ln=\"%d\" col=\"%d\">\n", indent, "",
-           elements->first.line, elements->first.column);
+/**
+ * @brief Print an attribute of the symbol most recently opened by
+ *        BeginSymbol(). Must be called before any value or child symbol.
+ */
+static void PrintAttribute(Printer *const printer, const char *const key,
+                           const char *const value) {
+  if (printer == NULL) {
+    return;
   }
+  Buffer *const buf = &printer->buffer;
 
-  if (elements->elements != NULL) {
-    WalkSymbolElements(elements->elements, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-  }
+  switch (printer->format) {
+  case SYNTAX_TREE_FORMAT_XML:
+    assert(printer->tag_open);
+    BufferAppend(buf, ' ');
+    BufferPrint(buf, key);
+    BufferPrint(buf, "=\"");
+    BufferPrint(buf, value);
+    BufferAppend(buf, '"');
+    break;
 
-  WalkSymbolExpression(elements->expression, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYNTAX_TREE_FORMAT_JSON:
+    BufferPrint(buf, ",\"");
+    BufferPrint(buf, key);
+    BufferPrint(buf, "\":");
+    BufferPrint(buf, value);
+    break;
 
-  free(elements);
+  case SYNTAX_TREE_FORMAT_SEXP:
+    BufferPrint(buf, " :");
+    BufferPrint(buf, key);
+    BufferAppend(buf, ' ');
+    BufferPrint(buf, value);
+    break;
 
-  if (print_tree) {
-    printf("%*s</elements>\n", indent, "");
+  default:
+    LOG_CRITICAL("Unexpected syntax tree format %d", printer->format);
   }
 }
 
-/****************************************************************************/
-
-static void WalkSymbolAtom(SymbolAtom *const atom, const bool print_tree,
-                           const int indent) {
-  assert(atom->type == SYMBOL_TYPE_ATOM);
-
-  if (print_tree) {
-    printf("%*s<atom ln=\"%d\" col=\"%d\">\n", indent, "", atom->first.line,
-           atom->first.column);
-  }
-
-  switch (atom->symbol->type) {
-  case SYMBOL_TYPE_IDENTIFIER:
-    WalkSymbolIdentifier((SymbolIdentifier *)atom->symbol, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_INTEGER_LITERAL:
-    WalkSymbolIntegerLiteral((SymbolIntegerLiteral *)atom->symbol, print_tree,
-                             indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_FLOAT_LITERAL:
-    WalkSymbolFloatLiteral((SymbolFloatLiteral *)atom->symbol, print_tree,
-                           indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_STRING_LITERAL:
-    WalkSymbolStringLiteral((SymbolStringLiteral *)atom->symbol, print_tree,
-                            indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void BeginValue(Printer *const printer) {
+  switch (printer->format) {
+  case SYNTAX_TREE_FORMAT_XML:
+    TerminateStartTag(printer);
+    PrintIndent(printer);
     break;
-  case SYMBOL_TYPE_BOOLEAN_LITERAL:
-    WalkSymbolBooleanLiteral((SymbolBooleanLiteral *)atom->symbol, print_tree,
-                             indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYNTAX_TREE_FORMAT_JSON:
+    BufferPrint(&printer->buffer, ",\"value\":");
     break;
-  case SYMBOL_TYPE_NONE_LITERAL:
-    WalkSymbolNoneLiteral((SymbolNoneLiteral *)atom->symbol, print_tree,
-                          indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_DICT:
-    WalkSymbolDict((SymbolDict *)atom->symbol, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_LIST:
-    WalkSymbolList((SymbolList *)atom->symbol, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_EXPRESSION:
-    WalkSymbolExpression((SymbolExpression *)atom->symbol, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYNTAX_TREE_FORMAT_SEXP:
+    BufferAppend(&printer->buffer, ' ');
     break;
   default:
-    LOG_CRITICAL("Unexpected symbol type %d", atom->symbol->type);
-  }
-
-  free(atom);
-
-  if (print_tree) {
-    printf("%*s</atom>\n", indent, "");
+    LOG_CRITICAL("Unexpected syntax tree format %d", printer->format);
   }
 }
 
-/****************************************************************************/
-
-static void WalkSymbolArguments(SymbolArguments *const arguments,
-                                const bool print_tree, const int indent) {
-  assert(arguments->type == SYMBOL_TYPE_ARGUMENTS);
-
-  if (print_tree) {
-    printf("%*s<arguments ln=\"%d\" col=\"%d\">\n", indent, "",
-           arguments->first.line, arguments->first.column);
-  }
-
-  if (arguments->arguments != NULL) {
-    WalkSymbolArguments(arguments->arguments, print_tree,
-                        indent + DEFAULT_SYNTAX_TREE_INDENT);
-  }
-
-  WalkSymbolExpression(arguments->expression, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(arguments);
-
-  if (print_tree) {
-    printf("%*s</arguments>\n", indent, "");
+static void EndValue(Printer *const printer) {
+  if (printer->format == SYNTAX_TREE_FORMAT_XML) {
+    BufferAppend(&printer->buffer, '\n');
   }
 }
 
-/****************************************************************************/
-
-static void WalkSymbolFncall(SymbolFncall *const fncall, const bool print_tree,
-                             const int indent) {
-  assert(fncall->type == SYMBOL_TYPE_FNCALL);
-
-  if (print_tree) {
-    printf("%*s<fncall ln=\"%d\" col=\"%d\">\n", indent, "", fncall->first.line,
-           fncall->first.column);
-  }
-
-  WalkSymbolPrimary(fncall->primary, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  if (fncall->arguments != NULL) {
-    WalkSymbolArguments(fncall->arguments, print_tree,
-                        indent + DEFAULT_SYNTAX_TREE_INDENT);
+/**
+ * @brief Print the name of an identifier as the value of the symbol most
+ *        recently opened by BeginSymbol().
+ */
+static void PrintName(Printer *const printer, const char *const name) {
+  if (printer == NULL) {
+    return;
   }
-
-  free(fncall);
-
-  if (print_tree) {
-    printf("%*s</fncall>\n", indent, "");
+  BeginValue(printer);
+  if (printer->format == SYNTAX_TREE_FORMAT_JSON) {
+    PrintQuoted(printer, name);
+  } else {
+    BufferPrint(&printer->buffer, name);
   }
+  EndValue(printer);
 }
 
-/****************************************************************************/
-
-static void WalkSymbolSubscription(SymbolSubscription *const subscription,
-                                   const bool print_tree, const int indent) {
-  assert(subscription->type == SYMBOL_TYPE_SUBSCRIPTION);
-
-  if (print_tree) {
-    printf("%*s<subscription ln=\"%d\" col=\"%d\">\n", indent, "",
-           subscription->first.line, subscription->first.column);
+static void PrintString(Printer *const printer, const char *const value) {
+  if (printer == NULL) {
+    return;
   }
-
-  WalkSymbolPrimary(subscription->primary, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolExpression(subscription->expression, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(subscription);
-
-  if (print_tree) {
-    printf("%*s</subscription>\n", indent, "");
+  BeginValue(printer);
+  if (printer->format == SYNTAX_TREE_FORMAT_XML) {
+    BufferAppend(&printer->buffer, '"');
+    BufferPrint(&printer->buffer, value);
+    BufferAppend(&printer->buffer, '"');
+  } else {
+    PrintQuoted(printer, value);
   }
+  EndValue(printer);
 }
 
-/****************************************************************************/
-
-static void WalkSymbolSlice(SymbolSlice *const slice, const bool print_tree,
-                            const int indent) {
-  assert(slice->type == SYMBOL_TYPE_SLICE);
-
-  if (print_tree) {
-    printf("%*s<slice ln=\"%d\" col=\"%d\" left_expression=\"%s\" "
-           "right_expression=\"%s\">\n",
-           indent, "", slice->first.line, slice->first.column,
-           (slice->left_expression != NULL) ? "true" : "false",
-           (slice->right_expression != NULL) ? "true" : "false");
-  }
-
-  WalkSymbolPrimary(slice->primary, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  if (slice->left_expression != NULL) {
-    WalkSymbolExpression(slice->left_expression, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void PrintInteger(Printer *const printer,
+                         const unsigned long long value) {
+  if (printer == NULL) {
+    return;
   }
+  BeginValue(printer);
+  BufferPrintUInt(&printer->buffer, value);
+  EndValue(printer);
+}
 
-  if (slice->right_expression != NULL) {
-    WalkSymbolExpression(slice->right_expression, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void PrintFloat(Printer *const printer, const double value) {
+  if (printer == NULL) {
+    return;
   }
+  BeginValue(printer);
+  BufferPrintFloat(&printer->buffer, value);
+  EndValue(printer);
+}
 
-  free(slice);
-
-  if (print_tree) {
-    printf("%*s</slice>\n", indent, "");
+static void PrintBoolean(Printer *const printer, const bool value) {
+  if (printer == NULL) {
+    return;
   }
+  BeginValue(printer);
+  BufferPrint(&printer->buffer, value ? "true" : "false");
+  EndValue(printer);
 }
 
 /****************************************************************************/
 
-static void WalkSymbolPrimary(SymbolPrimary *const primary,
-                              const bool print_tree, const int indent) {
-  assert(primary->type == SYMBOL_TYPE_PRIMARY);
-
-  if (print_tree) {
-    printf("%*s<primary ln=\"%d\" col=\"%d\">\n", indent, "",
-           primary->first.line, primary->first.column);
-  }
-
-  switch (primary->symbol->type) {
-  case SYMBOL_TYPE_ATOM:
-    WalkSymbolAtom((SymbolAtom *)primary->symbol, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_FNCALL:
-    WalkSymbolFncall((SymbolFncall *)primary->symbol, print_tree,
-                     indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_SUBSCRIPTION:
-    WalkSymbolSubscription((SymbolSubscription *)primary->symbol, print_tree,
-                           indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_SLICE:
-    WalkSymbolSlice((SymbolSlice *)primary->symbol, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", primary->symbol->type);
+static void PushTask(const Task task) {
+  if (TASKS.length >= TASKS.capacity) {
+    TASKS.capacity =
+        (TASKS.capacity > 0) ? TASKS.capacity * 2 : DEFAULT_LIST_CAPACITY;
+    TASKS.tasks = xrealloc(TASKS.tasks, TASKS.capacity * sizeof(Task));
   }
+  TASKS.tasks[TASKS.length++] = task;
+}
 
-  free(primary);
+/**
+ * @brief Walk a symbol once the tasks pushed after it are done. Since the
+ *        stack is last in, first out, children must be pushed in reverse.
+ */
+static void PushWalk(void *const symbol) {
+  assert(symbol != NULL);
+  PushTask((Task){.type = TASK_WALK, .symbol = (Symbol *)symbol});
+}
 
-  if (print_tree) {
-    printf("%*s</primary>\n", indent, "");
-  }
+/**
+ * @brief Close a symbol opened by BeginSymbol() once the tasks pushed after
+ *        it, i.e., its children, are done.
+ */
+static void PushEnd(const char *const name) {
+  PushTask((Task){.type = TASK_END, .name = name});
 }
 
 /****************************************************************************/
 
-static void WalkSymbolMinus(SymbolMinus *const minus, const bool print_tree,
-                            const int indent) {
-  assert(minus->type == SYMBOL_TYPE_MINUS);
-
-  if (print_tree) {
-    printf("%*s<minus ln=\"%d\" col=\"%d\">\n", indent, "", minus->first.line,
-           minus->first.column);
-  }
+static void WalkSymbolIdentifier(SymbolIdentifier *const identifier,
+                                 Printer *const printer) {
+  assert(identifier->type == SYMBOL_TYPE_IDENTIFIER);
 
-  WalkSymbolUnary(minus->unary, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
+  BeginSymbol(printer, "IDENTIFIER", identifier);
+  PrintName(printer, identifier->value);
 
-  free(minus);
+  xfree(identifier->value);
+  PoolFree(identifier, sizeof(*identifier));
 
-  if (print_tree) {
-    printf("%*s</minus>\n", indent, "");
-  }
+  EndSymbol(printer, "IDENTIFIER");
 }
 
 /****************************************************************************/
 
-static void WalkSymbolNegate(SymbolNegate *const negate, const bool print_tree,
-                             const int indent) {
-  assert(negate->type == SYMBOL_TYPE_NEGATE);
-
-  if (print_tree) {
-    printf("%*s<negate ln=\"%d\" col=\"%d\">\n", indent, "", negate->first.line,
-           negate->first.column);
-  }
+static void
+WalkSymbolIntegerLiteral(SymbolIntegerLiteral *const integer_literal,
+                         Printer *const printer) {
+  assert(integer_literal->type == SYMBOL_TYPE_INTEGER_LITERAL);
 
-  WalkSymbolUnary(negate->unary, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
+  BeginSymbol(printer, "INTEGER_LITERAL", integer_literal);
+  PrintInteger(printer, integer_literal->value);
 
-  free(negate);
+  PoolFree(integer_literal, sizeof(*integer_literal));
 
-  if (print_tree) {
-    printf("%*s</negate>\n", indent, "");
-  }
+  EndSymbol(printer, "INTEGER_LITERAL");
 }
 
 /****************************************************************************/
 
-static void WalkSymbolUnary(SymbolUnary *const unary, const bool print_tree,
-                            const int indent) {
-  assert(unary->type == SYMBOL_TYPE_UNARY);
-
-  if (print_tree) {
-    printf("%*s<unary ln=\"%d\" col=\"%d\">\n", indent, "", unary->first.line,
-           unary->first.column);
-  }
+static void WalkSymbolFloatLiteral(SymbolFloatLiteral *const float_literal,
+                                   Printer *const printer) {
+  assert(float_literal->type == SYMBOL_TYPE_FLOAT_LITERAL);
 
-  switch (unary->symbol->type) {
-  case SYMBOL_TYPE_PRIMARY:
-    WalkSymbolPrimary((SymbolPrimary *)unary->symbol, print_tree,
-                      indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_MINUS:
-    WalkSymbolMinus((SymbolMinus *)unary->symbol, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_NEGATE:
-    WalkSymbolNegate((SymbolNegate *)unary->symbol, print_tree,
-                     indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", unary->symbol->type);
-  }
+  BeginSymbol(printer, "FLOAT_LITERAL", float_literal);
+  PrintFloat(printer, float_literal->value);
 
-  free(unary);
+  PoolFree(float_literal, sizeof(*float_literal));
 
-  if (print_tree) {
-    printf("%*s</unary>\n", indent, "");
-  }
+  EndSymbol(printer, "FLOAT_LITERAL");
 }
 
 /****************************************************************************/
 
-static void WalkSymbolMultiply(SymbolMultiply *const multiply,
-                               const bool print_tree, const int indent) {
-  assert(multiply->type == SYMBOL_TYPE_MULTIPLY);
-
-  if (print_tree) {
-    printf("%*s<multiply ln=\"%d\" col=\"%d\">\n", indent, "",
-           multiply->first.line, multiply->first.column);
-  }
-
-  WalkSymbolFactor(multiply->factor, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void WalkSymbolStringLiteral(SymbolStringLiteral *const string_literal,
+                                    Printer *const printer) {
+  assert(string_literal->type == SYMBOL_TYPE_STRING_LITERAL);
 
-  WalkSymbolUnary(multiply->unary, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
+  BeginSymbol(printer, "STRING_LITERAL", string_literal);
+  PrintString(printer, string_literal->value);
 
-  free(multiply);
+  xfree(string_literal->value);
+  PoolFree(string_literal, sizeof(*string_literal));
 
-  if (print_tree) {
-    printf("%*s</multiply>\n", indent, "");
-  }
+  EndSymbol(printer, "STRING_LITERAL");
 }
 
 /****************************************************************************/
 
-static void WalkSymbolDivide(SymbolDivide *const divide, const bool print_tree,
-                             const int indent) {
-  assert(divide->type == SYMBOL_TYPE_DIVIDE);
-
-  if (print_tree) {
-    printf("%*s<divide ln=\"%d\" col=\"%d\">\n", indent, "", divide->first.line,
-           divide->first.column);
-  }
-
-  WalkSymbolFactor(divide->factor, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void
+WalkSymbolBooleanLiteral(SymbolBooleanLiteral *const boolean_literal,
+                         Printer *const printer) {
+  assert(boolean_literal->type == SYMBOL_TYPE_BOOLEAN_LITERAL);
 
-  WalkSymbolUnary(divide->unary, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
+  BeginSymbol(printer, "BOOLEAN_LITERAL", boolean_literal);
+  PrintBoolean(printer, boolean_literal->value);
 
-  free(divide);
+  PoolFree(boolean_literal, sizeof(*boolean_literal));
 
-  if (print_tree) {
-    printf("%*s</divide>\n", indent, "");
-  }
+  EndSymbol(printer, "BOOLEAN_LITERAL");
 }
 
 /****************************************************************************/
 
-static void WalkSymbolModulo(SymbolModulo *const modulo, const bool print_tree,
-                             const int indent) {
-  assert(modulo->type == SYMBOL_TYPE_MODULO);
-
-  if (print_tree) {
-    printf("%*s<modulo ln=\"%d\" col=\"%d\">\n", indent, "", modulo->first.line,
-           modulo->first.column);
-  }
-
-  WalkSymbolFactor(modulo->factor, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void WalkSymbolNoneLiteral(SymbolNoneLiteral *const none_literal,
+                                  Printer *const printer) {
+  assert(none_literal->type == SYMBOL_TYPE_NONE_LITERAL);
 
-  WalkSymbolUnary(modulo->unary, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
+  BeginSymbol(printer, "NONE_LITERAL", none_literal);
 
-  free(modulo);
+  PoolFree(none_literal, sizeof(*none_literal));
 
-  if (print_tree) {
-    printf("%*s</modulo>\n", indent, "");
-  }
+  EndSymbol(printer, "NONE_LITERAL");
 }
 
 /****************************************************************************/
 
-static void WalkSymbolFactor(SymbolFactor *const factor, const bool print_tree,
-                             const int indent) {
-  assert(factor->type == SYMBOL_TYPE_FACTOR);
+static void WalkSymbolDict(SymbolDict *const dict, Printer *const printer) {
+  assert(dict->type == SYMBOL_TYPE_DICT);
 
-  if (print_tree) {
-    printf("%*s<factor ln=\"%d\" col=\"%d\">\n", indent, "", factor->first.line,
-           factor->first.column);
-  }
+  BeginSymbol(printer, "dict", dict);
+  PushEnd("dict");
 
-  switch (factor->symbol->type) {
-  case SYMBOL_TYPE_UNARY:
-    WalkSymbolUnary((SymbolUnary *)factor->symbol, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_MULTIPLY:
-    WalkSymbolMultiply((SymbolMultiply *)factor->symbol, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_DIVIDE:
-    WalkSymbolDivide((SymbolDivide *)factor->symbol, print_tree,
-                     indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_MODULO:
-    WalkSymbolModulo((SymbolModulo *)factor->symbol, print_tree,
-                     indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", factor->symbol->type);
+  for (size_t i = dict->num_entries; i > 0; i--) {
+    PushEnd("entry");
+    PushWalk(dict->values[i - 1]);
+    PushWalk(dict->keys[i - 1]);
+    PushTask((Task){.type = TASK_ENTRY});
   }
 
-  free(factor);
-
-  if (print_tree) {
-    printf("%*s</factor>\n", indent, "");
-  }
+  xfree(dict->keys);
+  xfree(dict->values);
+  PoolFree(dict, sizeof(*dict));
 }
 
 /****************************************************************************/
 
-static void WalkSymbolAdd(SymbolAdd *const add, const bool print_tree,
-                          const int indent) {
-  assert(add->type == SYMBOL_TYPE_ADD);
-
-  if (print_tree) {
-    printf("%*s<add ln=\"%d\" col=\"%d\">\n", indent, "", add->first.line,
-           add->first.column);
-  }
-
-  WalkSymbolTerm(add->term, print_tree, indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolFactor(add->factor, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void WalkSymbolList(SymbolList *const list, Printer *const printer) {
+  assert(list->type == SYMBOL_TYPE_LIST);
 
-  free(add);
+  BeginSymbol(printer, "list", list);
+  PushEnd("list");
 
-  if (print_tree) {
-    printf("%*s</add>\n", indent, "");
+  for (size_t i = list->num_elements; i > 0; i--) {
+    PushWalk(list->elements[i - 1]);
   }
+
+  xfree(list->elements);
+  PoolFree(list, sizeof(*list));
 }
 
 /****************************************************************************/
 
-static void WalkSymbolSubtract(SymbolSubtract *const subtract,
-                               const bool print_tree, const int indent) {
-  assert(subtract->type == SYMBOL_TYPE_SUBTRACT);
-
-  if (print_tree) {
-    printf("%*s<subtract ln=\"%d\" col=\"%d\">\n", indent, "",
-           subtract->first.line, subtract->first.column);
+/**
+ * @brief Get the name of the function called, if it is called by name.
+ */
+static const char *GetFunctionName(const SymbolFncall *const fncall) {
+  const Symbol *symbol = fncall->primary->symbol;
+  if (symbol->type != SYMBOL_TYPE_ATOM) {
+    return NULL;
   }
-
-  WalkSymbolTerm(subtract->term, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolFactor(subtract->factor, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  if (print_tree) {
-    printf("%*s</subtract>\n", indent, "");
+  symbol = ((const SymbolAtom *)symbol)->symbol;
+  if (symbol->type != SYMBOL_TYPE_IDENTIFIER) {
+    return NULL;
   }
+  return ((const SymbolIdentifier *)symbol)->value;
 }
 
-/****************************************************************************/
-
-static void WalkSymbolTerm(SymbolTerm *const term, const bool print_tree,
-                           const int indent) {
-  assert(term->type == SYMBOL_TYPE_TERM);
+static void WalkSymbolFncall(SymbolFncall *const fncall,
+                             Printer *const printer) {
+  assert(fncall->type == SYMBOL_TYPE_FNCALL);
 
-  if (print_tree) {
-    printf("%*s<term ln=\"%d\" col=\"%d\">\n", indent, "", term->first.line,
-           term->first.column);
+  BeginSymbol(printer, "fncall", fncall);
+  if (PROFILER != NULL) {
+    const char *const function = GetFunctionName(fncall);
+    if (function != NULL) {
+      ProfilerSetFunction(PROFILER, function);
+    }
   }
+  PushEnd("fncall");
 
-  switch (term->symbol->type) {
-  case SYMBOL_TYPE_FACTOR:
-    WalkSymbolFactor((SymbolFactor *)term->symbol, print_tree,
-                     indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_ADD:
-    WalkSymbolAdd((SymbolAdd *)term->symbol, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_SUBTRACT:
-    WalkSymbolSubtract((SymbolSubtract *)term->symbol, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", term->symbol->type);
+  PushEnd("arguments");
+  for (size_t i = fncall->num_arguments; i > 0; i--) {
+    PushWalk(fncall->arguments[i - 1]);
   }
+  PushTask((Task){.type = TASK_ARGUMENTS, .count = fncall->num_arguments});
 
-  free(term);
+  PushWalk(fncall->primary);
 
-  if (print_tree) {
-    printf("%*s</term>\n", indent, "");
-  }
+  xfree(fncall->arguments);
+  PoolFree(fncall, sizeof(*fncall));
 }
 
-/****************************************************************************/
-
-static void WalkSymbolLessThan(SymbolLessThan *const less_than,
-                               const bool print_tree, const int indent) {
-  assert(less_than->type == SYMBOL_TYPE_LESS_THAN);
-
-  if (print_tree) {
-    printf("%*s<less_than ln=\"%d\" col=\"%d\">\n", indent, "",
-           less_than->first.line, less_than->first.column);
-  }
-
-  WalkSymbolComparison(less_than->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolTerm(less_than->term, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(less_than);
-
-  if (print_tree) {
-    printf("%*s</less_than>\n", indent, "");
+static void BeginArguments(Printer *const printer, const size_t count) {
+  BeginSymbol(printer, "arguments", NULL);
+  if (printer != NULL) {
+    char str[32];
+    const int ret = snprintf(str, sizeof(str), "%zu", count);
+    assert(ret >= 0 && (size_t)ret < sizeof(str));
+    PrintAttribute(printer, "count", str);
   }
 }
 
 /****************************************************************************/
 
-static void WalkSymbolGreaterThan(SymbolGreaterThan *const greater_than,
-                                  const bool print_tree, const int indent) {
-  assert(greater_than->type == SYMBOL_TYPE_GREATER_THAN);
-
-  if (print_tree) {
-    printf("%*s<greater_than ln=\"%d\" col=\"%d\">\n", indent, "",
-           greater_than->first.line, greater_than->first.column);
-  }
-
-  WalkSymbolComparison(greater_than->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolTerm(greater_than->term, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void WalkSymbolSlice(SymbolSlice *const slice, Printer *const printer) {
+  assert(slice->type == SYMBOL_TYPE_SLICE);
 
-  free(greater_than);
+  BeginSymbol(printer, "slice", slice);
+  PrintAttribute(printer, "left_expression",
+                 (slice->left_expression != NULL) ? "true" : "false");
+  PrintAttribute(printer, "right_expression",
+                 (slice->right_expression != NULL) ? "true" : "false");
+  PushEnd("slice");
 
-  if (print_tree) {
-    printf("%*s</greater_than>\n", indent, "");
+  if (slice->right_expression != NULL) {
+    PushWalk(slice->right_expression);
   }
-}
-
-/****************************************************************************/
 
-static void WalkSymbolEqual(SymbolEqual *const equal, const int indent,
-                            const bool print_tree) {
-  assert(equal->type == SYMBOL_TYPE_EQUAL);
-
-  if (print_tree) {
-    printf("%*s<equal ln=\"%d\" col=\"%d\">\n", indent, "", equal->first.line,
-           equal->first.column);
+  if (slice->left_expression != NULL) {
+    PushWalk(slice->left_expression);
   }
 
-  WalkSymbolComparison(equal->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolTerm(equal->term, print_tree, indent + DEFAULT_SYNTAX_TREE_INDENT);
+  PushWalk(slice->primary);
 
-  free(equal);
-
-  if (print_tree) {
-    printf("%*s</equal>\n", indent, "");
-  }
+  PoolFree(slice, sizeof(*slice));
 }
 
 /****************************************************************************/
 
-static void WalkSymbolLessEqual(SymbolLessEqual *const less_equal,
-                                const bool print_tree, const int indent) {
-  assert(less_equal->type == SYMBOL_TYPE_LESS_EQUAL);
-
-  if (print_tree) {
-    printf("%*s<less_equal ln=\"%d\" col=\"%d\">\n", indent, "",
-           less_equal->first.line, less_equal->first.column);
-  }
-
-  WalkSymbolComparison(less_equal->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+static void WalkSymbolDeclaration(SymbolDeclaration *const declaration,
+                                  Printer *const printer) {
+  assert(declaration->type == SYMBOL_TYPE_DECLARATION);
 
-  WalkSymbolTerm(less_equal->term, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
+  BeginSymbol(printer, "declaration", declaration);
+  PushEnd("declaration");
 
-  free(less_equal);
+  PushWalk(declaration->identifier);
+  PushWalk(declaration->symbol);
 
-  if (print_tree) {
-    printf("%*s</less_equal>\n", indent, "");
-  }
+  PoolFree(declaration, sizeof(*declaration));
 }
 
 /****************************************************************************/
 
-static void WalkSymbolGreaterEqual(SymbolGreaterEqual *const greater_equal,
-                                   const bool print_tree, const int indent) {
-  assert(greater_equal->type == SYMBOL_TYPE_GREATER_EQUAL);
+/**
+ * @brief Walk a symbol with a single child, e.g., an expression.
+ */
+static void WalkSymbolWithChild(Symbol *const symbol, const char *const name,
+                                Symbol *const child, const size_t size,
+                                Printer *const printer) {
+  BeginSymbol(printer, name, symbol);
+  PushEnd(name);
 
-  if (print_tree) {
-    printf("%*s<greater_equal ln=\"%d\" col=\"%d\">\n", indent, "",
-           greater_equal->first.line, greater_equal->first.column);
-  }
-
-  WalkSymbolComparison(greater_equal->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolTerm(greater_equal->term, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(greater_equal);
+  PushWalk(child);
 
-  if (print_tree) {
-    printf("%*s</greater_equal>\n", indent, "");
-  }
+  PoolFree(symbol, size);
 }
 
-/****************************************************************************/
-
-static void WalkSymbolNotEqual(SymbolNotEqual *const not_equal,
-                               const bool print_tree, const int indent) {
-  assert(not_equal->type == SYMBOL_TYPE_NOT_EQUAL);
+/**
+ * @brief Walk a symbol with two children, e.g., a binary operator.
+ */
+static void WalkSymbolWithChildren(Symbol *const symbol,
+                                   const char *const name, Symbol *const left,
+                                   Symbol *const right, const size_t size,
+                                   Printer *const printer) {
+  BeginSymbol(printer, name, symbol);
+  PushEnd(name);
 
-  if (print_tree) {
-    printf("%*s<not_equal ln=\"%d\" col=\"%d\">\n", indent, "",
-           not_equal->first.line, not_equal->first.column);
-  }
-
-  WalkSymbolComparison(not_equal->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolTerm(not_equal->term, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(not_equal);
+  PushWalk(right);
+  PushWalk(left);
 
-  if (print_tree) {
-    printf("%*s</not_equal>\n", indent, "");
-  }
+  PoolFree(symbol, size);
 }
 
-/****************************************************************************/
-
-static void WalkSymbolComparison(SymbolComparison *const comparison,
-                                 const bool print_tree, const int indent) {
-  assert(comparison->type == SYMBOL_TYPE_COMPARISON);
+#define WALK_CHILD(T, name, child)                                             \
+  WalkSymbolWithChild(symbol, (name), (Symbol *)((T *)symbol)->child,          \
+                      sizeof(T), printer)
 
-  if (print_tree) {
-    printf("%*s<comparison ln=\"%d\" col=\"%d\">\n", indent, "",
-           comparison->first.line, comparison->first.column);
-  }
+#define WALK_CHILDREN(T, name, left, right)                                    \
+  WalkSymbolWithChildren(symbol, (name), (Symbol *)((T *)symbol)->left,        \
+                         (Symbol *)((T *)symbol)->right, sizeof(T), printer)
 
-  switch (comparison->symbol->type) {
-  case SYMBOL_TYPE_TERM:
-    WalkSymbolTerm((SymbolTerm *)comparison->symbol, print_tree,
-                   indent + DEFAULT_SYNTAX_TREE_INDENT);
+/**
+ * @brief Walk any symbol, see the TASKS stack.
+ */
+static void WalkSymbol(Symbol *const symbol, Printer *const printer) {
+  switch (symbol->type) {
+  case SYMBOL_TYPE_STATEMENT:
+    WALK_CHILD(SymbolStatement, "statement", symbol);
+    break;
+  case SYMBOL_TYPE_ASSIGNMENT:
+    WALK_CHILDREN(SymbolAssignment, "assignment", symbol, expression);
+    break;
+  case SYMBOL_TYPE_DECLARATION:
+    WalkSymbolDeclaration((SymbolDeclaration *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_REFERENCE:
+    WALK_CHILD(SymbolReference, "reference", symbol);
+    break;
+  case SYMBOL_TYPE_MUTABLE:
+    WALK_CHILD(SymbolMutable, "mutable", datatype);
+    break;
+  case SYMBOL_TYPE_DATATYPE:
+    WALK_CHILD(SymbolDatatype, "datatype", identifier);
+    break;
+  case SYMBOL_TYPE_EXPRESSION:
+    WALK_CHILD(SymbolExpression, "expression", symbol);
+    break;
+  case SYMBOL_TYPE_OR:
+    WALK_CHILDREN(SymbolOr, "or", expression, condition);
+    break;
+  case SYMBOL_TYPE_CONDITION:
+    WALK_CHILD(SymbolCondition, "condition", symbol);
+    break;
+  case SYMBOL_TYPE_AND:
+    WALK_CHILDREN(SymbolAnd, "and", condition, comparison);
+    break;
+  case SYMBOL_TYPE_COMPARISON:
+    WALK_CHILD(SymbolComparison, "comparison", symbol);
     break;
   case SYMBOL_TYPE_LESS_THAN:
-    WalkSymbolLessThan((SymbolLessThan *)comparison->symbol, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+    WALK_CHILDREN(SymbolLessThan, "less_than", comparison, term);
     break;
   case SYMBOL_TYPE_GREATER_THAN:
-    WalkSymbolGreaterThan((SymbolGreaterThan *)comparison->symbol, print_tree,
-                          indent + DEFAULT_SYNTAX_TREE_INDENT);
+    WALK_CHILDREN(SymbolGreaterThan, "greater_than", comparison, term);
     break;
   case SYMBOL_TYPE_EQUAL:
-    WalkSymbolEqual((SymbolEqual *)comparison->symbol, print_tree,
-                    indent + DEFAULT_SYNTAX_TREE_INDENT);
+    WALK_CHILDREN(SymbolEqual, "equal", comparison, term);
     break;
   case SYMBOL_TYPE_LESS_EQUAL:
-    WalkSymbolLessEqual((SymbolLessEqual *)comparison->symbol, print_tree,
-                        indent + DEFAULT_SYNTAX_TREE_INDENT);
+    WALK_CHILDREN(SymbolLessEqual, "less_equal", comparison, term);
     break;
   case SYMBOL_TYPE_GREATER_EQUAL:
-    WalkSymbolGreaterEqual((SymbolGreaterEqual *)comparison->symbol, print_tree,
-                           indent + DEFAULT_SYNTAX_TREE_INDENT);
+    WALK_CHILDREN(SymbolGreaterEqual, "greater_equal", comparison, term);
     break;
   case SYMBOL_TYPE_NOT_EQUAL:
-    WalkSymbolNotEqual((SymbolNotEqual *)comparison->symbol, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+    WALK_CHILDREN(SymbolNotEqual, "not_equal", comparison, term);
     break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", comparison->symbol->type);
-  }
-
-  free(comparison);
-
-  if (print_tree) {
-    printf("%*s</comparison>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolAnd(SymbolAnd *const and, const bool print_tree,
-                          const int indent) {
-  assert(and->type == SYMBOL_TYPE_AND);
-
-  if (print_tree) {
-    printf("%*s<and ln=\"%d\" col=\"%d\">\n", indent,
-           "", and->first.line, and->first.column);
-  }
-
-  WalkSymbolCondition(and->condition, print_tree,
-                      indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolComparison(and->comparison, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(and);
-
-  if (print_tree) {
-    printf("%*s</and>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolCondition(SymbolCondition *const condition,
-                                const bool print_tree, const int indent) {
-  assert(condition->type == SYMBOL_TYPE_CONDITION);
-
-  if (print_tree) {
-    printf("%*s<condition ln=\"%d\" col=\"%d\">\n", indent, "",
-           condition->first.line, condition->first.column);
-  }
-
-  switch (condition->symbol->type) {
-  case SYMBOL_TYPE_COMPARISON:
-    WalkSymbolComparison((SymbolComparison *)condition->symbol, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_TERM:
+    WALK_CHILD(SymbolTerm, "term", symbol);
     break;
-  case SYMBOL_TYPE_AND:
-    WalkSymbolAnd((SymbolAnd *)condition->symbol, print_tree,
-                  indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_ADD:
+    WALK_CHILDREN(SymbolAdd, "add", term, factor);
     break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", condition->symbol->type);
-  }
-
-  free(condition);
-
-  if (print_tree) {
-    printf("%*s</condition>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolOr(SymbolOr *const or, const bool print_tree,
-                         const int indent) {
-  assert(or->type == SYMBOL_TYPE_OR);
-
-  if (print_tree) {
-    printf("%*s</or ln=\"%d\" col=\"%d\">\n", indent, "", or->first.line,
-           or->first.column);
-  }
-
-  WalkSymbolExpression(or->expression, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  WalkSymbolCondition(or->condition, print_tree,
-                      indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(or);
-
-  if (print_tree) {
-    printf("%*s</or>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolExpression(SymbolExpression *const expression,
-                                 const bool print_tree, const int indent) {
-  assert(expression->type == SYMBOL_TYPE_EXPRESSION);
-
-  if (print_tree) {
-    printf("%*s<expression ln=\"%d\" col=\"%d\">\n", indent, "",
-           expression->first.line, expression->first.column);
-  }
-
-  switch (expression->symbol->type) {
-  case SYMBOL_TYPE_CONDITION:
-    WalkSymbolCondition((SymbolCondition *)expression->symbol, print_tree,
-                        indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_SUBTRACT:
+    WALK_CHILDREN(SymbolSubtract, "subtract", term, factor);
     break;
-  case SYMBOL_TYPE_OR:
-    WalkSymbolOr((SymbolOr *)expression->symbol, print_tree,
-                 indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_FACTOR:
+    WALK_CHILD(SymbolFactor, "factor", symbol);
     break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", expression->symbol->type);
-  }
-
-  free(expression);
-
-  if (print_tree) {
-    printf("%*s</expression>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolDatatype(SymbolDatatype *const datatype,
-                               const bool print_tree, const int indent) {
-  assert(datatype->type == SYMBOL_TYPE_DATATYPE);
-
-  if (print_tree) {
-    printf("%*s<datatype ln=\"%d\" col=\"%d\">\n", indent, "",
-           datatype->first.line, datatype->first.column);
-  }
-
-  WalkSymbolIdentifier(datatype->identifier, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(datatype);
-
-  if (print_tree) {
-    printf("%*s</datatype>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolMutable(SymbolMutable *const mutable,
-                              const bool print_tree, const int indent) {
-  assert(mutable->type == SYMBOL_TYPE_MUTABLE);
-
-  if (print_tree) {
-    printf("%*s<mutable ln=\"%d\" col=\"%d\">\n", indent, "",
-           mutable->first.line, mutable->first.column);
-  }
-
-  WalkSymbolDatatype(mutable->datatype, print_tree,
-                     indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(mutable);
-
-  if (print_tree) {
-    printf("%*s</mutable>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolReference(SymbolReference *const reference,
-                                const bool print_tree, const int indent) {
-  assert(reference->type == SYMBOL_TYPE_REFERENCE);
-
-  if (print_tree) {
-    printf("%*s<reference ln=\"%d\" col=\"%d\">\n", indent, "",
-           reference->first.line, reference->first.column);
-  }
-
-  switch (reference->symbol->type) {
-  case SYMBOL_TYPE_DATATYPE:
-    WalkSymbolDatatype((SymbolDatatype *)reference->symbol, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_MULTIPLY:
+    WALK_CHILDREN(SymbolMultiply, "multiply", factor, unary);
     break;
-  case SYMBOL_TYPE_MUTABLE:
-    WalkSymbolMutable((SymbolMutable *)reference->symbol, print_tree,
-                      indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_DIVIDE:
+    WALK_CHILDREN(SymbolDivide, "divide", factor, unary);
     break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", reference->symbol->type);
-  }
-
-  free(reference);
-
-  if (print_tree) {
-    printf("%*s</reference>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolDeclaration(SymbolDeclaration *const declaration,
-                                  const bool print_tree, const int indent) {
-  assert(declaration->type == SYMBOL_TYPE_DECLARATION);
-
-  if (print_tree) {
-    printf("%*s<declaration ln=\"%d\" col=\"%d\">\n", indent, "",
-           declaration->first.line, declaration->first.column);
-  }
-
-  switch (declaration->symbol->type) {
-  case SYMBOL_TYPE_REFERENCE:
-    WalkSymbolReference((SymbolReference *)declaration->symbol, print_tree,
-                        indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_MODULO:
+    WALK_CHILDREN(SymbolModulo, "modulo", factor, unary);
     break;
-  case SYMBOL_TYPE_MUTABLE:
-    WalkSymbolMutable((SymbolMutable *)declaration->symbol, print_tree,
-                      indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_UNARY:
+    WALK_CHILD(SymbolUnary, "unary", symbol);
     break;
-  case SYMBOL_TYPE_DATATYPE:
-    WalkSymbolDatatype((SymbolDatatype *)declaration->symbol, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_MINUS:
+    WALK_CHILD(SymbolMinus, "minus", unary);
     break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", declaration->symbol->type);
-  }
-
-  WalkSymbolIdentifier(declaration->identifier, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
-
-  free(declaration);
-
-  if (print_tree) {
-    printf("%*s</declaration>\n", indent, "");
-  }
-}
-
-/****************************************************************************/
-
-static void WalkSymbolAssignment(SymbolAssignment *const assignment,
-                                 const bool print_tree, const int indent) {
-  assert(assignment->type == SYMBOL_TYPE_ASSIGNMENT);
-
-  if (print_tree) {
-    printf("%*s<assignment ln=\"%d\" col=\"%d\">\n", indent, "",
-           assignment->first.line, assignment->first.column);
-  }
-
-  switch (assignment->symbol->type) {
-  case SYMBOL_TYPE_EXPRESSION:
-    WalkSymbolExpression((SymbolExpression *)assignment->symbol, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_NEGATE:
+    WALK_CHILD(SymbolNegate, "negate", unary);
     break;
-  case SYMBOL_TYPE_DECLARATION:
-    WalkSymbolDeclaration((SymbolDeclaration *)assignment->symbol, print_tree,
-                          indent + DEFAULT_SYNTAX_TREE_INDENT);
+  case SYMBOL_TYPE_PRIMARY:
+    WALK_CHILD(SymbolPrimary, "primary", symbol);
+    break;
+  case SYMBOL_TYPE_FNCALL:
+    WalkSymbolFncall((SymbolFncall *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_SUBSCRIPTION:
+    WALK_CHILDREN(SymbolSubscription, "subscription", primary, expression);
+    break;
+  case SYMBOL_TYPE_SLICE:
+    WalkSymbolSlice((SymbolSlice *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_ATOM:
+    WALK_CHILD(SymbolAtom, "atom", symbol);
+    break;
+  case SYMBOL_TYPE_IDENTIFIER:
+    WalkSymbolIdentifier((SymbolIdentifier *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_INTEGER_LITERAL:
+    WalkSymbolIntegerLiteral((SymbolIntegerLiteral *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_FLOAT_LITERAL:
+    WalkSymbolFloatLiteral((SymbolFloatLiteral *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_STRING_LITERAL:
+    WalkSymbolStringLiteral((SymbolStringLiteral *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_BOOLEAN_LITERAL:
+    WalkSymbolBooleanLiteral((SymbolBooleanLiteral *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_NONE_LITERAL:
+    WalkSymbolNoneLiteral((SymbolNoneLiteral *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_DICT:
+    WalkSymbolDict((SymbolDict *)symbol, printer);
+    break;
+  case SYMBOL_TYPE_LIST:
+    WalkSymbolList((SymbolList *)symbol, printer);
     break;
   default:
-    LOG_CRITICAL("Unexpected symbol type %d", assignment->symbol->type);
+    LOG_CRITICAL("Unexpected symbol type %d", symbol->type);
   }
+}
 
-  WalkSymbolExpression(assignment->expression, print_tree,
-                       indent + DEFAULT_SYNTAX_TREE_INDENT);
+#undef WALK_CHILD
+#undef WALK_CHILDREN
 
-  free(assignment);
+/**
+ * @brief Walk a syntax tree, or any subtree, by running tasks until the
+ *        stack is empty.
+ */
+static void Walk(Symbol *const root, Printer *const printer) {
+  assert(TASKS.length == 0);
+  PushWalk(root);
 
-  if (print_tree) {
-    printf("%*s</assignment>\n", indent, "");
+  while (TASKS.length > 0) {
+    const Task task = TASKS.tasks[--TASKS.length];
+    switch (task.type) {
+    case TASK_WALK:
+      WalkSymbol(task.symbol, printer);
+      break;
+    case TASK_ARGUMENTS:
+      BeginArguments(printer, task.count);
+      break;
+    case TASK_ENTRY:
+      BeginSymbol(printer, "entry", NULL);
+      break;
+    case TASK_END:
+      EndSymbol(printer, task.name);
+      break;
+    }
   }
+
+  /* The stack is as large as the widest list or the deepest chain of the
+   * tree, which is not worth keeping around between statements. */
+  xfree(TASKS.tasks);
+  TASKS.tasks = NULL;
+  TASKS.capacity = 0;
 }
 
 /****************************************************************************/
 
-static void WalkSymbolStatement(SymbolStatement *const statement,
-                                const bool print_tree, const int indent) {
-  assert(statement->type == SYMBOL_TYPE_STATEMENT);
-
-  if (print_tree) {
-    printf("%*s<statement ln=\"%d\" col=\"%d\">\n", indent, "",
-           statement->first.line, statement->first.column);
+void WalkSyntaxTree(SymbolStatement *const statement,
+                    const SyntaxTreeFormat format, Profiler *const profiler,
+                    const LineTable *const lines) {
+  if (statement == NULL) {
+    return;
   }
 
-  switch (statement->symbol->type) {
-  case SYMBOL_TYPE_ASSIGNMENT:
-    WalkSymbolAssignment((SymbolAssignment *)statement->symbol, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_DECLARATION:
-    WalkSymbolDeclaration((SymbolDeclaration *)statement->symbol, print_tree,
-                          indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  case SYMBOL_TYPE_EXPRESSION:
-    WalkSymbolExpression((SymbolExpression *)statement->symbol, print_tree,
-                         indent + DEFAULT_SYNTAX_TREE_INDENT);
-    break;
-  default:
-    LOG_CRITICAL("Unexpected symbol type %d", statement->symbol->type);
+  PROFILER = profiler;
+  LINES = lines;
+
+  if (format == SYNTAX_TREE_FORMAT_NONE) {
+    Walk((Symbol *)statement, NULL);
+    PROFILER = NULL;
+    LINES = NULL;
+    return;
   }
 
-  free(statement);
+  Printer printer = {
+      .format = format,
+  };
+  BufferInit(&printer.buffer);
 
-  if (print_tree) {
-    printf("%*s</statement>\n", indent, "");
-  }
-}
+  // Anything already printed through stdio must precede the syntax tree
+  fflush(stdout);
 
-/****************************************************************************/
+  Walk((Symbol *)statement, &printer);
+  assert(printer.depth == 0);
+  PROFILER = NULL;
+  LINES = NULL;
 
-void WalkSyntaxTree(SymbolStatement *const statement, const bool print_tree) {
-  if (statement != NULL) {
-    WalkSymbolStatement(statement, print_tree, 0);
-  }
+  PrinterFlush(&printer);
+  BufferDeinit(&printer.buffer);
 }
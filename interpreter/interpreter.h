@@ -3,8 +3,27 @@
 
 #include <stdbool.h>
 
+#include "../parser/location.h"
 #include "../parser/syntax.h"
+#include "profiler.h"
 
-void WalkSyntaxTree(SymbolStatement *statement, bool print_tree);
+typedef enum SyntaxTreeFormat {
+  SYNTAX_TREE_FORMAT_NONE,
+  SYNTAX_TREE_FORMAT_XML,
+  SYNTAX_TREE_FORMAT_JSON,
+  SYNTAX_TREE_FORMAT_SEXP,
+} SyntaxTreeFormat;
+
+/**
+ * @brief Walk the syntax tree, freeing each symbol as it is visited.
+ * @param statement Root of the syntax tree, may be NULL.
+ * @param format Format in which the syntax tree is printed to stdout, or
+ *               SYNTAX_TREE_FORMAT_NONE to print nothing.
+ * @param profiler Profiler to record the walk with, or NULL.
+ * @param lines Line table of the source, used to locate symbols. May only be
+ *              NULL if nothing is printed and there is no profiler.
+ */
+void WalkSyntaxTree(SymbolStatement *statement, SyntaxTreeFormat format,
+                    Profiler *profiler, const LineTable *lines);
 
 #endif // _AETHER_INTERPRETER_H
@@ -0,0 +1,214 @@
+#include "profiler.h"
+#include "config.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils/alloc.h"
+#include "../utils/buffer.h"
+#include "../utils/dict.h"
+#include "../utils/string_lib.h"
+
+/* A node per distinct stack, with node 0 as the root of all stacks. */
+typedef struct {
+  size_t parent;
+  char *name;    // Name of the innermost frame
+  uint64_t self; // Nanoseconds
+} Node;
+
+typedef struct {
+  size_t node;
+  SymbolLocation location;
+  bool has_location;
+  uint64_t start;    // Nanoseconds
+  uint64_t children; // Nanoseconds spent in nested frames
+} Frame;
+
+struct Profiler {
+  Node *nodes;
+  size_t num_nodes;
+  size_t nodes_capacity;
+  Dict *index; // Node ids by "<parent id>;<frame name>"
+  Frame *frames;
+  size_t depth; // Number of entered frames
+  size_t frames_capacity;
+  Buffer key; // Scratch space for index keys
+};
+
+static uint64_t Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+Profiler *ProfilerCreate(void) {
+  Profiler *const profiler = xmalloc(sizeof(Profiler));
+
+  profiler->nodes_capacity = 64;
+  profiler->nodes = xmalloc(profiler->nodes_capacity * sizeof(Node));
+  profiler->nodes[0] = (Node){.parent = 0, .name = NULL, .self = 0};
+  profiler->num_nodes = 1;
+  profiler->index = DictCreate();
+
+  profiler->frames_capacity = 64;
+  profiler->frames = xmalloc(profiler->frames_capacity * sizeof(Frame));
+  profiler->depth = 0;
+
+  BufferInit(&profiler->key);
+  return profiler;
+}
+
+/****************************************************************************/
+
+/**
+ * @brief Find or create the node of a frame within the stack of its parent.
+ */
+static size_t GetNode(Profiler *const profiler, const size_t parent,
+                      const char *const name, const char *const suffix,
+                      const SymbolLocation *const location) {
+  Buffer *const key = &profiler->key;
+  BufferClear(key);
+  BufferPrintUInt(key, parent);
+  BufferAppend(key, ';');
+  const size_t offset = BufferLength(key);
+  BufferPrint(key, name);
+  BufferPrint(key, suffix);
+  if (location != NULL) {
+    BufferAppend(key, '@');
+    BufferPrintInt(key, location->line);
+    BufferAppend(key, ':');
+    BufferPrintInt(key, location->column);
+  }
+
+  // The key is hashed once, whether the node is found or created
+  const char *const data = BufferData(key);
+  const uint64_t hash = DictHashKey(data);
+  const void *value;
+  if (DictGetHashed(profiler->index, data, hash, &value)) {
+    return (size_t)(uintptr_t)value;
+  }
+
+  if (profiler->num_nodes == profiler->nodes_capacity) {
+    profiler->nodes_capacity *= 2;
+    profiler->nodes =
+        xrealloc(profiler->nodes, profiler->nodes_capacity * sizeof(Node));
+  }
+  const size_t id = profiler->num_nodes++;
+  profiler->nodes[id] = (Node){
+      .parent = parent,
+      .name = StringDuplicate(data + offset),
+      .self = 0,
+  };
+  DictSetHashed(profiler->index, data, hash, (void *)(uintptr_t)id, NULL);
+  return id;
+}
+
+void ProfilerEnter(Profiler *const profiler, const char *const name,
+                   const SymbolLocation *const location) {
+  assert(profiler != NULL);
+  assert(name != NULL);
+
+  if (profiler->depth == profiler->frames_capacity) {
+    profiler->frames_capacity *= 2;
+    profiler->frames =
+        xrealloc(profiler->frames, profiler->frames_capacity * sizeof(Frame));
+  }
+
+  const size_t parent =
+      (profiler->depth > 0) ? profiler->frames[profiler->depth - 1].node : 0;
+  Frame *const frame = &profiler->frames[profiler->depth++];
+  frame->has_location = (location != NULL);
+  if (location != NULL) {
+    frame->location = *location;
+  }
+  frame->node = (profiler->depth <= DEFAULT_PROFILER_MAX_DEPTH)
+                    ? GetNode(profiler, parent, name, "", location)
+                    : parent;
+  frame->children = 0;
+
+  // Last, so that the bookkeeping above is not part of the frame
+  frame->start = Now();
+}
+
+void ProfilerSetFunction(Profiler *const profiler, const char *const function) {
+  assert(profiler != NULL);
+  assert(profiler->depth > 0);
+  assert(function != NULL);
+
+  if (profiler->depth > DEFAULT_PROFILER_MAX_DEPTH) {
+    return;
+  }
+
+  Frame *const frame = &profiler->frames[profiler->depth - 1];
+  const size_t parent = profiler->nodes[frame->node].parent;
+  frame->node = GetNode(profiler, parent, function, "()",
+                        frame->has_location ? &frame->location : NULL);
+}
+
+void ProfilerLeave(Profiler *const profiler) {
+  const uint64_t end = Now();
+
+  assert(profiler != NULL);
+  assert(profiler->depth > 0);
+
+  const Frame *const frame = &profiler->frames[--profiler->depth];
+  const uint64_t elapsed = end - frame->start;
+  const uint64_t self =
+      (elapsed > frame->children) ? elapsed - frame->children : 0;
+  profiler->nodes[frame->node].self += self;
+
+  if (profiler->depth > 0) {
+    profiler->frames[profiler->depth - 1].children += elapsed;
+  }
+}
+
+/****************************************************************************/
+
+static void GetStack(const Profiler *const profiler, const size_t node,
+                     Buffer *const stack) {
+  const size_t parent = profiler->nodes[node].parent;
+  if (parent != 0) {
+    GetStack(profiler, parent, stack);
+    BufferAppend(stack, ';');
+  }
+  BufferPrint(stack, profiler->nodes[node].name);
+}
+
+bool ProfilerWrite(const Profiler *const profiler, FILE *const stream) {
+  assert(profiler != NULL);
+  assert(stream != NULL);
+
+  Buffer stack;
+  BufferInit(&stack);
+
+  bool success = true;
+  for (size_t i = 1; success && i < profiler->num_nodes; i++) {
+    const uint64_t self = profiler->nodes[i].self;
+    if (self == 0) {
+      continue;
+    }
+
+    BufferClear(&stack);
+    GetStack(profiler, i, &stack);
+    success =
+        fprintf(stream, "%s %" PRIu64 "\n", BufferData(&stack), self) >= 0;
+  }
+
+  BufferDeinit(&stack);
+  return success && fflush(stream) == 0;
+}
+
+void ProfilerDestroy(Profiler *const profiler) {
+  if (profiler != NULL) {
+    for (size_t i = 1; i < profiler->num_nodes; i++) {
+      xfree(profiler->nodes[i].name);
+    }
+    xfree(profiler->nodes);
+    DictDestroy(profiler->index);
+    xfree(profiler->frames);
+    BufferDeinit(&profiler->key);
+    xfree(profiler);
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef _AETHER_PROFILER_H
+#define _AETHER_PROFILER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../parser/syntax.h"
+
+/**
+ * Attributes the time spent walking the syntax tree to stacks of symbols.
+ * Each frame is named after a symbol and its source location, e.g.,
+ * "add@3:7", and function calls are named after the function they call,
+ * e.g., "foo()@3:1". The self time of each stack is reported in folded stack
+ * format, as consumed by flame graph tools.
+ */
+typedef struct Profiler Profiler;
+
+/**
+ * @brief Create a profiler.
+ * @return Profiler.
+ * @note Caller takes ownership of returned value.
+ */
+Profiler *ProfilerCreate(void);
+
+/**
+ * @brief Enter a frame. Frames must be left in reverse order using
+ *        ProfilerLeave().
+ * @param profiler The profiler.
+ * @param name Name of the symbol.
+ * @param location Location of the symbol, or NULL for symbols that only group
+ *                 other symbols.
+ * @note Frames nested deeper than DEFAULT_PROFILER_MAX_DEPTH are attributed
+ *       to their deepest recorded ancestor.
+ */
+void ProfilerEnter(Profiler *profiler, const char *name,
+                   const SymbolLocation *location);
+
+/**
+ * @brief Name the innermost frame after the function it calls.
+ * @param profiler The profiler.
+ * @param function Name of the function.
+ */
+void ProfilerSetFunction(Profiler *profiler, const char *function);
+
+/**
+ * @brief Leave the innermost frame, attributing the time spent in it, minus
+ *        the time spent in nested frames, to its stack.
+ * @param profiler The profiler.
+ */
+void ProfilerLeave(Profiler *profiler);
+
+/**
+ * @brief Write the profile in folded stack format, i.e., one line per stack
+ *        with frames separated by semicolons, followed by a space and the
+ *        self time in nanoseconds.
+ * @param profiler The profiler.
+ * @param stream Stream to write to.
+ * @return False on write error, in which case errno is set.
+ */
+bool ProfilerWrite(const Profiler *profiler, FILE *stream);
+
+/**
+ * @brief Destroy a profiler.
+ * @param profiler The profiler.
+ * @note If profiler is NULL, no operation is performed.
+ */
+void ProfilerDestroy(Profiler *profiler);
+
+#endif // _AETHER_PROFILER_H
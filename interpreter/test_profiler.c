@@ -0,0 +1,105 @@
+#include "../tests/check.h"
+#include "profiler.c"
+
+#include <time.h>
+
+static void Sleep(void) {
+  const struct timespec ts = {.tv_sec = 0, .tv_nsec = 1000000};
+  check(nanosleep(&ts, NULL) == 0);
+}
+
+static uint64_t GetSelfTime(const Profiler *const profiler,
+                            const char *const expected) {
+  Buffer stack;
+  BufferInit(&stack);
+  for (size_t i = 1; i < profiler->num_nodes; i++) {
+    BufferClear(&stack);
+    GetStack(profiler, i, &stack);
+    if (strcmp(BufferData(&stack), expected) == 0) {
+      BufferDeinit(&stack);
+      return profiler->nodes[i].self;
+    }
+  }
+  check(false);
+  return 0;
+}
+
+static void test_ProfilerEnter(void) {
+  Profiler *const profiler = ProfilerCreate();
+  const SymbolLocation location = {.line = 3, .column = 7};
+
+  for (int i = 0; i < 2; i++) {
+    ProfilerEnter(profiler, "statement", &location);
+    Sleep();
+    ProfilerEnter(profiler, "fncall", &location);
+    ProfilerSetFunction(profiler, "foo");
+    Sleep();
+    ProfilerEnter(profiler, "arguments", NULL);
+    Sleep();
+    ProfilerLeave(profiler);
+    ProfilerLeave(profiler);
+    ProfilerLeave(profiler);
+  }
+  check(profiler->depth == 0);
+
+  // Self time is summed up per stack, excluding nested frames
+  check(GetSelfTime(profiler, "statement@3:7;fncall@3:7") == 0);
+  check(GetSelfTime(profiler, "statement@3:7") >= 2000000);
+  check(GetSelfTime(profiler, "statement@3:7;foo()@3:7") >= 2000000);
+  check(GetSelfTime(profiler, "statement@3:7;foo()@3:7;arguments") >=
+        2000000);
+
+  ProfilerDestroy(profiler);
+}
+
+static void test_ProfilerMaxDepth(void) {
+  Profiler *const profiler = ProfilerCreate();
+
+  for (int i = 0; i < DEFAULT_PROFILER_MAX_DEPTH + 10; i++) {
+    ProfilerEnter(profiler, "x", NULL);
+  }
+  ProfilerSetFunction(profiler, "foo");
+  for (int i = 0; i < DEFAULT_PROFILER_MAX_DEPTH + 10; i++) {
+    ProfilerLeave(profiler);
+  }
+
+  // The frames beyond the maximum depth are merged into their ancestor
+  check(profiler->num_nodes == DEFAULT_PROFILER_MAX_DEPTH + 1);
+  check(profiler->depth == 0);
+
+  ProfilerDestroy(profiler);
+}
+
+static void test_ProfilerWrite(void) {
+  Profiler *const profiler = ProfilerCreate();
+  const SymbolLocation location = {.line = 1, .column = 1};
+
+  ProfilerEnter(profiler, "statement", &location);
+  ProfilerEnter(profiler, "list", &location);
+  Sleep();
+  ProfilerLeave(profiler);
+  ProfilerLeave(profiler);
+
+  FILE *const stream = tmpfile();
+  check(stream != NULL);
+  check(ProfilerWrite(profiler, stream));
+  rewind(stream);
+
+  char line[256];
+  unsigned long long self;
+  check(fgets(line, sizeof(line), stream) != NULL);
+  check(sscanf(line, "statement@1:1 %llu\n", &self) == 1);
+  check(fgets(line, sizeof(line), stream) != NULL);
+  check(sscanf(line, "statement@1:1;list@1:1 %llu\n", &self) == 1);
+  check(self >= 1000000);
+  check(fgets(line, sizeof(line), stream) == NULL);
+
+  fclose(stream);
+  ProfilerDestroy(profiler);
+}
+
+CHECK_BEGIN
+CHECK_ADD("ProfilerEnter", test_ProfilerEnter)
+CHECK_ADD("ProfilerMaxDepth", test_ProfilerMaxDepth)
+CHECK_ADD("ProfilerWrite", test_ProfilerWrite)
+CHECK_END
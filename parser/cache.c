@@ -0,0 +1,286 @@
+#include "cache.h"
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../utils/alloc.h"
+#include "../utils/buffer.h"
+#include "../utils/hash.h"
+#include "../utils/logger.h"
+#include "../utils/string_lib.h"
+#include "serialize.h"
+
+#define CACHE_MAGIC "AETHERC"
+#define CACHE_VERSION 3
+
+/* Cache entries are shared between runs, so they cannot use the random
+ * per-process seed of HashBytes(). */
+#define CACHE_KEY_0 0x6165746865722d63ULL
+#define CACHE_KEY_1 0x616368652d6b6579ULL
+
+/* A cache file is this header, followed by the absolute path of the source
+ * (without terminating null-byte) and the serialized syntax tree. */
+typedef struct {
+  char magic[sizeof(CACHE_MAGIC)];
+  uint32_t version;
+  uint32_t header_size; // Detects hosts with different type sizes
+  uint64_t source_size;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+  uint64_t source_hash;
+  uint64_t path_length;
+  uint64_t tree_length;
+  uint64_t tree_hash;
+} CacheHeader;
+
+struct CacheEntry {
+  char *path;       // Absolute path of the source
+  char *cache_path; // Path of the cache file
+  CacheHeader header;
+};
+
+/****************************************************************************/
+
+static char *GetCacheDirectory(void) {
+  const char *const xdg = getenv("XDG_CACHE_HOME");
+  if (xdg != NULL && xdg[0] == '/') {
+    if (mkdir(xdg, 0700) != 0 && errno != EEXIST) {
+      LOG_DEBUG("mkdir(2): Failed to create directory '%s': %s", xdg,
+                strerror(errno));
+      return NULL;
+    }
+    return StringFormat("%s/aether", xdg);
+  }
+
+  const char *const home = getenv("HOME");
+  if (home == NULL || home[0] != '/') {
+    return NULL;
+  }
+
+  char *const parent = StringFormat("%s/.cache", home);
+  if (mkdir(parent, 0700) != 0 && errno != EEXIST) {
+    LOG_DEBUG("mkdir(2): Failed to create directory '%s': %s", parent,
+              strerror(errno));
+    xfree(parent);
+    return NULL;
+  }
+  char *const directory = StringFormat("%s/aether", parent);
+  xfree(parent);
+  return directory;
+}
+
+CacheEntry *CacheOpen(const char *const filename) {
+  assert(filename != NULL);
+
+  struct stat sb;
+  if (stat(filename, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+    return NULL;
+  }
+
+  char *const path = realpath(filename, NULL);
+  if (path == NULL) {
+    return NULL;
+  }
+
+  char *const directory = GetCacheDirectory();
+  if (directory == NULL) {
+    free(path);
+    return NULL;
+  }
+  if (mkdir(directory, 0700) != 0 && errno != EEXIST) {
+    LOG_DEBUG("mkdir(2): Failed to create directory '%s': %s", directory,
+              strerror(errno));
+    xfree(directory);
+    free(path);
+    return NULL;
+  }
+
+  Buffer source;
+  BufferInit(&source);
+  if (!BufferReadFile(&source, filename)) {
+    BufferDeinit(&source);
+    xfree(directory);
+    free(path);
+    return NULL;
+  }
+
+  CacheEntry *const entry = xmalloc(sizeof(CacheEntry));
+
+  const size_t path_length = strlen(path);
+  const uint64_t key =
+      HashBytesKeyed(path, path_length, CACHE_KEY_0, CACHE_KEY_1);
+  entry->path = path;
+  entry->cache_path =
+      StringFormat("%s/%016llx.ast", directory, (unsigned long long)key);
+  xfree(directory);
+
+  CacheHeader *const header = &entry->header;
+  memset(header, 0, sizeof(CacheHeader));
+  memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header->version = CACHE_VERSION;
+  header->header_size = sizeof(CacheHeader);
+  header->source_size = (uint64_t)sb.st_size;
+  header->source_mtime_sec = (int64_t)sb.st_mtim.tv_sec;
+  header->source_mtime_nsec = (int64_t)sb.st_mtim.tv_nsec;
+  header->source_hash =
+      HashBytesKeyed(BufferData(&source), BufferLength(&source), CACHE_KEY_0,
+                     CACHE_KEY_1);
+  header->path_length = path_length;
+
+  /* The file may have changed between stat(2) and reading it. The size and
+   * hash are then inconsistent, which ensures the entry never hits. */
+  if (BufferLength(&source) != (size_t)sb.st_size) {
+    header->source_size = UINT64_MAX;
+  }
+  BufferDeinit(&source);
+
+  return entry;
+}
+
+/****************************************************************************/
+
+bool CacheLoad(const CacheEntry *const entry,
+               SymbolStatement **const statement) {
+  assert(entry != NULL);
+  assert(statement != NULL);
+
+  const int fd = open(entry->cache_path, O_RDONLY);
+  if (fd < 0) {
+    LOG_DEBUG("Cache miss for '%s': %s", entry->path, strerror(errno));
+    return false;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(CacheHeader)) {
+    LOG_DEBUG("Cache miss for '%s': Truncated cache file", entry->path);
+    close(fd);
+    return false;
+  }
+
+  const size_t size = (size_t)sb.st_size;
+  void *const data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_DEBUG("mmap(2): Failed to map cache file '%s': %s", entry->cache_path,
+              strerror(errno));
+    return false;
+  }
+
+  CacheHeader header;
+  memcpy(&header, data, sizeof(CacheHeader));
+  const size_t path_length = entry->header.path_length;
+  const char *const path = (const char *)data + sizeof(CacheHeader);
+  const char *const tree = path + path_length;
+  const uint64_t tree_length = header.tree_length;
+  const uint64_t tree_hash = header.tree_hash;
+
+  /* Apart from the tree, the header must describe the source exactly as it
+   * looks right now. Those fields are zero in the header of the entry. */
+  header.tree_length = 0;
+  header.tree_hash = 0;
+  bool hit = (memcmp(&header, &entry->header, sizeof(CacheHeader)) == 0) &&
+             (size - sizeof(CacheHeader) >= path_length) &&
+             (size - sizeof(CacheHeader) - path_length == tree_length) &&
+             (memcmp(path, entry->path, path_length) == 0);
+
+  if (!hit) {
+    LOG_DEBUG("Cache miss for '%s': Stale cache file", entry->path);
+  } else if (HashBytesKeyed(tree, (size_t)tree_length, CACHE_KEY_0,
+                            CACHE_KEY_1) != tree_hash) {
+    LOG_DEBUG("Cache miss for '%s': Corrupt cache file", entry->path);
+    hit = false;
+  } else if (!SyntaxTreeDeserialize(tree, (size_t)tree_length, statement)) {
+    LOG_DEBUG("Cache miss for '%s': Malformed cache file", entry->path);
+    hit = false;
+  } else {
+    LOG_DEBUG("Cache hit for '%s'", entry->path);
+  }
+
+  munmap(data, size);
+  return hit;
+}
+
+/****************************************************************************/
+
+static bool WriteAll(const int fd, const void *const data, size_t length) {
+  const char *ptr = (const char *)data;
+  while (length > 0) {
+    const ssize_t ret = write(fd, ptr, length);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    ptr += ret;
+    length -= (size_t)ret;
+  }
+  return true;
+}
+
+void CacheStore(const CacheEntry *const entry,
+                const SymbolStatement *const statement) {
+  assert(entry != NULL);
+
+  Buffer tree;
+  BufferInit(&tree);
+  SyntaxTreeSerialize(&tree, statement);
+
+  CacheHeader header = entry->header;
+  header.tree_length = BufferLength(&tree);
+  header.tree_hash = HashBytesKeyed(BufferData(&tree), BufferLength(&tree),
+                                    CACHE_KEY_0, CACHE_KEY_1);
+
+  /* Write to a temporary file and rename it into place, so that concurrent
+   * runs never observe a partially written cache file. */
+  char *const temp_path =
+      StringFormat("%s.%ld.tmp", entry->cache_path, (long)getpid());
+  const int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    LOG_DEBUG("open(2): Failed to create cache file '%s': %s", temp_path,
+              strerror(errno));
+    xfree(temp_path);
+    BufferDeinit(&tree);
+    return;
+  }
+
+  bool success = WriteAll(fd, &header, sizeof(header)) &&
+                 WriteAll(fd, entry->path, entry->header.path_length) &&
+                 WriteAll(fd, BufferData(&tree), BufferLength(&tree));
+  if (!success) {
+    LOG_DEBUG("write(2): Failed to write cache file '%s': %s", temp_path,
+              strerror(errno));
+  }
+  success = (close(fd) == 0) && success;
+
+  if (success && rename(temp_path, entry->cache_path) != 0) {
+    LOG_DEBUG("rename(2): Failed to rename '%s' to '%s': %s", temp_path,
+              entry->cache_path, strerror(errno));
+    success = false;
+  }
+  if (!success) {
+    unlink(temp_path);
+  }
+
+  xfree(temp_path);
+  BufferDeinit(&tree);
+}
+
+/****************************************************************************/
+
+void CacheClose(CacheEntry *const entry) {
+  if (entry != NULL) {
+    free(entry->path); // Allocated by realpath(3)
+    xfree(entry->cache_path);
+    xfree(entry);
+  }
+}
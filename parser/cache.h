@@ -0,0 +1,51 @@
+#ifndef _AETHER_CACHE_H
+#define _AETHER_CACHE_H
+
+#include <stdbool.h>
+
+#include "syntax.h"
+
+/**
+ * Cached syntax trees live in $XDG_CACHE_HOME/aether (or ~/.cache/aether),
+ * one file per source file, keyed on the absolute path of the source. An
+ * entry is only used if the size, modification time and content hash of the
+ * source match those it was stored with.
+ */
+typedef struct CacheEntry CacheEntry;
+
+/**
+ * @brief Look up the cache entry of a source file.
+ * @param filename Path to the source file.
+ * @return Cache entry, or NULL if the cache cannot be used for this file.
+ * @note The source is identified once, here. Hence, if it changes while it
+ *       is being parsed, the entry stored afterwards is simply never hit.
+ *       Caller takes ownership of returned value.
+ */
+CacheEntry *CacheOpen(const char *filename);
+
+/**
+ * @brief Load the syntax tree from a cache entry.
+ * @param entry Cache entry.
+ * @param statement Is set to the root of the cached syntax tree, which may be
+ *                  NULL for an empty source file.
+ * @return True on a cache hit, false if the source must be parsed.
+ */
+bool CacheLoad(const CacheEntry *entry, SymbolStatement **statement);
+
+/**
+ * @brief Store a syntax tree in a cache entry.
+ * @param entry Cache entry.
+ * @param statement Root of the syntax tree, may be NULL.
+ * @note The cache is best effort. Failure to store the entry is logged as a
+ *       debug message and otherwise ignored.
+ */
+void CacheStore(const CacheEntry *entry, const SymbolStatement *statement);
+
+/**
+ * @brief Close a cache entry.
+ * @param entry Cache entry.
+ * @note If entry is NULL, no operation is performed.
+ */
+void CacheClose(CacheEntry *entry);
+
+#endif // _AETHER_CACHE_H
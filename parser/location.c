@@ -0,0 +1,121 @@
+#include "location.h"
+#include "config.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "../utils/alloc.h"
+#include "../utils/buffer.h"
+
+void LineTableInit(LineTable *const lines) {
+  assert(lines != NULL);
+  lines->starts = NULL;
+  lines->num_lines = 0;
+  lines->capacity = 0;
+  lines->discarded = 0;
+}
+
+void LineTableDeinit(LineTable *const lines) {
+  assert(lines != NULL);
+  xfree(lines->starts);
+  LineTableInit(lines);
+}
+
+void LineTableAppend(LineTable *const lines, const uint32_t start) {
+  assert(lines != NULL);
+  assert(lines->num_lines == 0 ||
+         lines->starts[lines->num_lines - 1] <= start);
+
+  if (lines->num_lines == lines->capacity) {
+    lines->capacity = (lines->capacity > 0) ? lines->capacity * 2 : 64;
+    lines->starts =
+        xrealloc(lines->starts, sizeof(uint32_t) * lines->capacity);
+  }
+  lines->starts[lines->num_lines++] = start;
+}
+
+void LineTableScan(LineTable *const lines, const char *const data,
+                   size_t length) {
+  assert(lines != NULL);
+  assert(lines->num_lines == 0);
+  assert(data != NULL || length == 0);
+
+  // Offsets saturate at 4 GiB, lines starting beyond cannot be told apart
+  if (length > UINT32_MAX) {
+    length = UINT32_MAX;
+  }
+
+  LineTableAppend(lines, 0);
+  const char *cursor = data;
+  const char *const end = data + length;
+  while (cursor < end) {
+    const char *const newline = memchr(cursor, '\n', (size_t)(end - cursor));
+    if (newline == NULL) {
+      break;
+    }
+    cursor = newline + 1;
+    LineTableAppend(lines, (uint32_t)(cursor - data));
+  }
+}
+
+bool LineTableReadFile(LineTable *const lines, const char *const filename) {
+  assert(filename != NULL);
+
+  Buffer buf;
+  BufferInit(&buf);
+  if (!BufferReadFile(&buf, filename)) {
+    BufferDeinit(&buf);
+    return false;
+  }
+
+  LineTableScan(lines, BufferData(&buf), BufferLength(&buf));
+  BufferDeinit(&buf);
+  return true;
+}
+
+/**
+ * @brief Find the last line starting at or before an offset.
+ * @return Index of the line into starts, zero for an empty line table.
+ */
+static size_t FindLine(const LineTable *const lines, const uint32_t offset) {
+  size_t low = 0, high = lines->num_lines;
+  while (high - low > 1) {
+    const size_t middle = low + ((high - low) / 2);
+    if (lines->starts[middle] <= offset) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+void LineTableDiscard(LineTable *const lines, const uint32_t offset) {
+  assert(lines != NULL);
+
+  const size_t index = FindLine(lines, offset);
+  if (index == 0) {
+    return;
+  }
+
+  lines->num_lines -= index;
+  memmove(lines->starts, lines->starts + index,
+          lines->num_lines * sizeof(uint32_t));
+  lines->discarded += index;
+}
+
+SymbolLocation LineTableLookup(const LineTable *const lines,
+                               const uint32_t offset) {
+  assert(lines != NULL);
+  assert(lines->num_lines == 0 || lines->starts[0] <= offset);
+
+  const size_t index = FindLine(lines, offset);
+  const size_t line = lines->discarded + index + 1;
+  const uint32_t start = (lines->num_lines > 0) ? lines->starts[index] : 0;
+  const uint32_t column = offset - start + 1;
+  return (SymbolLocation){
+      .line = (line > INT_MAX) ? INT_MAX : (int)line,
+      .column = (column > INT_MAX) ? INT_MAX : (int)column,
+  };
+}
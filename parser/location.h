@@ -0,0 +1,83 @@
+#ifndef _AETHER_LOCATION_H
+#define _AETHER_LOCATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "syntax.h"
+
+/**
+ * Symbols only store the byte offset of their first character into the
+ * source (see ParserLocation). A line table maps such offsets back to line
+ * and column, and is only built when a location is actually printed.
+ * @note The struct is public so that line tables can live on the stack (see
+ *       LineTableInit()). Its members are private. The type is declared in
+ *       syntax.h, so that the parser can record lines as they are lexed.
+ */
+struct LineTable {
+  uint32_t *starts; // Offset of the first character of each line, ascending
+  size_t num_lines;
+  size_t capacity;
+  size_t discarded; // Number of lines before starts[0], see LineTableDiscard()
+};
+
+/**
+ * @brief Initialize an empty line table.
+ * @param lines The line table.
+ */
+void LineTableInit(LineTable *lines);
+
+/**
+ * @brief Release the memory held by a line table.
+ * @param lines The line table.
+ */
+void LineTableDeinit(LineTable *lines);
+
+/**
+ * @brief Add a line to a line table.
+ * @param lines The line table.
+ * @param start Offset of the first character of the line, must not precede
+ *              that of the previous line. The first line starts at 0.
+ */
+void LineTableAppend(LineTable *lines, uint32_t start);
+
+/**
+ * @brief Forget the lines that end before an offset, which can no longer be
+ *        looked up. The remaining lines keep their numbers.
+ * @param lines The line table.
+ * @param offset The offset, the line containing it is kept.
+ * @note Allows a line table to cover a source of any length in constant
+ *       memory, by discarding the lines of each statement once it is done.
+ */
+void LineTableDiscard(LineTable *lines, uint32_t offset);
+
+/**
+ * @brief Add the lines of a source to a line table.
+ * @param lines The line table, must be empty.
+ * @param data Contents of the source.
+ * @param length Length of the contents.
+ */
+void LineTableScan(LineTable *lines, const char *data, size_t length);
+
+/**
+ * @brief Add the lines of a source file to a line table.
+ * @param lines The line table, must be empty.
+ * @param filename Path to the source file.
+ * @return False if the file cannot be read, in which case the line table is
+ *         left empty.
+ */
+bool LineTableReadFile(LineTable *lines, const char *filename);
+
+/**
+ * @brief Compute the line and column of a byte offset into the source.
+ * @param lines The line table.
+ * @param offset The byte offset, must not precede the first line that was not
+ *               discarded.
+ * @return Location of the offset. If the line table is empty, the offset is
+ *         treated as a column of the first line.
+ * @note Runs in O(log n) for n lines.
+ */
+SymbolLocation LineTableLookup(const LineTable *lines, uint32_t offset);
+
+#endif // _AETHER_LOCATION_H
@@ -1,12 +1,19 @@
 %{
 #include "syntax.h"
+#include "location.h"
+#include "serialize.h"
 
+#include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
 
 #include "../utils/logger.h"
 #include "../utils/alloc.h"
+#include "../utils/pool.h"
 
 #define P PARSER_STATE
 
@@ -14,15 +21,132 @@ extern FILE *yyin;
 extern void yylex_destroy();
 extern int yylex();
 
+/* Every token is read through ReadToken(), which separates the time spent
+ * in the lexer from the time spent parsing, and tracks whether a statement
+ * is in progress. */
+static int ReadToken(void);
+#define yylex() ReadToken()
+
+/* A symbol is located at its first token. Empty rules inherit the end of
+ * the previous symbol. */
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+  ((Current).offset = YYRHSLOC(Rhs, (N) ? 1 : 0).offset)
+
 void yyerror(char *msg);
 
 ParserState PARSER_STATE = {0};
 
 int yydebug = 1;
+
+/**
+ * @brief Make room for one more element in a growing array.
+ * @param array The array.
+ * @param size Size of each element.
+ * @param length Number of elements in use.
+ * @param capacity Number of allocated elements, updated on growth.
+ * @return The (possibly moved) array.
+ * @note The capacity is doubled on growth, hence appending is amortized O(1).
+ */
+static void *EnsureCapacity(void *array, const size_t size,
+                            const size_t length, size_t *const capacity) {
+  if (length < *capacity) {
+    return array;
+  }
+  *capacity = (*capacity > 0) ? *capacity * 2 : 1;
+  return xrealloc(array, size * *capacity);
+}
+
+/**
+ * @brief Release unused capacity of an array once its length is final.
+ * @param array The array.
+ * @param size Size of each element.
+ * @param length Number of elements in use.
+ * @param capacity Number of allocated elements, updated on shrink.
+ * @return The (possibly moved) array.
+ */
+static void *ShrinkToFit(void *array, const size_t size, const size_t length,
+                         size_t *const capacity) {
+  if (length == *capacity) {
+    return array;
+  }
+  assert(length > 0);
+  *capacity = length;
+  return xrealloc(array, size * length);
+}
+
+/**
+ * @brief Hand a parsed statement over, see ParserState.
+ */
+static void HandleStatement(SymbolStatement *const statement) {
+  P.in_statement = false;
+  if (P.on_statement != NULL) {
+    P.on_statement(statement);
+    return;
+  }
+  if (P.statement != NULL) {
+    yyerror("syntax error, expected a single statement");
+  }
+  P.statement = statement;
+}
+
+static void AppendElement(SymbolList *const list,
+                          SymbolExpression *const expression) {
+  list->elements = EnsureCapacity(list->elements, sizeof(SymbolExpression *),
+                                  list->num_elements, &list->capacity);
+  list->elements[list->num_elements++] = expression;
+}
+
+static void AppendEntry(SymbolDict *const dict, SymbolStringLiteral *const key,
+                        SymbolExpression *const value) {
+  // Keys and values share the capacity of the dict
+  size_t capacity = dict->capacity;
+  dict->keys = EnsureCapacity(dict->keys, sizeof(SymbolStringLiteral *),
+                              dict->num_entries, &capacity);
+  dict->values = EnsureCapacity(dict->values, sizeof(SymbolExpression *),
+                                dict->num_entries, &dict->capacity);
+  dict->keys[dict->num_entries] = key;
+  dict->values[dict->num_entries++] = value;
+}
+
+/**
+ * @brief Trim the operand arrays of a literal or call once it is closed, so
+ *        that it occupies exactly as much memory as its operand count needs.
+ */
+static void ShrinkList(SymbolList *const list) {
+  list->elements = ShrinkToFit(list->elements, sizeof(SymbolExpression *),
+                               list->num_elements, &list->capacity);
+}
+
+static void ShrinkDict(SymbolDict *const dict) {
+  // Keys and values share the capacity of the dict
+  size_t capacity = dict->capacity;
+  dict->keys = ShrinkToFit(dict->keys, sizeof(SymbolStringLiteral *),
+                           dict->num_entries, &capacity);
+  dict->values = ShrinkToFit(dict->values, sizeof(SymbolExpression *),
+                             dict->num_entries, &dict->capacity);
+}
+
+static void ShrinkFncall(SymbolFncall *const fncall) {
+  fncall->arguments =
+      ShrinkToFit(fncall->arguments, sizeof(SymbolExpression *),
+                  fncall->num_arguments, &fncall->capacity);
+}
+
+static void AppendArgument(SymbolFncall *const fncall,
+                           SymbolExpression *const expression) {
+  fncall->arguments =
+      EnsureCapacity(fncall->arguments, sizeof(SymbolExpression *),
+                     fncall->num_arguments, &fncall->capacity);
+  fncall->arguments[fncall->num_arguments++] = expression;
+}
 %}
 
 %locations
 
+/* Frees the semantic values that are discarded while recovering from a
+ * syntax error, see ParserState.interactive. */
+%destructor { SyntaxTreeFree((Symbol *)$$); } <*>
+
 // Terminals
 
 %union {
@@ -71,10 +195,7 @@ int yydebug = 1;
   SymbolPrimary *primary;
   SymbolFncall *fncall;
   SymbolDict *dict;
-  SymbolEntries *entries;
   SymbolList *list;
-  SymbolElements *elements;
-  SymbolArguments *arguments;
   SymbolSubscription *subscription;
   SymbolSlice *slice;
   SymbolAtom *atom;
@@ -102,12 +223,9 @@ int yydebug = 1;
 %type <minus> minus;
 %type <negate> negate;
 %type <primary> primary;
-%type <fncall> fncall;
-%type <arguments> arguments;
-%type <dict> dict;
-%type <entries> entries;
-%type <list> list;
-%type <elements> elements;
+%type <fncall> fncall arguments;
+%type <dict> dict entries;
+%type <list> list elements;
 %type <subscription> subscription;
 %type <slice> slice;
 %type <atom> atom;
@@ -137,41 +255,38 @@ start
   LOG_DEBUG("start : %%empty");
   P.statement = NULL;
 }
-| statement {
-  LOG_DEBUG("start : statement");
-  P.statement = $1;
+| start statement {
+  LOG_DEBUG("start : start statement");
+  HandleStatement($2);
+}
+| start error ';' {
+  // Only reached in interactive mode, yyerror() exits otherwise
+  LOG_DEBUG("start : start error ';'");
+  P.in_statement = false;
+  yyerrok;
 }
 ;
 
 statement
 : assignment ';' {
   LOG_DEBUG("statement : assignment ';'");
-  $$ = xmalloc(sizeof(SymbolStatement));
+  $$ = PoolAlloc(sizeof(SymbolStatement));
   $$->type = SYMBOL_TYPE_STATEMENT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | declaration ';' {
   LOG_DEBUG("statement : declaration ';'");
-  $$ = xmalloc(sizeof(SymbolStatement));
+  $$ = PoolAlloc(sizeof(SymbolStatement));
   $$->type = SYMBOL_TYPE_STATEMENT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | expression ';' {
   LOG_DEBUG("statement : expression ';'");
-  $$ = xmalloc(sizeof(SymbolStatement));
+  $$ = PoolAlloc(sizeof(SymbolStatement));
   $$->type = SYMBOL_TYPE_STATEMENT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -179,23 +294,17 @@ statement
 assignment
 : expression '=' expression {
   LOG_DEBUG("assignment : expression '=' expression");
-  $$ = xmalloc(sizeof(SymbolAssignment));
+  $$ = PoolAlloc(sizeof(SymbolAssignment));
   $$->type = SYMBOL_TYPE_ASSIGNMENT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
   $$->expression = $3;
 }
 | declaration '=' expression {
   LOG_DEBUG("assignment : declaration '=' expression");
-  $$ = xmalloc(sizeof(SymbolAssignment));
+  $$ = PoolAlloc(sizeof(SymbolAssignment));
   $$->type = SYMBOL_TYPE_ASSIGNMENT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
   $$->expression = $3;
 }
@@ -204,34 +313,25 @@ assignment
 declaration
 : reference IDENTIFIER {
   LOG_DEBUG("declaration : reference IDENTIFIER");
-  $$ = xmalloc(sizeof(SymbolDeclaration));
+  $$ = PoolAlloc(sizeof(SymbolDeclaration));
   $$->type = SYMBOL_TYPE_DECLARATION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->identifier = $2;
   $$->symbol = (Symbol *)$1;
 }
 | mutable IDENTIFIER {
   LOG_DEBUG("declaration : mutable IDENTIFIER");
-  $$ = xmalloc(sizeof(SymbolDeclaration));
+  $$ = PoolAlloc(sizeof(SymbolDeclaration));
   $$->type = SYMBOL_TYPE_DECLARATION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
   $$->identifier = $2;
 }
 | datatype IDENTIFIER {
   LOG_DEBUG("declaration : datatype IDENTIFIER");
-  $$ = xmalloc(sizeof(SymbolDeclaration));
+  $$ = PoolAlloc(sizeof(SymbolDeclaration));
   $$->type = SYMBOL_TYPE_DECLARATION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
   $$->identifier = $2;
 }
@@ -240,22 +340,16 @@ declaration
 reference
 : datatype '&' {
   LOG_DEBUG("reference : datatype '&'");
-  $$ = xmalloc(sizeof(SymbolReference));
+  $$ = PoolAlloc(sizeof(SymbolReference));
   $$->type = SYMBOL_TYPE_REFERENCE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | mutable '&' {
   LOG_DEBUG("reference : mutable '&'");
-  $$ = xmalloc(sizeof(SymbolReference));
+  $$ = PoolAlloc(sizeof(SymbolReference));
   $$->type = SYMBOL_TYPE_REFERENCE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -263,12 +357,9 @@ reference
 mutable
 : MUTABLE_KEYWORD datatype {
   LOG_DEBUG("mutable : MUTABLE_KEYWORD datatype");
-  $$ = xmalloc(sizeof(SymbolMutable));
+  $$ = PoolAlloc(sizeof(SymbolMutable));
   $$->type = SYMBOL_TYPE_MUTABLE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->datatype = $2;
 }
 ;
@@ -276,12 +367,9 @@ mutable
 datatype
 : IDENTIFIER {
   LOG_DEBUG("datatype : IDENTIFIER");
-  $$ = xmalloc(sizeof(SymbolDatatype));
+  $$ = PoolAlloc(sizeof(SymbolDatatype));
   $$->type = SYMBOL_TYPE_DATATYPE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->identifier = $1;
 }
 ;
@@ -289,22 +377,16 @@ datatype
 expression
 : condition {
   LOG_DEBUG("expression : condition");
-  $$ = xmalloc(sizeof(SymbolExpression));
+  $$ = PoolAlloc(sizeof(SymbolExpression));
   $$->type = SYMBOL_TYPE_EXPRESSION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | or {
   LOG_DEBUG("expression : or");
-  $$ = xmalloc(sizeof(SymbolExpression));
+  $$ = PoolAlloc(sizeof(SymbolExpression));
   $$->type = SYMBOL_TYPE_EXPRESSION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -312,12 +394,9 @@ expression
 or
 : expression OR_OPER condition {
   LOG_DEBUG("or : expression OR_OPER condition");
-  $$ = xmalloc(sizeof(SymbolOr));
+  $$ = PoolAlloc(sizeof(SymbolOr));
   $$->type = SYMBOL_TYPE_OR;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->expression = $1;
   $$->condition = $3;
 }
@@ -326,22 +405,16 @@ or
 condition
 : comparison {
   LOG_DEBUG("condition : comparison");
-  $$ = xmalloc(sizeof(SymbolCondition));
+  $$ = PoolAlloc(sizeof(SymbolCondition));
   $$->type = SYMBOL_TYPE_CONDITION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | and {
   LOG_DEBUG("condition : and");
-  $$ = xmalloc(sizeof(SymbolCondition));
+  $$ = PoolAlloc(sizeof(SymbolCondition));
   $$->type = SYMBOL_TYPE_CONDITION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -349,12 +422,9 @@ condition
 and
 : condition AND_OPER comparison {
   LOG_DEBUG("and : condition AND_OPER comparison");
-  $$ = xmalloc(sizeof(SymbolAnd));
+  $$ = PoolAlloc(sizeof(SymbolAnd));
   $$->type = SYMBOL_TYPE_AND;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->condition = $1;
   $$->comparison = $3;
 }
@@ -363,72 +433,51 @@ and
 comparison
 : term {
   LOG_DEBUG("comparison : term");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | less_than {
   LOG_DEBUG("comparison : less_than");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | greater_than {
   LOG_DEBUG("comparison : greater_than");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | equal {
   LOG_DEBUG("comparison : equal");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | less_equal {
   LOG_DEBUG("comparison : less_equal");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | greater_equal {
   LOG_DEBUG("comparison : greater_equal");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | not_equal {
   LOG_DEBUG("comparison : not_equal");
-  $$ = xmalloc(sizeof(SymbolComparison));
+  $$ = PoolAlloc(sizeof(SymbolComparison));
   $$->type = SYMBOL_TYPE_COMPARISON;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -436,12 +485,9 @@ comparison
 less_than
 : comparison '<' term {
   LOG_DEBUG("less_than : comparison '<' term");
-  $$ = xmalloc(sizeof(SymbolLessThan));
+  $$ = PoolAlloc(sizeof(SymbolLessThan));
   $$->type = SYMBOL_TYPE_LESS_THAN;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->comparison = $1;
   $$->term = $3;
 }
@@ -450,12 +496,9 @@ less_than
 greater_than
 : comparison '>' term {
   LOG_DEBUG("greater_than : comparison '>' term");
-  $$ = xmalloc(sizeof(SymbolGreaterThan));
+  $$ = PoolAlloc(sizeof(SymbolGreaterThan));
   $$->type = SYMBOL_TYPE_GREATER_THAN;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->comparison = $1;
   $$->term = $3;
 }
@@ -464,12 +507,9 @@ greater_than
 equal
 : comparison EQ_OPER term {
   LOG_DEBUG("equal : comparison EQ_OPER term");
-  $$ = xmalloc(sizeof(SymbolEqual));
+  $$ = PoolAlloc(sizeof(SymbolEqual));
   $$->type = SYMBOL_TYPE_EQUAL;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->comparison = $1;
   $$->term = $3;
 }
@@ -478,12 +518,9 @@ equal
 less_equal
 : comparison LE_OPER term {
   LOG_DEBUG("less_equal : comparison LE_OPER term");
-  $$ = xmalloc(sizeof(SymbolLessEqual));
+  $$ = PoolAlloc(sizeof(SymbolLessEqual));
   $$->type = SYMBOL_TYPE_LESS_EQUAL;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->comparison = $1;
   $$->term = $3;
 }
@@ -492,12 +529,9 @@ less_equal
 greater_equal
 : comparison GE_OPER term {
   LOG_DEBUG("greater_equal : comparison GE_OPER term");
-  $$ = xmalloc(sizeof(SymbolGreaterEqual));
+  $$ = PoolAlloc(sizeof(SymbolGreaterEqual));
   $$->type = SYMBOL_TYPE_GREATER_EQUAL;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->comparison = $1;
   $$->term = $3;
 }
@@ -506,12 +540,9 @@ greater_equal
 not_equal
 : comparison NE_OPER term {
   LOG_DEBUG("not_equal : comparison NE_OPER term");
-  $$ = xmalloc(sizeof(SymbolNotEqual));
+  $$ = PoolAlloc(sizeof(SymbolNotEqual));
   $$->type = SYMBOL_TYPE_NOT_EQUAL;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->comparison = $1;
   $$->term = $3;
 }
@@ -520,32 +551,23 @@ not_equal
 term
 : factor {
   LOG_DEBUG("term : factor");
-  $$ = xmalloc(sizeof(SymbolTerm));
+  $$ = PoolAlloc(sizeof(SymbolTerm));
   $$->type = SYMBOL_TYPE_TERM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | add {
   LOG_DEBUG("term : add");
-  $$ = xmalloc(sizeof(SymbolTerm));
+  $$ = PoolAlloc(sizeof(SymbolTerm));
   $$->type = SYMBOL_TYPE_TERM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | subtract {
   LOG_DEBUG("term : subtract");
-  $$ = xmalloc(sizeof(SymbolTerm));
+  $$ = PoolAlloc(sizeof(SymbolTerm));
   $$->type = SYMBOL_TYPE_TERM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -553,12 +575,9 @@ term
 add
 : term '+' factor {
   LOG_DEBUG("add : term '+' factor");
-  $$ = xmalloc(sizeof(SymbolAdd));
+  $$ = PoolAlloc(sizeof(SymbolAdd));
   $$->type = SYMBOL_TYPE_ADD;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->term = $1;
   $$->factor = $3;
 }
@@ -567,12 +586,9 @@ add
 subtract
 : term '-' factor {
   LOG_DEBUG("subtract : term '-' factor");
-  $$ = xmalloc(sizeof(SymbolSubtract));
+  $$ = PoolAlloc(sizeof(SymbolSubtract));
   $$->type = SYMBOL_TYPE_SUBTRACT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->term = $1;
   $$->factor = $3;
 }
@@ -581,42 +597,30 @@ subtract
 factor
 : unary {
   LOG_DEBUG("factor : unary");
-  $$ = xmalloc(sizeof(SymbolFactor));
+  $$ = PoolAlloc(sizeof(SymbolFactor));
   $$->type = SYMBOL_TYPE_FACTOR;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | multiply {
   LOG_DEBUG("factor : multiply");
-  $$ = xmalloc(sizeof(SymbolFactor));
+  $$ = PoolAlloc(sizeof(SymbolFactor));
   $$->type = SYMBOL_TYPE_FACTOR;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | divide {
   LOG_DEBUG("factor : divide");
-  $$ = xmalloc(sizeof(SymbolFactor));
+  $$ = PoolAlloc(sizeof(SymbolFactor));
   $$->type = SYMBOL_TYPE_FACTOR;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | modulo {
   LOG_DEBUG("factor : modulo");
-  $$ = xmalloc(sizeof(SymbolFactor));
-  $$->type = SYMBOL_TYPE_MODULO;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$ = PoolAlloc(sizeof(SymbolFactor));
+  $$->type = SYMBOL_TYPE_FACTOR;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -624,12 +628,9 @@ factor
 multiply
 : factor '*' unary {
   LOG_DEBUG("multiply : factor '*' unary");
-  $$ = xmalloc(sizeof(SymbolMultiply));
+  $$ = PoolAlloc(sizeof(SymbolMultiply));
   $$->type = SYMBOL_TYPE_MULTIPLY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->factor = $1;
   $$->unary = $3;
 }
@@ -638,12 +639,9 @@ multiply
 divide
 : factor '/' unary {
   LOG_DEBUG("divide : factor '/' unary");
-  $$ = xmalloc(sizeof(SymbolDivide));
+  $$ = PoolAlloc(sizeof(SymbolDivide));
   $$->type = SYMBOL_TYPE_DIVIDE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->factor = $1;
   $$->unary = $3;
 }
@@ -651,13 +649,10 @@ divide
 
 modulo
 : factor '%' unary {
-  LOG_DEBUG("divide : factor '%' unary");
-  $$ = xmalloc(sizeof(SymbolModulo));
+  LOG_DEBUG("modulo : factor '%%' unary");
+  $$ = PoolAlloc(sizeof(SymbolModulo));
   $$->type = SYMBOL_TYPE_MODULO;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->factor = $1;
   $$->unary = $3;
 }
@@ -666,39 +661,29 @@ modulo
 unary
 : primary {
   LOG_DEBUG("primary");
-  $$ = xmalloc(sizeof(SymbolUnary));
+  $$ = PoolAlloc(sizeof(SymbolUnary));
   $$->type = SYMBOL_TYPE_UNARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | '+' unary {
   LOG_DEBUG("unary : '+' unary");
   // Ignore '+' token
   $$ = $2;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
+  $$->offset = @1.offset;
 }
 | minus {
   LOG_DEBUG("unary : minus");
-  $$ = xmalloc(sizeof(SymbolUnary));
+  $$ = PoolAlloc(sizeof(SymbolUnary));
   $$->type = SYMBOL_TYPE_UNARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | negate {
   LOG_DEBUG("unary : negate");
-  $$ = xmalloc(sizeof(SymbolUnary));
+  $$ = PoolAlloc(sizeof(SymbolUnary));
   $$->type = SYMBOL_TYPE_UNARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
@@ -706,12 +691,9 @@ unary
 minus
 : '-' unary {
   LOG_DEBUG("minus : '-' unary");
-  $$ = xmalloc(sizeof(SymbolMinus));
+  $$ = PoolAlloc(sizeof(SymbolMinus));
   $$->type = SYMBOL_TYPE_MINUS;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->unary = $2;
 }
 ;
@@ -719,12 +701,9 @@ minus
 negate
 : '!' unary {
   LOG_DEBUG("negate : '!' unary");
-  $$ = xmalloc(sizeof(SymbolNegate));
+  $$ = PoolAlloc(sizeof(SymbolNegate));
   $$->type = SYMBOL_TYPE_NEGATE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
   $$->unary = $2;
 }
 ;
@@ -732,222 +711,169 @@ negate
 primary
 : atom {
   LOG_DEBUG("primary : atom");
-  $$ = xmalloc(sizeof(SymbolPrimary));
+  $$ = PoolAlloc(sizeof(SymbolPrimary));
   $$->type = SYMBOL_TYPE_PRIMARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | fncall {
   LOG_DEBUG("primary : fncall");
-  $$ = xmalloc(sizeof(SymbolPrimary));
+  $$ = PoolAlloc(sizeof(SymbolPrimary));
   $$->type = SYMBOL_TYPE_PRIMARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | subscription {
   LOG_DEBUG("primary : subscription");
-  $$ = xmalloc(sizeof(SymbolPrimary));
+  $$ = PoolAlloc(sizeof(SymbolPrimary));
   $$->type = SYMBOL_TYPE_PRIMARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | slice {
   LOG_DEBUG("primary : slice");
-  $$ = xmalloc(sizeof(SymbolPrimary));
+  $$ = PoolAlloc(sizeof(SymbolPrimary));
   $$->type = SYMBOL_TYPE_PRIMARY;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
 
 fncall : primary '(' ')' {
   LOG_DEBUG("fncall : primary '(' ')'");
-  $$ = xmalloc(sizeof(SymbolFncall));
+  $$ = PoolAlloc(sizeof(SymbolFncall));
   $$->type = SYMBOL_TYPE_FNCALL;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
   $$->primary = $1;
+  $$->num_arguments = 0;
+  $$->capacity = 0;
   $$->arguments = NULL;
 }
 | primary '(' arguments ')' {
   LOG_DEBUG("fncall : primary '(' arguments ')'");
-  $$ = xmalloc(sizeof(SymbolFncall));
-  $$->type = SYMBOL_TYPE_FNCALL;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @4.last_line;
-  $$->last.column = @4.last_column;
+  // Arguments are accumulated directly into the call
+  $$ = $3;
+  $$->offset = @1.offset;
   $$->primary = $1;
-  $$->arguments = $3;
+  ShrinkFncall($$);
 }
 ;
 
 dict
 : '{' '}' {
   LOG_DEBUG("dict : '{' '}'");
-  $$ = xmalloc(sizeof(SymbolDict));
+  $$ = PoolAlloc(sizeof(SymbolDict));
   $$->type = SYMBOL_TYPE_DICT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
-  $$->entries = NULL;
+  $$->offset = @1.offset;
+  $$->num_entries = 0;
+  $$->capacity = 0;
+  $$->keys = NULL;
+  $$->values = NULL;
 }
 | '{' entries '}' {
   LOG_DEBUG("dict : '{' entries '}'");
-  $$ = xmalloc(sizeof(SymbolDict));
-  $$->type = SYMBOL_TYPE_DICT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
-  $$->entries = $2;
+  // Entries are accumulated directly into the dict
+  $$ = $2;
+  $$->offset = @1.offset;
+  ShrinkDict($$);
 }
 | '{' entries ',' '}' {
   LOG_DEBUG("dict : '{' entries ',' '}'");
-  $$ = xmalloc(sizeof(SymbolDict));
-  $$->type = SYMBOL_TYPE_DICT;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @4.last_line;
-  $$->last.column = @4.last_column;
-  $$->entries = $2;
+  // Entries are accumulated directly into the dict
+  $$ = $2;
+  $$->offset = @1.offset;
+  ShrinkDict($$);
 }
 ;
 
 entries
 : STRING_LITERAL ':' expression {
   LOG_DEBUG("entries : STRING_LITERAL ':' expression");
-  $$ = xmalloc(sizeof(SymbolEntries));
-  $$->type = SYMBOL_TYPE_ENTRIES;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
-  $$->entries = NULL;
-  $$->string_literal = $1;
-  $$->expression = $3;
+  $$ = PoolAlloc(sizeof(SymbolDict));
+  $$->type = SYMBOL_TYPE_DICT;
+  $$->offset = @1.offset;
+  $$->num_entries = 0;
+  $$->capacity = 0;
+  $$->keys = NULL;
+  $$->values = NULL;
+  AppendEntry($$, $1, $3);
 }
 | entries ',' STRING_LITERAL ':' expression {
   LOG_DEBUG("entries : entries ',' STRING_LITERAL ':' expression");
-  $$ = xmalloc(sizeof(SymbolEntries));
-  $$->type = SYMBOL_TYPE_ENTRIES;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @5.last_line;
-  $$->last.column = @5.last_column;
-  $$->entries = $1;
-  $$->string_literal = $3;
-  $$->expression = $5;
+  $$ = $1;
+  AppendEntry($$, $3, $5);
 }
 ;
 
 list
 : '[' ']' {
   LOG_DEBUG("list : '[' ']'");
-  $$ = xmalloc(sizeof(SymbolList));
+  $$ = PoolAlloc(sizeof(SymbolList));
   $$->type = SYMBOL_TYPE_LIST;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @2.last_line;
-  $$->last.column = @2.last_column;
+  $$->offset = @1.offset;
+  $$->num_elements = 0;
+  $$->capacity = 0;
   $$->elements = NULL;
 }
 | '[' elements ']' {
   LOG_DEBUG("list : '[' elements ']'");
-  $$ = xmalloc(sizeof(SymbolList));
-  $$->type = SYMBOL_TYPE_LIST;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
-  $$->elements = $2;
+  // Elements are accumulated directly into the list
+  $$ = $2;
+  $$->offset = @1.offset;
+  ShrinkList($$);
 }
 | '[' elements ',' ']' {
   LOG_DEBUG("list : '[' elements ',' ']'");
-  $$ = xmalloc(sizeof(SymbolList));
-  $$->type = SYMBOL_TYPE_LIST;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @4.last_line;
-  $$->last.column = @4.last_column;
-  $$->elements = $2;
+  // Elements are accumulated directly into the list
+  $$ = $2;
+  $$->offset = @1.offset;
+  ShrinkList($$);
 }
 ;
 
 elements
 : expression {
   LOG_DEBUG("elements : expression");
-  $$ = xmalloc(sizeof(SymbolElements));
-  $$->type = SYMBOL_TYPE_ELEMENTS;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$ = PoolAlloc(sizeof(SymbolList));
+  $$->type = SYMBOL_TYPE_LIST;
+  $$->offset = @1.offset;
+  $$->num_elements = 0;
+  $$->capacity = 0;
   $$->elements = NULL;
-  $$->expression = $1;
+  AppendElement($$, $1);
 }
 | elements ',' expression {
   LOG_DEBUG("elements : elements ',' expression");
-  $$ = xmalloc(sizeof(SymbolElements));
-  $$->type = SYMBOL_TYPE_ELEMENTS;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
-  $$->elements = $1;
-  $$->expression = $3;
+  $$ = $1;
+  AppendElement($$, $3);
 }
 ;
 
 arguments
 : expression {
   LOG_DEBUG("arguments : expression");
-  $$ = xmalloc(sizeof(SymbolArguments));
-  $$->type = SYMBOL_TYPE_ARGUMENTS;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$ = PoolAlloc(sizeof(SymbolFncall));
+  $$->type = SYMBOL_TYPE_FNCALL;
+  $$->offset = @1.offset;
+  $$->primary = NULL;
+  $$->num_arguments = 0;
+  $$->capacity = 0;
   $$->arguments = NULL;
-  $$->expression = $1;
+  AppendArgument($$, $1);
 }
 | arguments ',' expression {
   LOG_DEBUG("arguments : arguments ',' expression");
-  $$ = xmalloc(sizeof(SymbolArguments));
-  $$->type = SYMBOL_TYPE_ARGUMENTS;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
-  $$->arguments = $1;
-  $$->expression = $3;
+  $$ = $1;
+  AppendArgument($$, $3);
 }
 ;
 
 subscription
 : primary '[' expression ']' {
   LOG_DEBUG("subscription : primary '[' expression ']'");
-  $$ = xmalloc(sizeof(SymbolSubscription));
+  $$ = PoolAlloc(sizeof(SymbolSubscription));
   $$->type = SYMBOL_TYPE_SUBSCRIPTION;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @4.last_line;
-  $$->last.column = @4.last_column;
+  $$->offset = @1.offset;
   $$->primary = $1;
   $$->expression = $3;
 }
@@ -956,48 +882,36 @@ subscription
 slice
 : primary '[' expression ':' expression ']' {
   LOG_DEBUG("slice : primary '[' expression ':' expression ']'");
-  $$ = xmalloc(sizeof(SymbolSlice));
+  $$ = PoolAlloc(sizeof(SymbolSlice));
   $$->type = SYMBOL_TYPE_SLICE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @6.last_line;
-  $$->last.column = @6.last_column;
+  $$->offset = @1.offset;
   $$->primary = $1;
   $$->left_expression = $3;
   $$->right_expression = $5;
 }
 | primary '[' expression ':' ']' {
   LOG_DEBUG("slice : primary '[' expression ':' ']'");
-  $$ = xmalloc(sizeof(SymbolSlice));
+  $$ = PoolAlloc(sizeof(SymbolSlice));
   $$->type = SYMBOL_TYPE_SLICE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @5.last_line;
-  $$->last.column = @5.last_column;
+  $$->offset = @1.offset;
   $$->primary = $1;
   $$->left_expression = $3;
   $$->right_expression = NULL;
 }
 | primary '[' ':' expression ']' {
   LOG_DEBUG("slice : primary '[' ':' expression ']'");
-  $$ = xmalloc(sizeof(SymbolSlice));
+  $$ = PoolAlloc(sizeof(SymbolSlice));
   $$->type = SYMBOL_TYPE_SLICE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @5.last_line;
-  $$->last.column = @5.last_column;
+  $$->offset = @1.offset;
   $$->primary = $1;
   $$->left_expression = NULL;
   $$->right_expression = $4;
 }
 | primary '[' ':' ']' {
   LOG_DEBUG("slice : primary '[' ':' ']'");
-  $$ = xmalloc(sizeof(SymbolSlice));
+  $$ = PoolAlloc(sizeof(SymbolSlice));
   $$->type = SYMBOL_TYPE_SLICE;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @4.last_line;
-  $$->last.column = @4.last_column;
+  $$->offset = @1.offset;
   $$->primary = $1;
   $$->left_expression = NULL;
   $$->right_expression = NULL;
@@ -1008,118 +922,123 @@ inner_expression
 : '(' expression ')' {
   LOG_DEBUG("inner_expression : '(' expression ')'");
   $$ = $2;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @3.last_line;
-  $$->last.column = @3.last_column;
+  $$->offset = @1.offset;
 }
 ;
 
 atom
 : IDENTIFIER {
   LOG_DEBUG("atom : IDENTIFIER");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | INTEGER_LITERAL {
   LOG_DEBUG("atom : INTEGER_LITERAL");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | FLOAT_LITERAL {
   LOG_DEBUG("atom : FLOAT_LITERAL");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | STRING_LITERAL {
   LOG_DEBUG("atom : STRING_LITERAL");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | BOOLEAN_LITERAL {
   LOG_DEBUG("atom : BOOLEAN_LITERAL");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | NONE_LITERAL {
   LOG_DEBUG("atom : NONE_LITERAL");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | dict {
   LOG_DEBUG("atom : dict");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | list {
   LOG_DEBUG("atom : list");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 | inner_expression {
   LOG_DEBUG("atom : inner_expression");
-  $$ = xmalloc(sizeof(SymbolAtom));
+  $$ = PoolAlloc(sizeof(SymbolAtom));
   $$->type = SYMBOL_TYPE_ATOM;
-  $$->first.line = @1.first_line;
-  $$->first.column = @1.first_column;
-  $$->last.line = @1.last_line;
-  $$->last.column = @1.last_column;
+  $$->offset = @1.offset;
   $$->symbol = (Symbol *)$1;
 }
 ;
 
 %%
 
-bool ParseFile(const char *const filename) {
+/**
+ * @brief Open a source file, or stdin if the filename is "-".
+ * @return The file, or NULL on error (which is logged).
+ */
+static FILE *OpenSource(const char *const filename) {
+  if (strcmp(filename, "-") == 0) {
+    return stdin;
+  }
+  FILE *const file = fopen(filename, "r");
+  if (file == NULL) {
+    LOG_ERROR("Failed to open file '%s': %s", filename, strerror(errno));
+  }
+  return file;
+}
+
+static void CloseSource(FILE *const file) {
+  if (file != stdin) {
+    fclose(file);
+  }
+}
+
+/**
+ * @brief Reset the position of the lexer to the start of a source.
+ */
+static void ResetLocation(const char *const filename) {
   P.filename = filename;
   P.line = 1;
-  P.column = 1;
+  P.line_offset = 0;
+  P.offset = 0;
+  yylloc.offset = 0;
+  if (P.lines != NULL) {
+    LineTableAppend(P.lines, 0);
+  }
+}
+
+bool ParseFile(const char *const filename) {
+  ResetLocation(filename);
+  P.statement = NULL;
+  P.in_statement = false;
+  P.num_errors = 0;
 
   LOG_DEBUG("Parsing file '%s'", filename);
 
-  yyin = fopen(filename, "r");
+  yyin = OpenSource(filename);
   if (yyin == NULL) {
-    LOG_ERROR("Failed to open file '%s': %s", filename, strerror(errno));
     return false;
   }
 
@@ -1127,18 +1046,101 @@ bool ParseFile(const char *const filename) {
     yyparse();
 
     if (ferror(yyin)) {
-      LOG_ERROR("Failed to parse file '%s': %s", strerror(errno));
-      fclose(yyin);
+      LOG_ERROR("Failed to parse file '%s': %s", filename,
+                strerror(errno));
+      CloseSource(yyin);
       return false;
     }
   }
 
-  fclose(yyin);
+  CloseSource(yyin);
+  yylex_destroy();
+  return P.num_errors == 0;
+}
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+static int ReadToken(void) {
+  int token;
+  if (P.measure_lexer) {
+    const double start = Now();
+    token = (yylex)();
+    P.lex_time += Now() - start;
+  } else {
+    token = (yylex)();
+  }
+
+  if (token != YYEOF) {
+    P.in_statement = true;
+  }
+  return token;
+}
+
+/**
+ * @brief Free the semantic value of a token that is not consumed by the
+ *        parser.
+ */
+static void FreeToken(const int token) {
+  switch (token) {
+  case IDENTIFIER:
+    xfree(yylval.identifier->value);
+    PoolFree(yylval.identifier, sizeof(*yylval.identifier));
+    break;
+  case STRING_LITERAL:
+    xfree(yylval.string_literal->value);
+    PoolFree(yylval.string_literal, sizeof(*yylval.string_literal));
+    break;
+  case INTEGER_LITERAL:
+    PoolFree(yylval.integer_literal, sizeof(*yylval.integer_literal));
+    break;
+  case FLOAT_LITERAL:
+    PoolFree(yylval.float_literal, sizeof(*yylval.float_literal));
+    break;
+  case BOOLEAN_LITERAL:
+    PoolFree(yylval.boolean_literal, sizeof(*yylval.boolean_literal));
+    break;
+  case NONE_LITERAL:
+    PoolFree(yylval.none_literal, sizeof(*yylval.none_literal));
+    break;
+  default:
+    break;
+  }
+}
+
+bool LexFile(const char *const filename) {
+  ResetLocation(filename);
+
+  LOG_DEBUG("Lexing file '%s'", filename);
+
+  yyin = OpenSource(filename);
+  if (yyin == NULL) {
+    return false;
+  }
+
+  int token;
+  while ((token = yylex()) != 0) {
+    FreeToken(token);
+  }
+
+  if (ferror(yyin)) {
+    LOG_ERROR("Failed to lex file '%s': %s", filename, strerror(errno));
+    CloseSource(yyin);
+    return false;
+  }
+
+  CloseSource(yyin);
   yylex_destroy();
   return true;
 }
 
 void yyerror(char *msg) {
   LOG_ERROR(msg);
-  exit(1);
+  P.num_errors += 1;
+  if (!P.interactive) {
+    exit(1);
+  }
 }
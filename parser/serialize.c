@@ -0,0 +1,547 @@
+#include "serialize.h"
+#include "config.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../utils/alloc.h"
+#include "../utils/logger.h"
+#include "../utils/pool.h"
+
+/* Marks a missing child symbol (e.g., the bounds of a slice). Real symbol
+ * types are stored in a single byte, so they never reach this value. */
+#define SYMBOL_NULL 0xff
+
+typedef enum {
+  PAYLOAD_NONE,
+  PAYLOAD_STRING,
+  PAYLOAD_INTEGER,
+  PAYLOAD_FLOAT,
+  PAYLOAD_BOOLEAN,
+  PAYLOAD_VECTOR,
+} PayloadType;
+
+/**
+ * Describes where a symbol keeps its children and payload, so that a single
+ * routine can serialize, deserialize and free every type of symbol.
+ */
+typedef struct {
+  size_t size; // Zero if the symbol type never appears in a syntax tree
+  size_t num_children;
+  size_t children[3];
+  PayloadType payload;
+  size_t value; // Offset of the value of scalar payloads
+  // Offsets of the parallel arrays of vector payloads
+  size_t length;
+  size_t capacity;
+  size_t num_vectors;
+  size_t vectors[2];
+} SymbolLayout;
+
+#define BINARY(T, left, right)                                                 \
+  {                                                                            \
+    .size = sizeof(T), .num_children = 2,                                      \
+    .children = {offsetof(T, left), offsetof(T, right)},                       \
+  }
+
+#define UNARY(T, child)                                                        \
+  {                                                                            \
+    .size = sizeof(T), .num_children = 1, .children = {offsetof(T, child)},    \
+  }
+
+#define SCALAR(T, type)                                                        \
+  { .size = sizeof(T), .payload = (type), .value = offsetof(T, value), }
+
+static const SymbolLayout LAYOUTS[] = {
+    [SYMBOL_TYPE_STATEMENT] = UNARY(SymbolStatement, symbol),
+    [SYMBOL_TYPE_ASSIGNMENT] = BINARY(SymbolAssignment, symbol, expression),
+    [SYMBOL_TYPE_DECLARATION] = BINARY(SymbolDeclaration, symbol, identifier),
+    [SYMBOL_TYPE_REFERENCE] = UNARY(SymbolReference, symbol),
+    [SYMBOL_TYPE_MUTABLE] = UNARY(SymbolMutable, datatype),
+    [SYMBOL_TYPE_DATATYPE] = UNARY(SymbolDatatype, identifier),
+    [SYMBOL_TYPE_EXPRESSION] = UNARY(SymbolExpression, symbol),
+    [SYMBOL_TYPE_OR] = BINARY(SymbolOr, expression, condition),
+    [SYMBOL_TYPE_CONDITION] = UNARY(SymbolCondition, symbol),
+    [SYMBOL_TYPE_AND] = BINARY(SymbolAnd, condition, comparison),
+    [SYMBOL_TYPE_COMPARISON] = UNARY(SymbolComparison, symbol),
+    [SYMBOL_TYPE_LESS_THAN] = BINARY(SymbolLessThan, comparison, term),
+    [SYMBOL_TYPE_GREATER_THAN] = BINARY(SymbolGreaterThan, comparison, term),
+    [SYMBOL_TYPE_EQUAL] = BINARY(SymbolEqual, comparison, term),
+    [SYMBOL_TYPE_LESS_EQUAL] = BINARY(SymbolLessEqual, comparison, term),
+    [SYMBOL_TYPE_GREATER_EQUAL] = BINARY(SymbolGreaterEqual, comparison, term),
+    [SYMBOL_TYPE_NOT_EQUAL] = BINARY(SymbolNotEqual, comparison, term),
+    [SYMBOL_TYPE_TERM] = UNARY(SymbolTerm, symbol),
+    [SYMBOL_TYPE_ADD] = BINARY(SymbolAdd, term, factor),
+    [SYMBOL_TYPE_SUBTRACT] = BINARY(SymbolSubtract, term, factor),
+    [SYMBOL_TYPE_FACTOR] = UNARY(SymbolFactor, symbol),
+    [SYMBOL_TYPE_MULTIPLY] = BINARY(SymbolMultiply, factor, unary),
+    [SYMBOL_TYPE_DIVIDE] = BINARY(SymbolDivide, factor, unary),
+    [SYMBOL_TYPE_MODULO] = BINARY(SymbolModulo, factor, unary),
+    [SYMBOL_TYPE_UNARY] = UNARY(SymbolUnary, symbol),
+    [SYMBOL_TYPE_MINUS] = UNARY(SymbolMinus, unary),
+    [SYMBOL_TYPE_NEGATE] = UNARY(SymbolNegate, unary),
+    [SYMBOL_TYPE_PRIMARY] = UNARY(SymbolPrimary, symbol),
+    [SYMBOL_TYPE_FNCALL] =
+        {
+            .size = sizeof(SymbolFncall),
+            .num_children = 1,
+            .children = {offsetof(SymbolFncall, primary)},
+            .payload = PAYLOAD_VECTOR,
+            .length = offsetof(SymbolFncall, num_arguments),
+            .capacity = offsetof(SymbolFncall, capacity),
+            .num_vectors = 1,
+            .vectors = {offsetof(SymbolFncall, arguments)},
+        },
+    [SYMBOL_TYPE_SUBSCRIPTION] =
+        BINARY(SymbolSubscription, primary, expression),
+    [SYMBOL_TYPE_SLICE] =
+        {
+            .size = sizeof(SymbolSlice),
+            .num_children = 3,
+            .children = {offsetof(SymbolSlice, primary),
+                         offsetof(SymbolSlice, left_expression),
+                         offsetof(SymbolSlice, right_expression)},
+        },
+    [SYMBOL_TYPE_ATOM] = UNARY(SymbolAtom, symbol),
+    [SYMBOL_TYPE_IDENTIFIER] = SCALAR(SymbolIdentifier, PAYLOAD_STRING),
+    [SYMBOL_TYPE_INTEGER_LITERAL] =
+        SCALAR(SymbolIntegerLiteral, PAYLOAD_INTEGER),
+    [SYMBOL_TYPE_FLOAT_LITERAL] = SCALAR(SymbolFloatLiteral, PAYLOAD_FLOAT),
+    [SYMBOL_TYPE_STRING_LITERAL] =
+        SCALAR(SymbolStringLiteral, PAYLOAD_STRING),
+    [SYMBOL_TYPE_BOOLEAN_LITERAL] =
+        SCALAR(SymbolBooleanLiteral, PAYLOAD_BOOLEAN),
+    [SYMBOL_TYPE_NONE_LITERAL] = {.size = sizeof(SymbolNoneLiteral)},
+    [SYMBOL_TYPE_DICT] =
+        {
+            .size = sizeof(SymbolDict),
+            .payload = PAYLOAD_VECTOR,
+            .length = offsetof(SymbolDict, num_entries),
+            .capacity = offsetof(SymbolDict, capacity),
+            .num_vectors = 2,
+            .vectors = {offsetof(SymbolDict, keys),
+                        offsetof(SymbolDict, values)},
+        },
+    [SYMBOL_TYPE_LIST] =
+        {
+            .size = sizeof(SymbolList),
+            .payload = PAYLOAD_VECTOR,
+            .length = offsetof(SymbolList, num_elements),
+            .capacity = offsetof(SymbolList, capacity),
+            .num_vectors = 1,
+            .vectors = {offsetof(SymbolList, elements)},
+        },
+};
+
+#define NUM_LAYOUTS (sizeof(LAYOUTS) / sizeof(LAYOUTS[0]))
+
+#define FIELD(symbol, offset, T) ((T *)((char *)(symbol) + (offset)))
+
+static const SymbolLayout *GetLayout(const size_t type) {
+  if (type >= NUM_LAYOUTS || LAYOUTS[type].size == 0) {
+    return NULL;
+  }
+  return &LAYOUTS[type];
+}
+
+/****************************************************************************/
+
+typedef struct {
+  const Symbol **symbols;
+  size_t length;
+  size_t capacity;
+} SymbolStack;
+
+static void PushEntry(SymbolStack *const stack, const Symbol *const symbol) {
+  if (stack->length >= stack->capacity) {
+    stack->capacity = (stack->capacity > 0) ? stack->capacity * 2 : 64;
+    stack->symbols =
+        xrealloc(stack->symbols, stack->capacity * sizeof(Symbol *));
+  }
+  stack->symbols[stack->length++] = symbol;
+}
+
+static void PushSymbol(SymbolStack *const stack, const Symbol *const symbol) {
+  if (symbol != NULL) {
+    PushEntry(stack, symbol);
+  }
+}
+
+/****************************************************************************/
+
+static void WriteBytes(Buffer *const buf, const void *const data,
+                       const size_t length) {
+  BufferPrintN(buf, (const char *)data, length);
+}
+
+static void WriteLength(Buffer *const buf, const size_t length) {
+  const uint64_t value = length;
+  WriteBytes(buf, &value, sizeof(value));
+}
+
+/**
+ * @brief Write a symbol without its children, and push the children.
+ * @param buf Buffer to append the symbol to.
+ * @param stack Stack that the children are pushed onto, in reverse order so
+ *              that they are popped and written in order. Missing children are
+ *              pushed as NULL, since they are written too.
+ * @param symbol The symbol, may be NULL.
+ * @note The payload comes right after the type and offset, so that the
+ *       reader knows the length of a vector before reading its elements.
+ */
+static void WriteSymbol(Buffer *const buf, SymbolStack *const stack,
+                        const Symbol *const symbol) {
+  if (symbol == NULL) {
+    const uint8_t type = SYMBOL_NULL;
+    WriteBytes(buf, &type, sizeof(type));
+    return;
+  }
+
+  const SymbolLayout *const layout = GetLayout(symbol->type);
+  if (layout == NULL) {
+    LOG_CRITICAL("Unexpected symbol type %d", symbol->type);
+  }
+
+  const uint8_t type = (uint8_t)symbol->type;
+  WriteBytes(buf, &type, sizeof(type));
+  WriteBytes(buf, &symbol->offset, sizeof(symbol->offset));
+
+  switch (layout->payload) {
+  case PAYLOAD_NONE:
+    break;
+
+  case PAYLOAD_STRING: {
+    const char *const value = *FIELD(symbol, layout->value, char *);
+    const size_t length = strlen(value);
+    WriteLength(buf, length);
+    WriteBytes(buf, value, length);
+  } break;
+
+  case PAYLOAD_INTEGER:
+    WriteBytes(buf, FIELD(symbol, layout->value, unsigned long long),
+               sizeof(unsigned long long));
+    break;
+
+  case PAYLOAD_FLOAT:
+    WriteBytes(buf, FIELD(symbol, layout->value, double), sizeof(double));
+    break;
+
+  case PAYLOAD_BOOLEAN: {
+    const uint8_t value = *FIELD(symbol, layout->value, bool) ? 1 : 0;
+    WriteBytes(buf, &value, sizeof(value));
+  } break;
+
+  case PAYLOAD_VECTOR: {
+    // Elements are written index by index, interleaving parallel vectors
+    const size_t length = *FIELD(symbol, layout->length, size_t);
+    WriteLength(buf, length);
+    for (size_t i = length; i > 0; i--) {
+      for (size_t j = layout->num_vectors; j > 0; j--) {
+        Symbol **const vector =
+            *FIELD(symbol, layout->vectors[j - 1], Symbol **);
+        PushEntry(stack, vector[i - 1]);
+      }
+    }
+  } break;
+  }
+
+  for (size_t i = layout->num_children; i > 0; i--) {
+    PushEntry(stack, *FIELD(symbol, layout->children[i - 1], Symbol *));
+  }
+}
+
+void SyntaxTreeSerialize(Buffer *const buf,
+                         const SymbolStatement *const statement) {
+  assert(buf != NULL);
+
+  /* Long chains of binary operators nest deeper than the call stack allows,
+   * hence the tree is written in pre-order with a stack of its own. */
+  SymbolStack stack = {0};
+  PushEntry(&stack, (const Symbol *)statement);
+  while (stack.length > 0) {
+    WriteSymbol(buf, &stack, stack.symbols[--stack.length]);
+  }
+
+  xfree(stack.symbols);
+}
+
+/****************************************************************************/
+
+void SyntaxTreeCountSymbols(const SymbolStatement *const statement,
+                            size_t *const counts) {
+  assert(counts != NULL);
+
+  /* Long chains of binary operators nest deeper than the call stack allows,
+   * hence the tree is walked with a stack of its own. */
+  SymbolStack stack = {0};
+  PushSymbol(&stack, (const Symbol *)statement);
+
+  while (stack.length > 0) {
+    const Symbol *const symbol = stack.symbols[--stack.length];
+    const SymbolLayout *const layout = GetLayout(symbol->type);
+    if (layout == NULL) {
+      LOG_CRITICAL("Unexpected symbol type %d", symbol->type);
+    }
+    counts[symbol->type] += 1;
+
+    for (size_t i = 0; i < layout->num_children; i++) {
+      PushSymbol(&stack, *FIELD(symbol, layout->children[i], Symbol *));
+    }
+
+    if (layout->payload == PAYLOAD_VECTOR) {
+      const size_t length = *FIELD(symbol, layout->length, size_t);
+      for (size_t j = 0; j < layout->num_vectors; j++) {
+        Symbol **const vector = *FIELD(symbol, layout->vectors[j], Symbol **);
+        for (size_t i = 0; i < length; i++) {
+          PushSymbol(&stack, vector[i]);
+        }
+      }
+    }
+  }
+
+  xfree(stack.symbols);
+}
+
+/****************************************************************************/
+
+typedef struct {
+  const unsigned char *data;
+  size_t length;
+  size_t offset;
+} Reader;
+
+static bool ReadBytes(Reader *const reader, void *const data,
+                      const size_t length) {
+  if (reader->length - reader->offset < length) {
+    return false;
+  }
+  memcpy(data, reader->data + reader->offset, length);
+  reader->offset += length;
+  return true;
+}
+
+/**
+ * @brief Read the length of a string or vector.
+ * @param reader The reader.
+ * @param length Is set to the length.
+ * @param unit Minimum number of bytes occupied by each element.
+ * @return False if the remaining data is too short to hold that many
+ *         elements, which prevents bogus lengths from causing huge
+ *         allocations.
+ */
+static bool ReadLength(Reader *const reader, size_t *const length,
+                       const size_t unit) {
+  uint64_t value;
+  if (!ReadBytes(reader, &value, sizeof(value))) {
+    return false;
+  }
+  if (value > (reader->length - reader->offset) / unit) {
+    return false;
+  }
+  *length = (size_t)value;
+  return true;
+}
+
+/**
+ * @brief Free a possibly incomplete symbol along with its children.
+ * @note Like SyntaxTreeCountSymbols(), the tree is walked with a stack of its
+ *       own. The children of a symbol are pushed before it is freed.
+ */
+static void FreeSymbol(Symbol *const root) {
+  SymbolStack stack = {0};
+  PushSymbol(&stack, root);
+
+  while (stack.length > 0) {
+    Symbol *const symbol = (Symbol *)stack.symbols[--stack.length];
+    const SymbolLayout *const layout = GetLayout(symbol->type);
+    assert(layout != NULL);
+
+    for (size_t i = 0; i < layout->num_children; i++) {
+      PushSymbol(&stack, *FIELD(symbol, layout->children[i], Symbol *));
+    }
+
+    if (layout->payload == PAYLOAD_STRING) {
+      xfree(*FIELD(symbol, layout->value, char *));
+    } else if (layout->payload == PAYLOAD_VECTOR) {
+      const size_t length = *FIELD(symbol, layout->length, size_t);
+      for (size_t j = 0; j < layout->num_vectors; j++) {
+        Symbol **const vector = *FIELD(symbol, layout->vectors[j], Symbol **);
+        if (vector != NULL) {
+          for (size_t i = 0; i < length; i++) {
+            PushSymbol(&stack, vector[i]);
+          }
+        }
+        xfree(vector);
+      }
+    }
+
+    PoolFree(symbol, layout->size);
+  }
+
+  xfree(stack.symbols);
+}
+
+void SyntaxTreeFree(Symbol *const symbol) { FreeSymbol(symbol); }
+
+/* The slots that symbols still have to be read into. Each slot is a child
+ * pointer or vector element of a symbol read earlier, which is thereby part
+ * of the tree as soon as it is allocated. */
+typedef struct {
+  Symbol ***slots;
+  size_t length;
+  size_t capacity;
+} SlotStack;
+
+static void PushSlot(SlotStack *const stack, Symbol **const slot) {
+  if (stack->length >= stack->capacity) {
+    stack->capacity = (stack->capacity > 0) ? stack->capacity * 2 : 64;
+    stack->slots = xrealloc(stack->slots, stack->capacity * sizeof(Symbol **));
+  }
+  stack->slots[stack->length++] = slot;
+}
+
+/**
+ * @brief Read a symbol without its children, and push the slots of the
+ *        children.
+ * @param reader The reader.
+ * @param stack Stack that the slots are pushed onto, in reverse order so
+ *              that they are popped and read in order.
+ * @param symbol Slot that is set to the symbol, or to NULL.
+ * @return False if the representation is truncated or malformed.
+ */
+static bool ReadSymbol(Reader *const reader, SlotStack *const stack,
+                       Symbol **const symbol) {
+  *symbol = NULL;
+
+  uint8_t type;
+  if (!ReadBytes(reader, &type, sizeof(type))) {
+    return false;
+  }
+  if (type == SYMBOL_NULL) {
+    return true;
+  }
+
+  const SymbolLayout *const layout = GetLayout(type);
+  if (layout == NULL) {
+    return false;
+  }
+
+  /* Zero the symbol up front, so that it can be freed by FreeSymbol() no
+   * matter where decoding fails. */
+  Symbol *const sym = PoolAlloc(layout->size);
+  memset(sym, 0, layout->size);
+  sym->type = (SymbolType)type;
+  *symbol = sym;
+
+  if (!ReadBytes(reader, &sym->offset, sizeof(sym->offset))) {
+    return false;
+  }
+
+  switch (layout->payload) {
+  case PAYLOAD_NONE:
+    break;
+
+  case PAYLOAD_STRING: {
+    size_t length;
+    if (!ReadLength(reader, &length, 1)) {
+      return false;
+    }
+    char *const value = xmalloc(length + 1);
+    ReadBytes(reader, value, length);
+    value[length] = '\0';
+    *FIELD(sym, layout->value, char *) = value;
+  } break;
+
+  case PAYLOAD_INTEGER:
+    if (!ReadBytes(reader, FIELD(sym, layout->value, unsigned long long),
+                   sizeof(unsigned long long))) {
+      return false;
+    }
+    break;
+
+  case PAYLOAD_FLOAT:
+    if (!ReadBytes(reader, FIELD(sym, layout->value, double),
+                   sizeof(double))) {
+      return false;
+    }
+    break;
+
+  case PAYLOAD_BOOLEAN: {
+    uint8_t value;
+    if (!ReadBytes(reader, &value, sizeof(value))) {
+      return false;
+    }
+    *FIELD(sym, layout->value, bool) = (value != 0);
+  } break;
+
+  case PAYLOAD_VECTOR: {
+    size_t length;
+    if (!ReadLength(reader, &length, layout->num_vectors)) {
+      return false;
+    }
+    if (length == 0) {
+      break;
+    }
+
+    for (size_t j = 0; j < layout->num_vectors; j++) {
+      Symbol **const vector = xmalloc(length * sizeof(Symbol *));
+      memset(vector, 0, length * sizeof(Symbol *));
+      *FIELD(sym, layout->vectors[j], Symbol **) = vector;
+    }
+    *FIELD(sym, layout->length, size_t) = length;
+    *FIELD(sym, layout->capacity, size_t) = length;
+
+    for (size_t i = length; i > 0; i--) {
+      for (size_t j = layout->num_vectors; j > 0; j--) {
+        Symbol **const vector = *FIELD(sym, layout->vectors[j - 1], Symbol **);
+        PushSlot(stack, &vector[i - 1]);
+      }
+    }
+  } break;
+  }
+
+  for (size_t i = layout->num_children; i > 0; i--) {
+    PushSlot(stack, FIELD(sym, layout->children[i - 1], Symbol *));
+  }
+  return true;
+}
+
+bool SyntaxTreeDeserialize(const void *const data, const size_t length,
+                           SymbolStatement **const statement) {
+  assert(data != NULL || length == 0);
+  assert(statement != NULL);
+
+  Reader reader = {
+      .data = (const unsigned char *)data,
+      .length = length,
+      .offset = 0,
+  };
+
+  /* Like the writer, the reader keeps a stack of its own. Slots that are not
+   * reached when decoding fails remain NULL. */
+  Symbol *symbol = NULL;
+  SlotStack stack = {0};
+  PushSlot(&stack, &symbol);
+
+  bool success = true;
+  while (success && stack.length > 0) {
+    success = ReadSymbol(&reader, &stack, stack.slots[--stack.length]);
+  }
+  xfree(stack.slots);
+
+  if (!success) {
+    FreeSymbol(symbol);
+    return false;
+  }
+
+  if (reader.offset != reader.length ||
+      (symbol != NULL && symbol->type != SYMBOL_TYPE_STATEMENT)) {
+    FreeSymbol(symbol);
+    return false;
+  }
+
+  *statement = (SymbolStatement *)symbol;
+  return true;
+}
@@ -0,0 +1,48 @@
+#ifndef _AETHER_SERIALIZE_H
+#define _AETHER_SERIALIZE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "../utils/buffer.h"
+#include "syntax.h"
+
+/**
+ * @brief Serialize a syntax tree into a compact binary representation.
+ * @param buf Buffer to append the representation to.
+ * @param statement Root of the syntax tree, may be NULL.
+ * @note The representation is a pre-order stream of symbols without any
+ *       pointers, hence it can be stored on disk and read back from any
+ *       address. It is not usable in place, SyntaxTreeDeserialize() rebuilds
+ *       the tree from it. It uses the byte order and type sizes of the host,
+ *       and is only meant to be read back on the host that wrote it.
+ */
+void SyntaxTreeSerialize(Buffer *buf, const SymbolStatement *statement);
+
+/**
+ * @brief Rebuild a syntax tree from its binary representation.
+ * @param data Binary representation produced by SyntaxTreeSerialize().
+ * @param length Length of the binary representation.
+ * @param statement Is set to the root of the rebuilt syntax tree, which may
+ *                  be NULL for an empty tree.
+ * @return False if the representation is truncated or malformed, in which
+ *         case nothing is allocated.
+ */
+bool SyntaxTreeDeserialize(const void *data, size_t length,
+                           SymbolStatement **statement);
+
+/**
+ * @brief Count the symbols of a syntax tree by type.
+ * @param statement Root of the syntax tree, may be NULL.
+ * @param counts Array of NUM_SYMBOL_TYPES counters, indexed by symbol type,
+ *               that the counts are added to.
+ */
+void SyntaxTreeCountSymbols(const SymbolStatement *statement, size_t *counts);
+
+/**
+ * @brief Free a syntax tree without walking it, see WalkSyntaxTree().
+ * @param symbol Root of the syntax tree, or of any subtree, may be NULL.
+ */
+void SyntaxTreeFree(Symbol *symbol);
+
+#endif // _AETHER_SERIALIZE_H
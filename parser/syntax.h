@@ -8,6 +8,7 @@
 /****************************************************************************/
 
 typedef struct ParserState ParserState;
+typedef struct LineTable LineTable; // See location.h
 
 // Statements
 typedef struct SymbolStatement SymbolStatement;
@@ -42,10 +43,7 @@ typedef struct SymbolNegate SymbolNegate;
 typedef struct SymbolPrimary SymbolPrimary;
 typedef struct SymbolFncall SymbolFncall;
 typedef struct SymbolDict SymbolDict;
-typedef struct SymbolEntries SymbolEntries;
 typedef struct SymbolList SymbolList;
-typedef struct SymbolElements SymbolElements;
-typedef struct SymbolArguments SymbolArguments;
 typedef struct SymbolSubscription SymbolSubscription;
 typedef struct SymbolSlice SymbolSlice;
 typedef struct SymbolAtom SymbolAtom;
@@ -93,7 +91,6 @@ typedef enum {
   SYMBOL_TYPE_NEGATE,
   SYMBOL_TYPE_PRIMARY,
   SYMBOL_TYPE_FNCALL,
-  SYMBOL_TYPE_ARGUMENTS,
   SYMBOL_TYPE_SUBSCRIPTION,
   SYMBOL_TYPE_SLICE,
   // Atoms
@@ -105,38 +102,63 @@ typedef enum {
   SYMBOL_TYPE_BOOLEAN_LITERAL,
   SYMBOL_TYPE_NONE_LITERAL,
   SYMBOL_TYPE_DICT,
-  SYMBOL_TYPE_ENTRIES,
   SYMBOL_TYPE_LIST,
-  SYMBOL_TYPE_ELEMENTS,
   SYMBOL_TYPE_INNER_EXPRESSION,
 } SymbolType;
 
+#define NUM_SYMBOL_TYPES (SYMBOL_TYPE_INNER_EXPRESSION + 1)
+
 struct ParserState {
   const char *filename;
-  int line;
-  int column;
+  int line;             // Line of the next character
+  uint32_t line_offset; // Offset of the first character of the line
+  uint32_t offset;      // Offset of the next character
   SymbolStatement *statement;
-};
-
+  /* If not NULL, each statement is handed to this function as soon as it is
+   * parsed, and the source may contain any number of statements. Otherwise,
+   * the source is a single statement, which is stored in statement. */
+  void (*on_statement)(SymbolStatement *statement);
+  LineTable *lines; // If not NULL, lines are added as they are lexed
+  /* If not NULL, the lexer reads its input through this function rather
+   * than from the source file. It returns the number of bytes stored in
+   * buf, at most size, or 0 at the end of the input. */
+  size_t (*read_input)(char *buf, size_t size);
+  bool interactive;   // Skip to the next ';' on syntax errors, do not exit
+  bool in_statement;  // Tokens of an unfinished statement have been read
+  size_t num_errors;  // Syntax errors reported while parsing
+  bool measure_lexer; // Accumulate the time spent in the lexer in lex_time
+  double lex_time;    // Seconds
+};
+
+/* Line and column of a symbol, see LineTableLookup(). Columns count bytes,
+ * starting at 1. */
 typedef struct {
   int line;
   int column;
 } SymbolLocation;
 
+/* Location type of the parser, i.e., of @n in parser.y. Symbols only store
+ * the byte offset of their first character into the source, and their line
+ * and column are computed on demand. Offsets beyond 4 GiB are saturated. */
+typedef struct {
+  uint32_t offset;
+} ParserLocation;
+
+#define YYLTYPE ParserLocation
+#define YYLTYPE_IS_DECLARED 1
+
 /****************************************************************************/
 
 typedef struct {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset; // Byte offset of the first character into the source
 } Symbol;
 
 /****************************************************************************/
 
 struct SymbolStatement {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -144,8 +166,7 @@ struct SymbolStatement {
 
 struct SymbolAssignment {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
   SymbolExpression *expression;
 };
@@ -154,8 +175,7 @@ struct SymbolAssignment {
 
 struct SymbolDeclaration {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
   SymbolIdentifier *identifier;
 };
@@ -164,8 +184,7 @@ struct SymbolDeclaration {
 
 struct SymbolReference {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -173,8 +192,7 @@ struct SymbolReference {
 
 struct SymbolMutable {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolDatatype *datatype;
 };
 
@@ -182,8 +200,7 @@ struct SymbolMutable {
 
 struct SymbolDatatype {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolIdentifier *identifier;
 };
 
@@ -191,8 +208,7 @@ struct SymbolDatatype {
 
 struct SymbolExpression {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -200,8 +216,7 @@ struct SymbolExpression {
 
 struct SymbolOr {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolExpression *expression;
   SymbolCondition *condition;
 };
@@ -210,8 +225,7 @@ struct SymbolOr {
 
 struct SymbolCondition {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -219,8 +233,7 @@ struct SymbolCondition {
 
 struct SymbolAnd {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolCondition *condition;
   SymbolComparison *comparison;
 };
@@ -229,8 +242,7 @@ struct SymbolAnd {
 
 struct SymbolComparison {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -238,8 +250,7 @@ struct SymbolComparison {
 
 struct SymbolLessThan {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolComparison *comparison;
   SymbolTerm *term;
 };
@@ -248,8 +259,7 @@ struct SymbolLessThan {
 
 struct SymbolGreaterThan {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolComparison *comparison;
   SymbolTerm *term;
 };
@@ -258,8 +268,7 @@ struct SymbolGreaterThan {
 
 struct SymbolEqual {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolComparison *comparison;
   SymbolTerm *term;
 };
@@ -268,8 +277,7 @@ struct SymbolEqual {
 
 struct SymbolLessEqual {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolComparison *comparison;
   SymbolTerm *term;
 };
@@ -278,8 +286,7 @@ struct SymbolLessEqual {
 
 struct SymbolGreaterEqual {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolComparison *comparison;
   SymbolTerm *term;
 };
@@ -288,8 +295,7 @@ struct SymbolGreaterEqual {
 
 struct SymbolNotEqual {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolComparison *comparison;
   SymbolTerm *term;
 };
@@ -298,8 +304,7 @@ struct SymbolNotEqual {
 
 struct SymbolTerm {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -307,8 +312,7 @@ struct SymbolTerm {
 
 struct SymbolAdd {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolTerm *term;
   SymbolFactor *factor;
 };
@@ -317,8 +321,7 @@ struct SymbolAdd {
 
 struct SymbolSubtract {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolTerm *term;
   SymbolFactor *factor;
 };
@@ -327,8 +330,7 @@ struct SymbolSubtract {
 
 struct SymbolFactor {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -336,8 +338,7 @@ struct SymbolFactor {
 
 struct SymbolMultiply {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolFactor *factor;
   SymbolUnary *unary;
 };
@@ -346,8 +347,7 @@ struct SymbolMultiply {
 
 struct SymbolDivide {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolFactor *factor;
   SymbolUnary *unary;
 };
@@ -356,8 +356,7 @@ struct SymbolDivide {
 
 struct SymbolModulo {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolFactor *factor;
   SymbolUnary *unary;
 };
@@ -366,8 +365,7 @@ struct SymbolModulo {
 
 struct SymbolUnary {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -375,8 +373,7 @@ struct SymbolUnary {
 
 struct SymbolMinus {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolUnary *unary;
 };
 
@@ -384,8 +381,7 @@ struct SymbolMinus {
 
 struct SymbolNegate {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolUnary *unary;
 };
 
@@ -393,8 +389,7 @@ struct SymbolNegate {
 
 struct SymbolPrimary {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -402,67 +397,39 @@ struct SymbolPrimary {
 
 struct SymbolFncall {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolPrimary *primary;
-  SymbolArguments *arguments;
+  size_t num_arguments;
+  size_t capacity;
+  SymbolExpression **arguments;
 };
 
 /****************************************************************************/
 
 struct SymbolDict {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
-  SymbolEntries *entries;
-};
-
-/****************************************************************************/
-
-struct SymbolEntries {
-  SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
-  SymbolEntries *entries;
-  SymbolStringLiteral *string_literal;
-  SymbolExpression *expression;
+  uint32_t offset;
+  size_t num_entries;
+  size_t capacity;
+  SymbolStringLiteral **keys;
+  SymbolExpression **values;
 };
 
 /****************************************************************************/
 
 struct SymbolList {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
-  SymbolElements *elements;
-};
-
-/****************************************************************************/
-
-struct SymbolElements {
-  SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
-  SymbolElements *elements;
-  SymbolExpression *expression;
-};
-
-/****************************************************************************/
-
-struct SymbolArguments {
-  SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
-  SymbolArguments *arguments;
-  SymbolExpression *expression;
+  uint32_t offset;
+  size_t num_elements;
+  size_t capacity;
+  SymbolExpression **elements;
 };
 
 /****************************************************************************/
 
 struct SymbolSubscription {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolPrimary *primary;
   SymbolExpression *expression;
 };
@@ -471,8 +438,7 @@ struct SymbolSubscription {
 
 struct SymbolSlice {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   SymbolPrimary *primary;
   SymbolExpression *left_expression;
   SymbolExpression *right_expression;
@@ -482,8 +448,7 @@ struct SymbolSlice {
 
 struct SymbolAtom {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   Symbol *symbol;
 };
 
@@ -491,8 +456,7 @@ struct SymbolAtom {
 
 struct SymbolIdentifier {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   char *value;
 };
 
@@ -500,8 +464,7 @@ struct SymbolIdentifier {
 
 struct SymbolIntegerLiteral {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   unsigned long long value;
 };
 
@@ -509,8 +472,7 @@ struct SymbolIntegerLiteral {
 
 struct SymbolFloatLiteral {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   double value;
 };
 
@@ -518,8 +480,7 @@ struct SymbolFloatLiteral {
 
 struct SymbolStringLiteral {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   char *value;
 };
 
@@ -527,8 +488,7 @@ struct SymbolStringLiteral {
 
 struct SymbolBooleanLiteral {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
   bool value;
 };
 
@@ -536,8 +496,7 @@ struct SymbolBooleanLiteral {
 
 struct SymbolNoneLiteral {
   SymbolType type;
-  SymbolLocation first;
-  SymbolLocation last;
+  uint32_t offset;
 };
 
 #endif // _AETHER_SYNTAX_H
@@ -0,0 +1,112 @@
+#include "../tests/check.h"
+#include "cache.c"
+#include "serialize.c"
+
+static char DIRECTORY[] = "/tmp/test_cache.XXXXXX";
+static char SOURCE[sizeof(DIRECTORY) + 16];
+
+static void SetUp(const char *const content) {
+  check(mkdtemp(DIRECTORY) != NULL);
+  check(setenv("XDG_CACHE_HOME", DIRECTORY, 1) == 0);
+
+  snprintf(SOURCE, sizeof(SOURCE), "%s/source.ae", DIRECTORY);
+  FILE *const file = fopen(SOURCE, "w");
+  check(file != NULL);
+  check(fputs(content, file) >= 0);
+  check(fclose(file) == 0);
+}
+
+static void TearDown(void) {
+  char *const command = StringFormat("rm -rf '%s'", DIRECTORY);
+  check(system(command) == 0);
+  free(command);
+}
+
+static SymbolStatement *NewStatement(const uint32_t offset) {
+  SymbolNoneLiteral *const none = PoolAlloc(sizeof(SymbolNoneLiteral));
+  memset(none, 0, sizeof(SymbolNoneLiteral));
+  none->type = SYMBOL_TYPE_NONE_LITERAL;
+
+  SymbolStatement *const statement = PoolAlloc(sizeof(SymbolStatement));
+  memset(statement, 0, sizeof(SymbolStatement));
+  statement->type = SYMBOL_TYPE_STATEMENT;
+  statement->offset = offset;
+  statement->symbol = (Symbol *)none;
+  return statement;
+}
+
+static void FreeStatement(SymbolStatement *const statement) {
+  PoolFree(statement->symbol, sizeof(SymbolNoneLiteral));
+  PoolFree(statement, sizeof(SymbolStatement));
+}
+
+static void test_CacheLoad(void) {
+  SetUp("none;\n");
+
+  SymbolStatement *statement = NULL;
+  CacheEntry *entry = CacheOpen(SOURCE);
+  check(entry != NULL);
+  check(strncmp(entry->cache_path, DIRECTORY, strlen(DIRECTORY)) == 0);
+  check(!CacheLoad(entry, &statement));
+
+  SymbolStatement *const original = NewStatement(42);
+  CacheStore(entry, original);
+  FreeStatement(original);
+  CacheClose(entry);
+
+  entry = CacheOpen(SOURCE);
+  check(CacheLoad(entry, &statement));
+  check(statement->type == SYMBOL_TYPE_STATEMENT);
+  check(statement->offset == 42);
+  check(statement->symbol->type == SYMBOL_TYPE_NONE_LITERAL);
+  FreeStatement(statement);
+
+  // The empty syntax tree is cached as well
+  CacheStore(entry, NULL);
+  check(CacheLoad(entry, &statement));
+  check(statement == NULL);
+  CacheClose(entry);
+
+  TearDown();
+}
+
+static void test_CacheStale(void) {
+  SetUp("none;\n");
+
+  CacheEntry *entry = CacheOpen(SOURCE);
+  SymbolStatement *statement = NewStatement(1);
+  CacheStore(entry, statement);
+  FreeStatement(statement);
+  CacheClose(entry);
+
+  // Same size, but different content and modification time
+  FILE *const file = fopen(SOURCE, "w");
+  check(file != NULL);
+  check(fputs("true;\n", file) >= 0);
+  check(fclose(file) == 0);
+
+  entry = CacheOpen(SOURCE);
+  check(!CacheLoad(entry, &statement));
+  CacheClose(entry);
+
+  // Corrupt the syntax tree at the end of the cache file
+  entry = CacheOpen(SOURCE);
+  statement = NewStatement(1);
+  CacheStore(entry, statement);
+  FreeStatement(statement);
+  struct stat sb;
+  check(stat(entry->cache_path, &sb) == 0);
+  const int fd = open(entry->cache_path, O_WRONLY);
+  check(fd >= 0);
+  check(pwrite(fd, "x", 1, sb.st_size - 1) == 1);
+  check(close(fd) == 0);
+  check(!CacheLoad(entry, &statement));
+  CacheClose(entry);
+
+  TearDown();
+}
+
+CHECK_BEGIN
+CHECK_ADD("CacheLoad", test_CacheLoad)
+CHECK_ADD("CacheStale", test_CacheStale)
+CHECK_END
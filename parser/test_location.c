@@ -0,0 +1,118 @@
+#include "../tests/check.h"
+#include "location.c"
+
+#include <stdio.h>
+#include <unistd.h>
+
+static void test_LineTableLookup(void) {
+  static const char SOURCE[] = "a = 1;\n\n  b = a;\nc";
+
+  LineTable lines;
+  LineTableInit(&lines);
+  LineTableScan(&lines, SOURCE, sizeof(SOURCE) - 1);
+  check(lines.num_lines == 4);
+
+  SymbolLocation location = LineTableLookup(&lines, 0);
+  check(location.line == 1 && location.column == 1);
+  location = LineTableLookup(&lines, 4);
+  check(location.line == 1 && location.column == 5);
+  location = LineTableLookup(&lines, 6); // Newline belongs to its line
+  check(location.line == 1 && location.column == 7);
+  location = LineTableLookup(&lines, 7);
+  check(location.line == 2 && location.column == 1);
+  location = LineTableLookup(&lines, 10);
+  check(location.line == 3 && location.column == 3);
+  location = LineTableLookup(&lines, 17);
+  check(location.line == 4 && location.column == 1);
+  location = LineTableLookup(&lines, UINT32_MAX);
+  check(location.line == 4);
+
+  LineTableDeinit(&lines);
+  check(lines.starts == NULL && lines.num_lines == 0);
+
+  // An empty line table treats offsets as columns of the first line
+  location = LineTableLookup(&lines, 41);
+  check(location.line == 1 && location.column == 42);
+}
+
+static void test_LineTableScan(void) {
+  LineTable lines;
+  LineTableInit(&lines);
+  LineTableScan(&lines, "", 0);
+  check(lines.num_lines == 1 && lines.starts[0] == 0);
+  LineTableDeinit(&lines);
+
+  // Grows past its initial capacity
+  Buffer buf;
+  BufferInit(&buf);
+  for (int i = 0; i < 1000; i++) {
+    BufferPrint(&buf, "x\n");
+  }
+  LineTableScan(&lines, BufferData(&buf), BufferLength(&buf));
+  check(lines.num_lines == 1001);
+  for (size_t i = 0; i < lines.num_lines; i++) {
+    check(lines.starts[i] == 2 * i);
+  }
+  const SymbolLocation location = LineTableLookup(&lines, 1999);
+  check(location.line == 1000 && location.column == 2);
+  LineTableDeinit(&lines);
+  BufferDeinit(&buf);
+}
+
+static void test_LineTableDiscard(void) {
+  LineTable lines;
+  LineTableInit(&lines);
+  LineTableDiscard(&lines, 0);
+  for (uint32_t start = 0; start < 100; start += 10) {
+    LineTableAppend(&lines, start);
+  }
+
+  // The line containing the offset is kept, along with its number
+  LineTableDiscard(&lines, 35);
+  check(lines.num_lines == 7 && lines.starts[0] == 30);
+  SymbolLocation location = LineTableLookup(&lines, 35);
+  check(location.line == 4 && location.column == 6);
+  location = LineTableLookup(&lines, 95);
+  check(location.line == 10 && location.column == 6);
+
+  LineTableDiscard(&lines, 30);
+  check(lines.num_lines == 7);
+  LineTableDiscard(&lines, UINT32_MAX);
+  check(lines.num_lines == 1 && lines.starts[0] == 90);
+
+  // Lines appended afterwards continue the numbering
+  LineTableAppend(&lines, 100);
+  location = LineTableLookup(&lines, 101);
+  check(location.line == 11 && location.column == 2);
+
+  LineTableDeinit(&lines);
+}
+
+static void test_LineTableReadFile(void) {
+  char filename[] = "/tmp/test_location.XXXXXX";
+  const int fd = mkstemp(filename);
+  check(fd >= 0);
+  FILE *const file = fdopen(fd, "w");
+  check(file != NULL);
+  check(fputs("x;\ny;\n", file) >= 0);
+  check(fclose(file) == 0);
+
+  LineTable lines;
+  LineTableInit(&lines);
+  check(LineTableReadFile(&lines, filename));
+  check(lines.num_lines == 3);
+  const SymbolLocation location = LineTableLookup(&lines, 3);
+  check(location.line == 2 && location.column == 1);
+  LineTableDeinit(&lines);
+
+  check(unlink(filename) == 0);
+  check(!LineTableReadFile(&lines, filename));
+  check(lines.num_lines == 0);
+}
+
+CHECK_BEGIN
+CHECK_ADD("LineTableLookup", test_LineTableLookup)
+CHECK_ADD("LineTableScan", test_LineTableScan)
+CHECK_ADD("LineTableDiscard", test_LineTableDiscard)
+CHECK_ADD("LineTableReadFile", test_LineTableReadFile)
+CHECK_END
@@ -0,0 +1,244 @@
+#include "../tests/check.h"
+#include "serialize.c"
+
+#include "../utils/string_lib.h"
+
+static void *NewSymbol(const SymbolType type, const uint32_t offset) {
+  Symbol *const symbol = PoolAlloc(LAYOUTS[type].size);
+  memset(symbol, 0, LAYOUTS[type].size);
+  symbol->type = type;
+  symbol->offset = offset;
+  return symbol;
+}
+
+/* Builds the tree for `foo("bar \"baz\"\n", x[1:], {"k": true}, [], 3.14,
+ * none)`, leaving out the symbols that only wrap a single child. */
+static SymbolStatement *NewSyntaxTree(void) {
+  SymbolIdentifier *const foo = NewSymbol(SYMBOL_TYPE_IDENTIFIER, 1);
+  foo->value = StringDuplicate("foo");
+  SymbolPrimary *const primary = NewSymbol(SYMBOL_TYPE_PRIMARY, 1);
+  primary->symbol = (Symbol *)foo;
+
+  SymbolFncall *const fncall = NewSymbol(SYMBOL_TYPE_FNCALL, 1);
+  fncall->primary = primary;
+  fncall->capacity = 8;
+  fncall->arguments = xmalloc(fncall->capacity * sizeof(SymbolExpression *));
+
+  SymbolStringLiteral *const bar = NewSymbol(SYMBOL_TYPE_STRING_LITERAL, 2);
+  bar->value = StringDuplicate("bar \"baz\"\n");
+  fncall->arguments[fncall->num_arguments++] = (SymbolExpression *)bar;
+
+  SymbolIdentifier *const x = NewSymbol(SYMBOL_TYPE_IDENTIFIER, 3);
+  x->value = StringDuplicate("x");
+  SymbolPrimary *const x_primary = NewSymbol(SYMBOL_TYPE_PRIMARY, 3);
+  x_primary->symbol = (Symbol *)x;
+  SymbolIntegerLiteral *const one = NewSymbol(SYMBOL_TYPE_INTEGER_LITERAL, 3);
+  one->value = 1;
+  SymbolSlice *const slice = NewSymbol(SYMBOL_TYPE_SLICE, 3);
+  slice->primary = x_primary;
+  slice->left_expression = (SymbolExpression *)one;
+  fncall->arguments[fncall->num_arguments++] = (SymbolExpression *)slice;
+
+  SymbolDict *const dict = NewSymbol(SYMBOL_TYPE_DICT, 4);
+  dict->capacity = 1;
+  dict->num_entries = 1;
+  dict->keys = xmalloc(sizeof(SymbolStringLiteral *));
+  dict->keys[0] = NewSymbol(SYMBOL_TYPE_STRING_LITERAL, 4);
+  dict->keys[0]->value = StringDuplicate("k");
+  dict->values = xmalloc(sizeof(SymbolExpression *));
+  SymbolBooleanLiteral *const yes = NewSymbol(SYMBOL_TYPE_BOOLEAN_LITERAL, 4);
+  yes->value = true;
+  dict->values[0] = (SymbolExpression *)yes;
+  fncall->arguments[fncall->num_arguments++] = (SymbolExpression *)dict;
+
+  SymbolList *const list = NewSymbol(SYMBOL_TYPE_LIST, 5);
+  fncall->arguments[fncall->num_arguments++] = (SymbolExpression *)list;
+
+  SymbolFloatLiteral *const pi = NewSymbol(SYMBOL_TYPE_FLOAT_LITERAL, 6);
+  pi->value = 3.14;
+  fncall->arguments[fncall->num_arguments++] = (SymbolExpression *)pi;
+
+  fncall->arguments[fncall->num_arguments++] =
+      NewSymbol(SYMBOL_TYPE_NONE_LITERAL, 7);
+
+  SymbolStatement *const statement = NewSymbol(SYMBOL_TYPE_STATEMENT, 1);
+  statement->symbol = (Symbol *)fncall;
+  return statement;
+}
+
+static void test_SyntaxTreeSerialize(void) {
+  SymbolStatement *const statement = NewSyntaxTree();
+  Buffer expected;
+  BufferInit(&expected);
+  SyntaxTreeSerialize(&expected, statement);
+  FreeSymbol((Symbol *)statement);
+
+  SymbolStatement *copy;
+  check(SyntaxTreeDeserialize(BufferData(&expected), BufferLength(&expected),
+                              &copy));
+  check(copy->type == SYMBOL_TYPE_STATEMENT);
+
+  const SymbolFncall *const fncall = (SymbolFncall *)copy->symbol;
+  check(fncall->type == SYMBOL_TYPE_FNCALL);
+  check(fncall->num_arguments == 6);
+  check(fncall->capacity == 6);
+  const SymbolIdentifier *const foo =
+      (SymbolIdentifier *)fncall->primary->symbol;
+  check(strcmp(foo->value, "foo") == 0);
+  check(foo->offset == 1);
+
+  const SymbolStringLiteral *const bar =
+      (SymbolStringLiteral *)fncall->arguments[0];
+  check(strcmp(bar->value, "bar \"baz\"\n") == 0);
+
+  const SymbolSlice *const slice = (SymbolSlice *)fncall->arguments[1];
+  check(slice->left_expression != NULL);
+  check(((SymbolIntegerLiteral *)slice->left_expression)->value == 1);
+  check(slice->right_expression == NULL);
+
+  const SymbolDict *const dict = (SymbolDict *)fncall->arguments[2];
+  check(dict->num_entries == 1);
+  check(strcmp(dict->keys[0]->value, "k") == 0);
+  check(((SymbolBooleanLiteral *)dict->values[0])->value);
+
+  const SymbolList *const list = (SymbolList *)fncall->arguments[3];
+  check(list->num_elements == 0 && list->elements == NULL);
+  check(((SymbolFloatLiteral *)fncall->arguments[4])->value == 3.14);
+  check(fncall->arguments[5]->type == SYMBOL_TYPE_NONE_LITERAL);
+  check(fncall->arguments[5]->offset == 7);
+
+  // Serializing the copy must reproduce the exact same bytes
+  Buffer actual;
+  BufferInit(&actual);
+  SyntaxTreeSerialize(&actual, copy);
+  check(BufferLength(&actual) == BufferLength(&expected));
+  check(memcmp(BufferData(&actual), BufferData(&expected),
+               BufferLength(&actual)) == 0);
+
+  FreeSymbol((Symbol *)copy);
+  BufferDeinit(&actual);
+  BufferDeinit(&expected);
+}
+
+static void test_SyntaxTreeDeserialize(void) {
+  Buffer buf;
+  BufferInit(&buf);
+
+  // The empty syntax tree
+  SyntaxTreeSerialize(&buf, NULL);
+  SymbolStatement *statement;
+  check(SyntaxTreeDeserialize(BufferData(&buf), BufferLength(&buf),
+                              &statement));
+  check(statement == NULL);
+  BufferClear(&buf);
+
+  statement = NewSyntaxTree();
+  SyntaxTreeSerialize(&buf, statement);
+  FreeSymbol((Symbol *)statement);
+
+  // Every truncation is detected, without leaking the partial tree
+  for (size_t i = 0; i < BufferLength(&buf); i++) {
+    check(!SyntaxTreeDeserialize(BufferData(&buf), i, &statement));
+  }
+
+  // So is trailing garbage
+  BufferAppend(&buf, '\0');
+  check(!SyntaxTreeDeserialize(BufferData(&buf), BufferLength(&buf),
+                               &statement));
+
+  // And symbols that are not allowed at the root
+  const uint8_t type = SYMBOL_TYPE_NONE_LITERAL;
+  BufferClear(&buf);
+  BufferPrintN(&buf, (const char *)&type, sizeof(type));
+  const uint32_t offset = 0;
+  BufferPrintN(&buf, (const char *)&offset, sizeof(offset));
+  check(!SyntaxTreeDeserialize(BufferData(&buf), BufferLength(&buf),
+                               &statement));
+
+  BufferDeinit(&buf);
+}
+
+static void test_SyntaxTreeCountSymbols(void) {
+  size_t counts[NUM_SYMBOL_TYPES] = {0};
+  SyntaxTreeCountSymbols(NULL, counts);
+  for (size_t i = 0; i < NUM_SYMBOL_TYPES; i++) {
+    check(counts[i] == 0);
+  }
+
+  SymbolStatement *const statement = NewSyntaxTree();
+  SyntaxTreeCountSymbols(statement, counts);
+  SyntaxTreeCountSymbols(statement, counts);
+  FreeSymbol((Symbol *)statement);
+
+  check(counts[SYMBOL_TYPE_STATEMENT] == 2);
+  check(counts[SYMBOL_TYPE_FNCALL] == 2);
+  check(counts[SYMBOL_TYPE_PRIMARY] == 4);
+  check(counts[SYMBOL_TYPE_IDENTIFIER] == 4);
+  check(counts[SYMBOL_TYPE_STRING_LITERAL] == 4);
+  check(counts[SYMBOL_TYPE_BOOLEAN_LITERAL] == 2);
+  check(counts[SYMBOL_TYPE_NONE_LITERAL] == 2);
+  check(counts[SYMBOL_TYPE_EXPRESSION] == 0);
+}
+
+static void test_SyntaxTreeSerializeDeep(void) {
+  /* A chain of 100k additions nests far deeper than the call stack would
+   * allow a recursive writer or reader to go. */
+  const size_t n_operators = 100000;
+  SymbolIdentifier *const x = NewSymbol(SYMBOL_TYPE_IDENTIFIER, 0);
+  x->value = StringDuplicate("x");
+  Symbol *chain = (Symbol *)x;
+  for (size_t i = 0; i < n_operators; i++) {
+    SymbolIntegerLiteral *const literal =
+        NewSymbol(SYMBOL_TYPE_INTEGER_LITERAL, (uint32_t)i);
+    literal->value = i;
+    SymbolAdd *const add = NewSymbol(SYMBOL_TYPE_ADD, (uint32_t)i);
+    add->term = (SymbolTerm *)chain;
+    add->factor = (SymbolFactor *)literal;
+    chain = (Symbol *)add;
+  }
+  SymbolStatement *const statement = NewSymbol(SYMBOL_TYPE_STATEMENT, 0);
+  statement->symbol = chain;
+
+  Buffer expected;
+  BufferInit(&expected);
+  SyntaxTreeSerialize(&expected, statement);
+
+  SymbolStatement *copy;
+  check(SyntaxTreeDeserialize(BufferData(&expected), BufferLength(&expected),
+                              &copy));
+
+  size_t counts[NUM_SYMBOL_TYPES] = {0};
+  SyntaxTreeCountSymbols(copy, counts);
+  check(counts[SYMBOL_TYPE_ADD] == n_operators);
+  check(counts[SYMBOL_TYPE_INTEGER_LITERAL] == n_operators);
+  check(counts[SYMBOL_TYPE_IDENTIFIER] == 1);
+
+  // The innermost operator comes out of the round trip intact
+  const Symbol *symbol = copy->symbol;
+  for (size_t i = 1; i < n_operators; i++) {
+    symbol = (const Symbol *)((const SymbolAdd *)symbol)->term;
+  }
+  const SymbolAdd *const innermost = (const SymbolAdd *)symbol;
+  check(innermost->type == SYMBOL_TYPE_ADD);
+  check(((SymbolIntegerLiteral *)innermost->factor)->value == 0);
+  check(strcmp(((SymbolIdentifier *)innermost->term)->value, "x") == 0);
+
+  Buffer actual;
+  BufferInit(&actual);
+  SyntaxTreeSerialize(&actual, copy);
+  check(BufferLength(&actual) == BufferLength(&expected));
+  check(memcmp(BufferData(&actual), BufferData(&expected),
+               BufferLength(&actual)) == 0);
+
+  FreeSymbol((Symbol *)statement);
+  FreeSymbol((Symbol *)copy);
+  BufferDeinit(&actual);
+  BufferDeinit(&expected);
+}
+
+CHECK_BEGIN
+CHECK_ADD("SyntaxTreeSerialize", test_SyntaxTreeSerialize)
+CHECK_ADD("SyntaxTreeDeserialize", test_SyntaxTreeDeserialize)
+CHECK_ADD("SyntaxTreeCountSymbols", test_SyntaxTreeCountSymbols)
+CHECK_ADD("SyntaxTreeSerializeDeep", test_SyntaxTreeSerializeDeep)
+CHECK_END
@@ -0,0 +1,170 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  const char *const name;
+  void (*func)(size_t n);
+  void (*sized_func)(size_t n, size_t size);
+} Bench;
+
+/* Sink for benchmark results, which keeps the compiler from optimizing away
+ * the work being measured. */
+static volatile size_t BENCH_SINK;
+
+/* Sizes that sized benchmarks are run with, e.g., the number of entries in the
+ * container being operated on, or the length of the string being formatted. */
+static const size_t BENCH_SIZES[] = {16, 256, 4096, 65536};
+
+/* Number of calls to malloc(3), calloc(3) and realloc(3), and the number of
+ * bytes requested by them. They are only counted with the GNU C Library, which
+ * lets a program replace the allocator by defining these functions itself. */
+static size_t _bench_allocs;
+static size_t _bench_alloc_bytes;
+
+#ifdef __GLIBC__
+#define BENCH_COUNTS_ALLOCS true
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(const size_t size) {
+  _bench_allocs += 1;
+  _bench_alloc_bytes += size;
+  return __libc_malloc(size);
+}
+
+void *calloc(const size_t nmemb, const size_t size) {
+  _bench_allocs += 1;
+  _bench_alloc_bytes += nmemb * size;
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *const ptr, const size_t size) {
+  _bench_allocs += 1;
+  _bench_alloc_bytes += size;
+  return __libc_realloc(ptr, size);
+}
+#else
+#define BENCH_COUNTS_ALLOCS false
+#endif
+
+static double _bench_start;
+static size_t _bench_start_allocs;
+static size_t _bench_start_alloc_bytes;
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+/* Excludes everything done so far from the measurement. Benchmarks call this
+ * after setting up the data they operate on. */
+static void BenchResetTimer(void) {
+  _bench_start_allocs = _bench_allocs;
+  _bench_start_alloc_bytes = _bench_alloc_bytes;
+  _bench_start = _bench_now();
+}
+
+/* Runs the benchmark with a doubling number of operations until a single run
+ * takes at least 100 milliseconds, and reports the time, allocations and
+ * allocated bytes per operation. */
+static void _bench_run(const Bench *const bench, const size_t size,
+                       const bool json) {
+  for (size_t n = 1;; n *= 2) {
+    BenchResetTimer();
+    if (bench->sized_func != NULL) {
+      bench->sized_func(n, size);
+    } else {
+      bench->func(n);
+    }
+    const double elapsed = _bench_now() - _bench_start;
+    if (elapsed < 1e8 && n < ((size_t)1 << 40)) {
+      continue;
+    }
+
+    const double ns_per_op = elapsed / (double)n;
+    const double allocs_per_op =
+        (double)(_bench_allocs - _bench_start_allocs) / (double)n;
+    const double bytes_per_op =
+        (double)(_bench_alloc_bytes - _bench_start_alloc_bytes) / (double)n;
+
+    if (json) {
+      printf("{\"name\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+             "\"ns_per_op\": %.2f, \"ops_per_sec\": %.0f",
+             bench->name, size, n, ns_per_op, 1e9 / ns_per_op);
+      if (BENCH_COUNTS_ALLOCS) {
+        printf(", \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f",
+               allocs_per_op, bytes_per_op);
+      }
+      printf("}\n");
+      return;
+    }
+
+    char label[64];
+    if (bench->sized_func != NULL) {
+      snprintf(label, sizeof(label), "%s/%zu", bench->name, size);
+    } else {
+      snprintf(label, sizeof(label), "%s", bench->name);
+    }
+    printf("%-32s %12zu %12.2f ns/op %14.0f ops/s", label, n, ns_per_op,
+           1e9 / ns_per_op);
+    if (BENCH_COUNTS_ALLOCS) {
+      printf(" %10.2f allocs/op %12.1f B/op", allocs_per_op, bytes_per_op);
+    }
+    printf("\n");
+    return;
+  }
+}
+
+/* Usage: bench_X [--json] [NAME[/SIZE]]
+ *
+ * With --json, each result is printed as a JSON object on a line of its own.
+ * Size is zero for benchmarks that are not sized. */
+static int _bench_main(int argc, char *argv[], const Bench *const benches) {
+  bool json = false;
+  if (argc > 1 && strcmp(argv[1], "--json") == 0) {
+    json = true;
+    argc -= 1;
+    argv += 1;
+  }
+  const char *const filter = (argc > 1) ? argv[1] : NULL;
+
+  for (const Bench *bench = benches; bench->name != NULL; bench++) {
+    if (bench->sized_func == NULL) {
+      if (filter == NULL || strcmp(bench->name, filter) == 0) {
+        _bench_run(bench, 0, json);
+      }
+      continue;
+    }
+
+    for (size_t i = 0; i < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); i++) {
+      char label[64];
+      snprintf(label, sizeof(label), "%s/%zu", bench->name, BENCH_SIZES[i]);
+      if (filter == NULL || strcmp(bench->name, filter) == 0 ||
+          strcmp(label, filter) == 0) {
+        _bench_run(bench, BENCH_SIZES[i], json);
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+#define BENCH_BEGIN                                                            \
+  int main(int argc, char *argv[]) {                                           \
+    const Bench b[] = {
+
+#define BENCH_ADD(name, func) {name, func, NULL},
+
+#define BENCH_ADD_SIZED(name, func) {name, NULL, func},
+
+#define BENCH_END                                                              \
+  { NULL, NULL, NULL }                                                         \
+  }                                                                            \
+  ;                                                                            \
+  return _bench_main(argc, argv, b);                                           \
+  }
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Measures the throughput of the lexer of aether over a large generated
+# source.
+#
+# Usage: bench_lex.sh AETHER [SIZE]
+#
+# The source is a single list literal of roughly SIZE megabytes (default 100)
+# that mixes every kind of token with whitespace and comments, in the
+# proportions of the benchmark corpus (see progs/generate.sh). It is lexed
+# with --stop-after=lex, and the result is the fastest of BENCH_RUNS runs
+# (default 5), after subtracting the startup time of aether.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 AETHER [SIZE]" >&2
+    exit 1
+fi
+aether="$1"
+size="${2:-100}"
+runs="${BENCH_RUNS:-5}"
+
+case "$(date +%N)" in
+    *N*)
+        echo "$0: date(1) does not support nanoseconds (%N)" >&2
+        exit 1
+        ;;
+esac
+
+source=$(mktemp)
+empty=$(mktemp)
+trap 'rm -f "$source" "$empty"' EXIT
+
+awk -v size=$((size * 1024 * 1024)) 'BEGIN {
+    print "# Every kind of token, repeated"
+    print "values = ["
+    bytes = 0
+    for (i = 0; bytes < size; i++) {
+        line = sprintf("    %d, %d.%d, \"item %d: \\\"quoted\\\"\", name%d, %s, none, # entry %d",
+                       i * 7919, i % 1000, i % 97, i, i % 64, (i % 3 == 0) ? "false" : "true", i)
+        if (i % 4 == 0) {
+            line = line sprintf("\n    (a%d + b) * c <= d && e != f || !g,", i % 16)
+        }
+        print line
+        bytes += length(line) + 1
+    }
+    print "    0];"
+}' > "$source"
+
+# Prints the fastest of $runs runs of aether in nanoseconds
+measure() {
+    best=
+    i=0
+    while [ $i -lt "$runs" ]; do
+        start=$(date +%s%N)
+        "$aether" --stop-after=lex "$1" > /dev/null
+        end=$(date +%s%N)
+        elapsed=$((end - start))
+        if [ -z "$best" ] || [ $elapsed -lt $best ]; then
+            best=$elapsed
+        fi
+        i=$((i + 1))
+    done
+    echo "$best"
+}
+
+bytes=$(wc -c < "$source")
+startup=$(measure "$empty")
+elapsed=$(measure "$source")
+
+awk -v bytes="$bytes" -v ns="$((elapsed - startup))" 'BEGIN {
+    mb = bytes / (1024 * 1024)
+    printf "Lexed %.1f MB in %.3f s (%.1f MB/s)\n", mb, ns / 1e9, mb / (ns / 1e9)
+}'
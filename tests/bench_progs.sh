@@ -0,0 +1,113 @@
+#!/bin/sh
+#
+# Times the phases of aether over a benchmark corpus and compares the results
+# against a stored baseline.
+#
+# Usage: bench_progs.sh AETHER CORPUS BASELINE [--update]
+#
+# Each program is run with --stop-after=lex, --stop-after=parse and in full.
+# The time of a phase is the difference between consecutive stop points, and
+# the startup time of aether (measured on an empty program) is subtracted
+# from lexing. Each measurement is the fastest of BENCH_RUNS runs (default 5).
+#
+# A phase that is more than BENCH_THRESHOLD percent (default 10) slower than
+# its baseline is reported as a regression, and makes the script fail. Phases
+# that take less than a millisecond are dominated by noise and never regress.
+# With --update, the results are written to BASELINE instead.
+
+set -e
+
+if [ $# -lt 3 ]; then
+    echo "Usage: $0 AETHER CORPUS BASELINE [--update]" >&2
+    exit 1
+fi
+aether="$1"
+corpus="$2"
+baseline="$3"
+update="$4"
+runs="${BENCH_RUNS:-5}"
+threshold="${BENCH_THRESHOLD:-10}"
+
+case "$(date +%N)" in
+    *N*)
+        echo "$0: date(1) does not support nanoseconds (%N)" >&2
+        exit 1
+        ;;
+esac
+
+# Prints the fastest of $runs runs of aether in milliseconds
+measure() {
+    best=
+    i=0
+    while [ $i -lt "$runs" ]; do
+        start=$(date +%s%N)
+        "$aether" "$@" > /dev/null
+        end=$(date +%s%N)
+        elapsed=$((end - start))
+        if [ -z "$best" ] || [ $elapsed -lt $best ]; then
+            best=$elapsed
+        fi
+        i=$((i + 1))
+    done
+    awk -v ns="$best" 'BEGIN { printf "%.3f\n", ns / 1e6 }'
+}
+
+# Prints the difference of two times in milliseconds, but never less than 0
+difference() {
+    awk -v a="$1" -v b="$2" 'BEGIN { d = a - b; printf "%.3f\n", (d > 0) ? d : 0 }'
+}
+
+results=$(mktemp)
+empty=$(mktemp)
+trap 'rm -f "$results" "$empty"' EXIT
+
+startup=$(measure --stop-after=lex "$empty")
+
+for program in "$corpus"/*.ae; do
+    name=$(basename "$program" .ae)
+    lex=$(measure --stop-after=lex "$program")
+    parse=$(measure --stop-after=parse "$program")
+    full=$(measure --no-cache "$program")
+
+    echo "$name lex $(difference "$lex" "$startup")" >> "$results"
+    echo "$name parse $(difference "$parse" "$lex")" >> "$results"
+    echo "$name execute $(difference "$full" "$parse")" >> "$results"
+done
+
+if [ "$update" = "--update" ]; then
+    cp "$results" "$baseline"
+    echo "Baseline written to '$baseline'"
+    exit 0
+fi
+
+if [ ! -f "$baseline" ]; then
+    echo "$0: No baseline '$baseline', record one with --update" >&2
+    awk '{ printf "%-12s %-8s %10.3f ms\n", $1, $2, $3 }' "$results"
+    exit 1
+fi
+
+awk -v threshold="$threshold" '
+NR == FNR {
+    base[$1 " " $2] = $3
+    next
+}
+{
+    key = $1 " " $2
+    if (!(key in base)) {
+        printf "%-12s %-8s %10.3f ms %13s\n", $1, $2, $3, "(new)"
+        next
+    }
+    change = (base[key] > 0) ? (($3 - base[key]) / base[key]) * 100 : 0
+    status = ""
+    if (change > threshold && $3 >= 1) {
+        status = "  REGRESSION"
+        regressions += 1
+    }
+    printf "%-12s %-8s %10.3f ms %+11.1f %%%s\n", $1, $2, $3, change, status
+}
+END {
+    if (regressions > 0) {
+        printf "%d phase(s) regressed by more than %s%%\n", regressions, threshold
+        exit 1
+    }
+}' "$baseline" "$results"
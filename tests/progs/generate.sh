@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# Generates the benchmark corpus used by tests/bench_progs.sh.
+#
+# Usage: generate.sh DIRECTORY [SCALE]
+#
+# A program is a single statement, hence each one stands in for a realistic
+# workload by spelling it out: the unrolled body of an arithmetic loop, a long
+# string concatenation, a list of records, a large list literal and a deeply
+# nested expression. SCALE (default 1) multiplies the size of every program.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 DIRECTORY [SCALE]" >&2
+    exit 1
+fi
+directory="$1"
+scale="${2:-1}"
+
+mkdir -p "$directory"
+
+awk -v n=$((20000 * scale)) 'BEGIN {
+    print "# Unrolled body of an arithmetic loop"
+    printf "total = x0"
+    for (i = 1; i < n; i++) {
+        printf " +\n    (x%d * %d + %d.5) %% %d - y / %d", i % 16, i, i % 7, (i % 13) + 1, (i % 5) + 2
+    }
+    print ";"
+}' > "$directory/arithmetic.ae"
+
+awk -v n=$((50000 * scale)) 'BEGIN {
+    print "# Building a report out of many small pieces"
+    printf "report = \"Report for \" + name"
+    for (i = 1; i < n; i++) {
+        printf " +\n    \"\\tline %d: \\\"\" + field%d + \"\\\"\\n\"", i, i % 32
+    }
+    print ";"
+}' > "$directory/strings.ae"
+
+awk -v n=$((5000 * scale)) 'BEGIN {
+    print "# Records, as read from a database"
+    print "records = ["
+    for (i = 0; i < n; i++) {
+        printf "    {\"id\": %d, \"name\": \"user%d\", \"email\": \"user%d@example.com\", ", i, i, i
+        printf "\"score\": %d.%02d, \"active\": %s, \"tags\": [\"tag%d\", \"tag%d\"], ", i % 100, i % 97, (i % 3 == 0) ? "false" : "true", i % 8, i % 5
+        printf "\"manager\": %s}%s\n", (i % 10 == 0) ? "none" : "records[" int(i / 10) "]", (i < n - 1) ? "," : ""
+    }
+    print "];"
+}' > "$directory/records.ae"
+
+awk -v n=$((200000 * scale)) 'BEGIN {
+    print "# A large table of constants"
+    printf "values = ["
+    for (i = 0; i < n; i++) {
+        if (i % 10 == 0) {
+            printf "\n   "
+        }
+        if (i % 2 == 0) {
+            printf " %d,", i * 7919
+        } else {
+            printf " %d.%d,", i, i % 1000
+        }
+    }
+    print "\n    0];"
+}' > "$directory/list.ae"
+
+awk -v n=$((2000 * scale)) 'BEGIN {
+    print "# A deeply nested expression"
+    printf "depth = "
+    for (i = 0; i < n; i++) {
+        printf "("
+    }
+    printf "x"
+    for (i = 0; i < n; i++) {
+        printf " + %d)", i
+    }
+    print ";"
+}' > "$directory/deep.ae"
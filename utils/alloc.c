@@ -0,0 +1,395 @@
+#include "alloc.h"
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "logger.h"
+
+#define NUM_SIZE_CLASSES 65 // Sizes up to 2^0, 2^1, ..., 2^64 bytes
+
+static void *LibcMalloc(void *const state, const size_t size) {
+  (void)state;
+  return malloc(size);
+}
+
+static void *LibcRealloc(void *const state, void *const ptr,
+                         const size_t size) {
+  (void)state;
+  return realloc(ptr, size);
+}
+
+static void LibcFree(void *const state, void *const ptr) {
+  (void)state;
+  free(ptr);
+}
+
+static const Allocator LIBC_ALLOCATOR = {
+    .malloc = LibcMalloc,
+    .realloc = LibcRealloc,
+    .free = LibcFree,
+    .state = NULL,
+};
+
+static Allocator ALLOCATOR = {
+    .malloc = LibcMalloc,
+    .realloc = LibcRealloc,
+    .free = LibcFree,
+    .state = NULL,
+};
+
+/****************************************************************************/
+
+typedef struct {
+  const char *file;
+  int line;
+  size_t calls;
+  size_t bytes;
+  size_t live_blocks;
+  size_t live_bytes;
+} Site;
+
+typedef struct {
+  const void *ptr; // NULL if the slot is empty
+  size_t size;
+  size_t site;
+} Block;
+
+static atomic_uint TRACKING;
+static atomic_size_t TOTAL_CALLS;
+static atomic_size_t TOTAL_BYTES;
+
+/* Bookkeeping of ALLOC_TRACK_SITES. The tables are allocated straight from
+ * the C library, as they must not be tracked themselves. Both are open
+ * addressing hash tables with linear probing and a power of two capacity. */
+static struct {
+  pthread_mutex_t mutex;
+  Site *sites;
+  size_t num_sites;
+  size_t *site_index; // Index of site plus one, zero if empty
+  size_t site_capacity;
+  Block *blocks;
+  size_t num_blocks;
+  size_t block_capacity;
+  size_t histogram[NUM_SIZE_CLASSES];
+} TRACKER = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static void *TrackerAlloc(const size_t size) {
+  void *const ptr = calloc(1, size);
+  if (ptr == NULL) {
+    LOG_CRITICAL("calloc(3): Failed to allocate memory: %s", strerror(errno));
+  }
+  return ptr;
+}
+
+static size_t HashSite(const char *const file, const int line) {
+  uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t)(unsigned int)line;
+  for (const char *ch = file; *ch != '\0'; ch++) {
+    hash = (hash ^ (unsigned char)*ch) * 0x100000001b3ULL;
+  }
+  return (size_t)hash;
+}
+
+static size_t HashPointer(const void *const ptr) {
+  const uint64_t hash = (uint64_t)(uintptr_t)ptr * 0x9e3779b97f4a7c15ULL;
+  return (size_t)(hash >> 17);
+}
+
+static void GrowSiteIndex(void) {
+  const size_t capacity =
+      (TRACKER.site_capacity > 0) ? TRACKER.site_capacity * 2 : 256;
+  size_t *const index = TrackerAlloc(capacity * sizeof(size_t));
+  for (size_t i = 0; i < TRACKER.num_sites; i++) {
+    const Site *const site = &TRACKER.sites[i];
+    size_t slot = HashSite(site->file, site->line) & (capacity - 1);
+    while (index[slot] != 0) {
+      slot = (slot + 1) & (capacity - 1);
+    }
+    index[slot] = i + 1;
+  }
+
+  free(TRACKER.site_index);
+  TRACKER.site_index = index;
+  TRACKER.site_capacity = capacity;
+
+  // Sites are never removed, so the array never holds more than half of this
+  Site *const sites =
+      realloc(TRACKER.sites, (capacity / 2) * sizeof(Site));
+  if (sites == NULL) {
+    LOG_CRITICAL("realloc(3): Failed to allocate memory: %s",
+                 strerror(errno));
+  }
+  TRACKER.sites = sites;
+}
+
+static size_t GetSite(const char *const file, const int line) {
+  if (TRACKER.num_sites >= TRACKER.site_capacity / 2) {
+    GrowSiteIndex();
+  }
+
+  const size_t mask = TRACKER.site_capacity - 1;
+  size_t slot = HashSite(file, line) & mask;
+  while (TRACKER.site_index[slot] != 0) {
+    const size_t i = TRACKER.site_index[slot] - 1;
+    const Site *const site = &TRACKER.sites[i];
+    if (site->line == line &&
+        (site->file == file || strcmp(site->file, file) == 0)) {
+      return i;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  const size_t i = TRACKER.num_sites++;
+  TRACKER.sites[i] = (Site){.file = file, .line = line};
+  TRACKER.site_index[slot] = i + 1;
+  return i;
+}
+
+static void InsertBlock(Block *const blocks, const size_t capacity,
+                        const Block *const block) {
+  size_t slot = HashPointer(block->ptr) & (capacity - 1);
+  while (blocks[slot].ptr != NULL) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  blocks[slot] = *block;
+}
+
+static void TrackBlock(const void *const ptr, const size_t size,
+                       const char *const file, const int line) {
+  if (TRACKER.num_blocks >= TRACKER.block_capacity / 2) {
+    const size_t capacity =
+        (TRACKER.block_capacity > 0) ? TRACKER.block_capacity * 2 : 1024;
+    Block *const blocks = TrackerAlloc(capacity * sizeof(Block));
+    for (size_t i = 0; i < TRACKER.block_capacity; i++) {
+      if (TRACKER.blocks[i].ptr != NULL) {
+        InsertBlock(blocks, capacity, &TRACKER.blocks[i]);
+      }
+    }
+    free(TRACKER.blocks);
+    TRACKER.blocks = blocks;
+    TRACKER.block_capacity = capacity;
+  }
+
+  const size_t index = GetSite(file, line);
+  Site *const site = &TRACKER.sites[index];
+  site->calls += 1;
+  site->bytes += size;
+  site->live_blocks += 1;
+  site->live_bytes += size;
+
+  size_t size_class = 0;
+  while (size_class < NUM_SIZE_CLASSES - 1 &&
+         ((uint64_t)1 << size_class) < size) {
+    size_class += 1;
+  }
+  TRACKER.histogram[size_class] += 1;
+
+  const Block block = {.ptr = ptr, .size = size, .site = index};
+  InsertBlock(TRACKER.blocks, TRACKER.block_capacity, &block);
+  TRACKER.num_blocks += 1;
+}
+
+/**
+ * @brief Forget a block, if it is tracked. Uses backward shift deletion, so
+ *        that no tombstones are left behind.
+ */
+static void UntrackBlock(const void *const ptr) {
+  if (TRACKER.num_blocks == 0) {
+    return;
+  }
+
+  const size_t mask = TRACKER.block_capacity - 1;
+  size_t slot = HashPointer(ptr) & mask;
+  while (TRACKER.blocks[slot].ptr != ptr) {
+    if (TRACKER.blocks[slot].ptr == NULL) {
+      return; // Allocated while not tracking
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  Site *const site = &TRACKER.sites[TRACKER.blocks[slot].site];
+  site->live_blocks -= 1;
+  site->live_bytes -= TRACKER.blocks[slot].size;
+  TRACKER.num_blocks -= 1;
+
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask; TRACKER.blocks[next].ptr != NULL;
+       next = (next + 1) & mask) {
+    const size_t home = HashPointer(TRACKER.blocks[next].ptr) & mask;
+    // Move the block into the hole, unless its home lies after the hole
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      TRACKER.blocks[hole] = TRACKER.blocks[next];
+      hole = next;
+    }
+  }
+  TRACKER.blocks[hole].ptr = NULL;
+}
+
+/****************************************************************************/
+
+void AllocSetAllocator(const Allocator *const allocator,
+                       Allocator *const previous) {
+  if (previous != NULL) {
+    *previous = ALLOCATOR;
+  }
+  ALLOCATOR = (allocator != NULL) ? *allocator : LIBC_ALLOCATOR;
+}
+
+void AllocSetTracking(const unsigned int flags) {
+  atomic_store_explicit(&TRACKING, flags, memory_order_relaxed);
+}
+
+unsigned int AllocGetTracking(void) {
+  return atomic_load_explicit(&TRACKING, memory_order_relaxed);
+}
+
+void AllocGetStats(AllocStats *const stats) {
+  assert(stats != NULL);
+  stats->calls = atomic_load_explicit(&TOTAL_CALLS, memory_order_relaxed);
+  stats->bytes = atomic_load_explicit(&TOTAL_BYTES, memory_order_relaxed);
+}
+
+static int CompareSites(const void *const a, const void *const b) {
+  const Site *const site_a = *(const Site *const *)a;
+  const Site *const site_b = *(const Site *const *)b;
+  if (site_a->bytes != site_b->bytes) {
+    return (site_a->bytes < site_b->bytes) ? 1 : -1;
+  }
+  return (site_a->calls < site_b->calls)   ? 1
+         : (site_a->calls > site_b->calls) ? -1
+                                           : 0;
+}
+
+size_t AllocReport(FILE *const stream) {
+  assert(stream != NULL);
+
+  pthread_mutex_lock(&TRACKER.mutex);
+
+  const Site **const sites = TrackerAlloc((TRACKER.num_sites + 1) *
+                                          sizeof(Site *));
+  for (size_t i = 0; i < TRACKER.num_sites; i++) {
+    sites[i] = &TRACKER.sites[i];
+  }
+  qsort(sites, TRACKER.num_sites, sizeof(Site *), CompareSites);
+
+  fprintf(stream, "%12s %14s  %s\n", "Calls", "Bytes", "Call site");
+  for (size_t i = 0; i < TRACKER.num_sites; i++) {
+    fprintf(stream, "%12zu %14zu  %s:%d\n", sites[i]->calls, sites[i]->bytes,
+            sites[i]->file, sites[i]->line);
+  }
+
+  fprintf(stream, "\n%12s  %s\n", "Calls", "Size (bytes)");
+  for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+    if (TRACKER.histogram[i] > 0) {
+      fprintf(stream, "%12zu  <= %llu\n", TRACKER.histogram[i],
+              (i < 64) ? 1ULL << i : ~0ULL);
+    }
+  }
+
+  if (TRACKER.num_blocks > 0) {
+    fprintf(stream, "\n");
+  }
+  for (size_t i = 0; i < TRACKER.num_sites; i++) {
+    if (sites[i]->live_blocks > 0) {
+      fprintf(stream, "Leaked %zu bytes in %zu blocks allocated at %s:%d\n",
+              sites[i]->live_bytes, sites[i]->live_blocks, sites[i]->file,
+              sites[i]->line);
+    }
+  }
+
+  free(sites);
+  const size_t leaked = TRACKER.num_blocks;
+  pthread_mutex_unlock(&TRACKER.mutex);
+  return leaked;
+}
+
+/****************************************************************************/
+
+static void Count(const unsigned int flags, const size_t size) {
+  if (flags & ALLOC_TRACK_TOTALS) {
+    atomic_fetch_add_explicit(&TOTAL_CALLS, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&TOTAL_BYTES, size, memory_order_relaxed);
+  }
+}
+
+void *AllocMalloc(const size_t size, const char *const file, const int line) {
+  void *const ptr = ALLOCATOR.malloc(ALLOCATOR.state, size);
+  if (ptr == NULL) {
+    LOG_CRITICAL("Failed to allocate memory: %s", strerror(errno));
+  }
+
+  const unsigned int flags =
+      atomic_load_explicit(&TRACKING, memory_order_relaxed);
+  if (flags != 0) {
+    Count(flags, size);
+    if (flags & ALLOC_TRACK_SITES) {
+      pthread_mutex_lock(&TRACKER.mutex);
+      TrackBlock(ptr, size, file, line);
+      pthread_mutex_unlock(&TRACKER.mutex);
+    }
+  }
+  return ptr;
+}
+
+void *AllocCalloc(const size_t nmemb, const size_t size,
+                  const char *const file, const int line) {
+  if (size != 0 && nmemb > SIZE_MAX / size) {
+    LOG_CRITICAL("Failed to allocate memory: %s", strerror(ENOMEM));
+  }
+  void *const ptr = AllocMalloc(nmemb * size, file, line);
+  memset(ptr, 0, nmemb * size);
+  return ptr;
+}
+
+void *AllocRealloc(void *const ptr, const size_t size, const char *const file,
+                   const int line) {
+  const unsigned int flags =
+      atomic_load_explicit(&TRACKING, memory_order_relaxed);
+  if (!(flags & ALLOC_TRACK_SITES)) {
+    void *const new_ptr = ALLOCATOR.realloc(ALLOCATOR.state, ptr, size);
+    if (new_ptr == NULL) {
+      LOG_CRITICAL("Failed to allocate memory: %s", strerror(errno));
+    }
+    Count(flags, size);
+    return new_ptr;
+  }
+
+  /* The old block is forgotten under the same lock, or else another thread
+   * may be handed and track the same address in the meantime. */
+  pthread_mutex_lock(&TRACKER.mutex);
+  void *const new_ptr = ALLOCATOR.realloc(ALLOCATOR.state, ptr, size);
+  if (new_ptr == NULL) {
+    pthread_mutex_unlock(&TRACKER.mutex);
+    LOG_CRITICAL("Failed to allocate memory: %s", strerror(errno));
+  }
+  if (ptr != NULL) {
+    UntrackBlock(ptr);
+  }
+  TrackBlock(new_ptr, size, file, line);
+  pthread_mutex_unlock(&TRACKER.mutex);
+
+  Count(flags, size);
+  return new_ptr;
+}
+
+void xfree(void *const ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  const unsigned int flags =
+      atomic_load_explicit(&TRACKING, memory_order_relaxed);
+  if (!(flags & ALLOC_TRACK_SITES)) {
+    ALLOCATOR.free(ALLOCATOR.state, ptr);
+    return;
+  }
+
+  pthread_mutex_lock(&TRACKER.mutex);
+  UntrackBlock(ptr);
+  ALLOCATOR.free(ALLOCATOR.state, ptr);
+  pthread_mutex_unlock(&TRACKER.mutex);
+}
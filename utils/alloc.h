@@ -1,18 +1,107 @@
 #ifndef _AETHER_ALLOC_H
 #define _AETHER_ALLOC_H
 
-#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-#include "logger.h"
+/**
+ * All memory in aether is allocated with xmalloc(), xcalloc() and xrealloc(),
+ * and released with xfree(). These never return NULL, failure to allocate
+ * memory is a critical error. Memory obtained from any other source (e.g.,
+ * realpath(3)) must be released with free(3).
+ */
 
-inline void *xmalloc(size_t size) {
-  void *ptr = malloc(size);
-  if (ptr == NULL) {
-    LOG_CRITICAL("Failed to allocate memory: %s", strerror(errno));
-  }
-  return ptr;
-}
+/**
+ * Interface of the underlying allocator. Each function receives the state of
+ * the allocator as its first argument. The allocator may return NULL on
+ * failure, and must return memory suitably aligned for any type.
+ */
+typedef struct {
+  void *(*malloc)(void *state, size_t size);
+  void *(*realloc)(void *state, void *ptr, size_t size);
+  void (*free)(void *state, void *ptr);
+  void *state;
+} Allocator;
+
+typedef struct {
+  size_t calls; // Calls to xmalloc(), xcalloc() and xrealloc()
+  size_t bytes; // Bytes requested by them
+} AllocStats;
+
+enum {
+  ALLOC_TRACK_TOTALS = 1 << 0, // See AllocGetStats()
+  ALLOC_TRACK_SITES = 1 << 1,  // See AllocReport()
+};
+
+/**
+ * @brief Replace the underlying allocator.
+ * @param allocator The new allocator, or NULL for the C library allocator.
+ * @param previous Is set to the allocator being replaced, unless NULL.
+ * @warning Memory must be released through the allocator it was allocated
+ *          with. Hence, only swap allocators where no memory allocated by the
+ *          previous allocator is released until it is restored, and while no
+ *          other thread allocates memory.
+ */
+void AllocSetAllocator(const Allocator *allocator, Allocator *previous);
+
+/**
+ * @brief Select what allocations are tracked. Tracking is disabled by
+ *        default, and costs a single branch per allocation while disabled.
+ * @param flags Bitwise or of ALLOC_TRACK_* flags, or 0 to stop tracking.
+ * @note Memory allocated while ALLOC_TRACK_SITES was disabled is never
+ *       reported as leaked.
+ */
+void AllocSetTracking(unsigned int flags);
+
+/**
+ * @brief Get the tracking flags, see AllocSetTracking().
+ * @return Bitwise or of ALLOC_TRACK_* flags.
+ */
+unsigned int AllocGetTracking(void);
+
+/**
+ * @brief Get the number of allocations and allocated bytes, counted while
+ *        ALLOC_TRACK_TOTALS was enabled.
+ * @param stats Is set to the statistics.
+ */
+void AllocGetStats(AllocStats *stats);
+
+/**
+ * @brief Report allocations counted while ALLOC_TRACK_SITES was enabled:
+ *        calls and bytes per call site, a histogram of allocation sizes and
+ *        the memory that has not been released, by call site.
+ * @param stream Stream to print the report to.
+ * @return Number of blocks that have not been released.
+ */
+size_t AllocReport(FILE *stream);
+
+void *AllocMalloc(size_t size, const char *file, int line);
+void *AllocCalloc(size_t nmemb, size_t size, const char *file, int line);
+void *AllocRealloc(void *ptr, size_t size, const char *file, int line);
+
+/**
+ * @brief Allocate memory, see malloc(3).
+ */
+#define xmalloc(size) AllocMalloc((size), __FILE__, __LINE__)
+
+/**
+ * @brief Allocate zero-initialized memory for an array, see calloc(3).
+ */
+#define xcalloc(nmemb, size) AllocCalloc((nmemb), (size), __FILE__, __LINE__)
+
+/**
+ * @brief Change the size of allocated memory, see realloc(3).
+ */
+#define xrealloc(ptr, size) AllocRealloc((ptr), (size), __FILE__, __LINE__)
+
+/**
+ * @brief Release memory allocated by xmalloc(), xcalloc() or xrealloc().
+ * @param ptr The memory.
+ * @note If ptr is NULL, no operation is performed. Unlike the other
+ *       functions, this is a function rather than a macro, so that it can be
+ *       passed as a destroy function.
+ */
+void xfree(void *ptr);
 
 #endif // _AETHER_ALLOC_H
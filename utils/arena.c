@@ -0,0 +1,155 @@
+#include "arena.h"
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "logger.h"
+
+/* Each block is preceded by a header holding its size, so that it can be
+ * copied when reallocated. The header keeps blocks aligned for any type. */
+#define HEADER_SIZE alignof(max_align_t)
+
+typedef struct Chunk {
+  struct Chunk *next;
+  size_t size;
+  size_t used;
+  alignas(max_align_t) unsigned char data[];
+} Chunk;
+
+struct Arena {
+  size_t chunk_size;
+  size_t total_size;
+  Chunk *chunks; // Most recent chunk first
+  unsigned char *last; // Most recent block, or NULL
+};
+
+Arena *ArenaCreate(const size_t chunk_size) {
+  /* The arena and its chunks are taken straight from the C library, as they
+   * must outlive any allocator the arena is swapped in for. */
+  Arena *const arena = (Arena *)malloc(sizeof(Arena));
+  if (arena == NULL) {
+    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
+  }
+
+  arena->chunk_size = (chunk_size > 0) ? chunk_size : DEFAULT_ARENA_CHUNK_SIZE;
+  arena->total_size = 0;
+  arena->chunks = NULL;
+  arena->last = NULL;
+  return arena;
+}
+
+void ArenaDestroy(Arena *const arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  Chunk *chunk = arena->chunks;
+  while (chunk != NULL) {
+    Chunk *const next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(arena);
+}
+
+size_t ArenaSize(const Arena *const arena) {
+  assert(arena != NULL);
+  return arena->total_size;
+}
+
+static size_t BlockSize(const unsigned char *const block) {
+  size_t size;
+  memcpy(&size, block - HEADER_SIZE, sizeof(size_t));
+  return size;
+}
+
+static void SetBlockSize(unsigned char *const block, const size_t size) {
+  memcpy(block - HEADER_SIZE, &size, sizeof(size_t));
+}
+
+static size_t RoundUp(const size_t size) {
+  return (size + (HEADER_SIZE - 1)) & ~(HEADER_SIZE - 1);
+}
+
+static void *ArenaMalloc(void *const state, const size_t size) {
+  Arena *const arena = (Arena *)state;
+  if (size > SIZE_MAX - 2 * HEADER_SIZE - sizeof(Chunk)) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  const size_t needed = HEADER_SIZE + RoundUp(size);
+
+  Chunk *chunk = arena->chunks;
+  if (chunk == NULL || chunk->size - chunk->used < needed) {
+    const size_t chunk_size =
+        (needed > arena->chunk_size) ? needed : arena->chunk_size;
+    chunk = (Chunk *)malloc(sizeof(Chunk) + chunk_size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = arena->chunks;
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    arena->chunks = chunk;
+    arena->total_size += chunk_size;
+  }
+
+  unsigned char *const block = chunk->data + chunk->used + HEADER_SIZE;
+  chunk->used += needed;
+  SetBlockSize(block, size);
+  arena->last = block;
+  return block;
+}
+
+static void *ArenaRealloc(void *const state, void *const ptr,
+                          const size_t size) {
+  Arena *const arena = (Arena *)state;
+  if (ptr == NULL) {
+    return ArenaMalloc(state, size);
+  }
+
+  unsigned char *const block = (unsigned char *)ptr;
+  const size_t old_size = BlockSize(block);
+
+  if (block == arena->last && size <= SIZE_MAX - HEADER_SIZE) {
+    // The most recent block is at the end of the current chunk
+    Chunk *const chunk = arena->chunks;
+    const size_t start = (size_t)(block - chunk->data);
+    if (chunk->size - start >= RoundUp(size)) {
+      chunk->used = start + RoundUp(size);
+      SetBlockSize(block, size);
+      return block;
+    }
+  }
+
+  unsigned char *const new_block = ArenaMalloc(state, size);
+  if (new_block != NULL) {
+    memcpy(new_block, block, (old_size < size) ? old_size : size);
+  }
+  return new_block;
+}
+
+static void ArenaFree(void *const state, void *const ptr) {
+  Arena *const arena = (Arena *)state;
+  if (ptr != NULL && ptr == arena->last) {
+    // Give the most recent block back to its chunk
+    arena->chunks->used =
+        (size_t)(arena->last - arena->chunks->data) - HEADER_SIZE;
+    arena->last = NULL;
+  }
+}
+
+void ArenaAllocator(Arena *const arena, Allocator *const allocator) {
+  assert(arena != NULL);
+  assert(allocator != NULL);
+
+  allocator->malloc = ArenaMalloc;
+  allocator->realloc = ArenaRealloc;
+  allocator->free = ArenaFree;
+  allocator->state = arena;
+}
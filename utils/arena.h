@@ -0,0 +1,46 @@
+#ifndef _AETHER_ARENA_H
+#define _AETHER_ARENA_H
+
+#include <stdlib.h>
+
+#include "alloc.h"
+
+typedef struct Arena Arena;
+
+/**
+ * @brief Create an arena. Memory is handed out from large chunks by bumping a
+ *        pointer, and is only released all at once when the arena is
+ *        destroyed.
+ * @param chunk_size Minimum number of bytes per chunk, or 0 for the default.
+ * @return The arena.
+ * @note Caller takes ownership of returned value. The arena is not thread
+ *       safe.
+ */
+Arena *ArenaCreate(size_t chunk_size);
+
+/**
+ * @brief Destroy the arena, releasing all memory allocated from it.
+ * @param arena The arena.
+ * @note If arena is NULL, no operation is performed.
+ */
+void ArenaDestroy(Arena *arena);
+
+/**
+ * @brief Get an allocator that allocates from the arena, see
+ *        AllocSetAllocator().
+ * @param arena The arena.
+ * @param allocator Is set to the allocator.
+ * @note Releasing memory is a no-op, except for the most recent allocation,
+ *       which is given back to the arena. Reallocating the most recent
+ *       allocation grows it in place while there is room in its chunk.
+ */
+void ArenaAllocator(Arena *arena, Allocator *allocator);
+
+/**
+ * @brief Get the number of bytes obtained by the arena for its chunks.
+ * @param arena The arena.
+ * @return Number of bytes.
+ */
+size_t ArenaSize(const Arena *arena);
+
+#endif // _AETHER_ARENA_H
@@ -0,0 +1,118 @@
+#include "../tests/bench.h"
+
+#include "buffer.h"
+
+static void bench_BufferCreateShort(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    Buffer *const buf = BufferCreate();
+    BufferPrint(buf, "identifier");
+    BENCH_SINK += BufferLength(buf);
+    BufferDestroy(buf);
+  }
+}
+
+static void bench_BufferInitShort(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    Buffer buf;
+    BufferInit(&buf);
+    BufferPrint(&buf, "identifier");
+    BENCH_SINK += BufferLength(&buf);
+    BufferDeinit(&buf);
+  }
+}
+
+static void bench_BufferAppendLong(const size_t n) {
+  Buffer buf;
+  BufferInit(&buf);
+  for (size_t i = 0; i < n; i++) {
+    BufferAppend(&buf, 'x');
+  }
+  BENCH_SINK += BufferLength(&buf);
+  BufferDeinit(&buf);
+}
+
+static void bench_BufferPrintFormatInt(const size_t n) {
+  Buffer buf;
+  BufferInit(&buf);
+  for (size_t i = 0; i < n; i++) {
+    BufferClear(&buf);
+    BufferPrintFormat(&buf, "%lld", (long long)i);
+  }
+  BENCH_SINK += BufferLength(&buf);
+  BufferDeinit(&buf);
+}
+
+static void bench_BufferPrintInt(const size_t n) {
+  Buffer buf;
+  BufferInit(&buf);
+  for (size_t i = 0; i < n; i++) {
+    BufferClear(&buf);
+    BufferPrintInt(&buf, (long long)i);
+  }
+  BENCH_SINK += BufferLength(&buf);
+  BufferDeinit(&buf);
+}
+
+static void bench_BufferPrintFormatFloat(const size_t n) {
+  Buffer buf;
+  BufferInit(&buf);
+  for (size_t i = 0; i < n; i++) {
+    BufferClear(&buf);
+    BufferPrintFormat(&buf, "%f", (double)i);
+  }
+  BENCH_SINK += BufferLength(&buf);
+  BufferDeinit(&buf);
+}
+
+static void bench_BufferPrintFloat(const size_t n) {
+  Buffer buf;
+  BufferInit(&buf);
+  for (size_t i = 0; i < n; i++) {
+    BufferClear(&buf);
+    BufferPrintFloat(&buf, (double)i);
+  }
+  BENCH_SINK += BufferLength(&buf);
+  BufferDeinit(&buf);
+}
+
+/* Builds a buffer of the given size from scratch, one character at a time. */
+static void bench_BufferAppend(const size_t n, const size_t size) {
+  for (size_t i = 0; i < n; i++) {
+    Buffer buf;
+    BufferInit(&buf);
+    for (size_t j = 0; j < size; j++) {
+      BufferAppend(&buf, 'x');
+    }
+    BENCH_SINK += BufferLength(&buf);
+    BufferDeinit(&buf);
+  }
+}
+
+/* Formats a string of the given size into an empty buffer. */
+static void bench_BufferPrintFormat(const size_t n, const size_t size) {
+  char *const str = malloc(size + 1);
+  memset(str, 'x', size);
+  str[size] = '\0';
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    Buffer buf;
+    BufferInit(&buf);
+    BufferPrintFormat(&buf, "<%s>", str);
+    BENCH_SINK += BufferLength(&buf);
+    BufferDeinit(&buf);
+  }
+  free(str);
+}
+
+BENCH_BEGIN
+BENCH_ADD("BufferCreateShort", bench_BufferCreateShort)
+BENCH_ADD("BufferInitShort", bench_BufferInitShort)
+BENCH_ADD("BufferAppendLong", bench_BufferAppendLong)
+BENCH_ADD("BufferPrintFormatInt", bench_BufferPrintFormatInt)
+BENCH_ADD("BufferPrintInt", bench_BufferPrintInt)
+BENCH_ADD("BufferPrintFormatFloat", bench_BufferPrintFormatFloat)
+BENCH_ADD("BufferPrintFloat", bench_BufferPrintFloat)
+BENCH_ADD_SIZED("BufferAppend", bench_BufferAppend)
+BENCH_ADD_SIZED("BufferPrintFormat", bench_BufferPrintFormat)
+BENCH_END
@@ -0,0 +1,189 @@
+#include "../tests/bench.h"
+
+#include <stdbool.h>
+
+#include "dict.h"
+#include "hash.h"
+#include "int_dict.h"
+#include "string_lib.h"
+
+#define N_KEYS 4096
+
+static char KEYS[N_KEYS][16];
+
+static void MakeKeys(void) {
+  static bool done = false;
+  if (done) {
+    return;
+  }
+  done = true;
+
+  for (size_t i = 0; i < N_KEYS; i++) {
+    snprintf(KEYS[i], sizeof(KEYS[i]), "key%zu", i);
+  }
+}
+
+static void bench_HashBytesShort(const size_t n) {
+  const char key[] = "identifier";
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += HashBytes(key, sizeof(key) - 1);
+  }
+}
+
+static void bench_HashBytesLong(const size_t n) {
+  static char key[1024];
+  memset(key, 'x', sizeof(key));
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += HashBytes(key, sizeof(key));
+  }
+}
+
+static char **NewKeys(const size_t size) {
+  char **const keys = malloc(size * sizeof(char *));
+  for (size_t i = 0; i < size; i++) {
+    keys[i] = StringFormat("key%zu", i);
+  }
+  return keys;
+}
+
+static void FreeKeys(char **const keys, const size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    free(keys[i]);
+  }
+  free(keys);
+}
+
+/* Inserts keys into a dictionary that is recreated once it has reached the
+ * given size, so the cost of growing it is spread over the insertions. */
+static void bench_DictSet(const size_t n, const size_t size) {
+  char **const keys = NewKeys(size);
+
+  BenchResetTimer();
+  Dict *dict = DictCreate();
+  for (size_t i = 0; i < n; i++) {
+    if (i % size == 0) {
+      DictDestroy(dict);
+      dict = DictCreate();
+    }
+    DictSet(dict, keys[i % size], NULL, NULL);
+  }
+  DictDestroy(dict);
+
+  FreeKeys(keys, size);
+}
+
+static void bench_DictGet(const size_t n, const size_t size) {
+  char **const keys = NewKeys(size);
+  Dict *const dict = DictCreate();
+  for (size_t i = 0; i < size; i++) {
+    DictSet(dict, keys[i], keys[i], NULL);
+  }
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += (size_t)DictGet(dict, keys[i % size]);
+  }
+
+  DictDestroy(dict);
+  FreeKeys(keys, size);
+}
+
+/* Removes a key from a dictionary of the given size and inserts it again,
+ * keeping the size of the dictionary constant. */
+static void bench_DictRemove(const size_t n, const size_t size) {
+  char **const keys = NewKeys(size);
+  Dict *const dict = DictCreate();
+  for (size_t i = 0; i < size; i++) {
+    DictSet(dict, keys[i], NULL, NULL);
+  }
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += (size_t)DictRemove(dict, keys[i % size]);
+    DictSet(dict, keys[i % size], NULL, NULL);
+  }
+
+  DictDestroy(dict);
+  FreeKeys(keys, size);
+}
+
+static void bench_DictHasKeyMissing(const size_t n) {
+  MakeKeys();
+  Dict *dict = DictCreate();
+  for (size_t i = 0; i < N_KEYS; i += 2) {
+    DictSet(dict, KEYS[i], NULL, NULL);
+  }
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += DictHasKey(dict, KEYS[((2 * i) + 1) % N_KEYS]);
+  }
+  DictDestroy(dict);
+}
+
+/* Removes the oldest key and inserts a new one, keeping the dictionary at half
+ * of N_KEYS entries. Per-operation cost should stay flat as n grows. */
+static void bench_DictChurn(const size_t n) {
+  MakeKeys();
+  Dict *dict = DictCreate();
+  for (size_t i = 0; i < N_KEYS / 2; i++) {
+    DictSet(dict, KEYS[i], NULL, NULL);
+  }
+  for (size_t i = 0; i < n; i++) {
+    DictRemove(dict, KEYS[i % N_KEYS]);
+    DictSet(dict, KEYS[(i + (N_KEYS / 2)) % N_KEYS], NULL, NULL);
+    BENCH_SINK += DictHasKey(dict, KEYS[(i + 1) % N_KEYS]);
+  }
+  DictDestroy(dict);
+}
+
+/* Looking up integer ids in a string keyed dictionary, which is what the
+ * integer keyed dictionary replaces. */
+static void bench_DictGetFormatted(const size_t n) {
+  MakeKeys();
+  Dict *dict = DictCreate();
+  for (size_t i = 0; i < N_KEYS; i++) {
+    DictSet(dict, KEYS[i], NULL, NULL);
+  }
+  for (size_t i = 0; i < n; i++) {
+    char *const key = StringFormat("key%zu", i % N_KEYS);
+    BENCH_SINK += DictHasKey(dict, key);
+    free(key);
+  }
+  DictDestroy(dict);
+}
+
+static void bench_IntDictGet(const size_t n) {
+  IntDict *dict = IntDictCreate();
+  for (size_t i = 0; i < N_KEYS; i++) {
+    IntDictSet(dict, i, (void *)i, NULL);
+  }
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += (size_t)IntDictGet(dict, i % N_KEYS);
+  }
+  IntDictDestroy(dict);
+}
+
+static void bench_IntDictChurn(const size_t n) {
+  IntDict *dict = IntDictCreate();
+  for (size_t i = 0; i < N_KEYS / 2; i++) {
+    IntDictSet(dict, i, NULL, NULL);
+  }
+  for (size_t i = 0; i < n; i++) {
+    IntDictRemove(dict, i);
+    IntDictSet(dict, i + (N_KEYS / 2), NULL, NULL);
+    BENCH_SINK += IntDictHasKey(dict, i + 1);
+  }
+  IntDictDestroy(dict);
+}
+
+BENCH_BEGIN
+BENCH_ADD("HashBytesShort", bench_HashBytesShort)
+BENCH_ADD("HashBytesLong", bench_HashBytesLong)
+BENCH_ADD("DictHasKeyMissing", bench_DictHasKeyMissing)
+BENCH_ADD("DictChurn", bench_DictChurn)
+BENCH_ADD("DictGetFormatted", bench_DictGetFormatted)
+BENCH_ADD("IntDictGet", bench_IntDictGet)
+BENCH_ADD("IntDictChurn", bench_IntDictChurn)
+BENCH_ADD_SIZED("DictSet", bench_DictSet)
+BENCH_ADD_SIZED("DictGet", bench_DictGet)
+BENCH_ADD_SIZED("DictRemove", bench_DictRemove)
+BENCH_END
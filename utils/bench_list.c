@@ -0,0 +1,54 @@
+#include "../tests/bench.h"
+
+#include "list.h"
+
+static List *NewList(const size_t size) {
+  List *const list = ListCreate();
+  for (size_t i = 0; i < size; i++) {
+    ListAppend(list, (void *)i, NULL);
+  }
+  return list;
+}
+
+/* Builds a list of the given size from scratch. */
+static void bench_ListAppend(const size_t n, const size_t size) {
+  for (size_t i = 0; i < n; i++) {
+    List *const list = NewList(size);
+    BENCH_SINK += ListLength(list);
+    ListDestroy(list);
+  }
+}
+
+/* Inserts at the front of a list of the given size, and removes the last
+ * element to keep the size constant. */
+static void bench_ListInsert(const size_t n, const size_t size) {
+  List *const list = NewList(size);
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    ListInsert(list, 0, (void *)i, NULL);
+    BENCH_SINK += (size_t)ListRemove(list, size);
+  }
+
+  ListDestroy(list);
+}
+
+/* Removes from the front of a list of the given size, and appends an element
+ * to keep the size constant. */
+static void bench_ListRemove(const size_t n, const size_t size) {
+  List *const list = NewList(size);
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    BENCH_SINK += (size_t)ListRemove(list, 0);
+    ListAppend(list, (void *)i, NULL);
+  }
+
+  ListDestroy(list);
+}
+
+BENCH_BEGIN
+BENCH_ADD_SIZED("ListAppend", bench_ListAppend)
+BENCH_ADD_SIZED("ListInsert", bench_ListInsert)
+BENCH_ADD_SIZED("ListRemove", bench_ListRemove)
+BENCH_END
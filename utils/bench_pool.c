@@ -0,0 +1,58 @@
+#include "../tests/bench.h"
+
+#include "pool.h"
+
+/* Size of the objects allocated, e.g., a syntax tree symbol. */
+#define OBJECT_SIZE 32
+
+static void *OBJECTS[65536];
+
+/* Allocates the given number of objects from the pool, and releases them in
+ * reverse order. */
+static void bench_PoolAlloc(const size_t n, const size_t size) {
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < size; j++) {
+      OBJECTS[j] = PoolAlloc(OBJECT_SIZE);
+    }
+    for (size_t j = size; j > 0; j--) {
+      PoolFree(OBJECTS[j - 1], OBJECT_SIZE);
+    }
+  }
+}
+
+/* Same as above, with malloc(3) and free(3). */
+static void bench_Malloc(const size_t n, const size_t size) {
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < size; j++) {
+      OBJECTS[j] = malloc(OBJECT_SIZE);
+    }
+    for (size_t j = size; j > 0; j--) {
+      free(OBJECTS[j - 1]);
+    }
+  }
+}
+
+/* Allocates and releases a single object from the pool. */
+static void bench_PoolAllocFree(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    void *const object = PoolAlloc(OBJECT_SIZE);
+    BENCH_SINK += (size_t)object;
+    PoolFree(object, OBJECT_SIZE);
+  }
+}
+
+/* Same as above, with malloc(3) and free(3). */
+static void bench_MallocFree(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    void *const object = malloc(OBJECT_SIZE);
+    BENCH_SINK += (size_t)object;
+    free(object);
+  }
+}
+
+BENCH_BEGIN
+BENCH_ADD_SIZED("PoolAlloc", bench_PoolAlloc)
+BENCH_ADD_SIZED("Malloc", bench_Malloc)
+BENCH_ADD("PoolAllocFree", bench_PoolAllocFree)
+BENCH_ADD("MallocFree", bench_MallocFree)
+BENCH_END
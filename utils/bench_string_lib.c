@@ -0,0 +1,92 @@
+#include "../tests/bench.h"
+
+#include "string_lib.h"
+
+static void bench_StringFormatInt(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    char *const str = StringFormat("key%zu", i);
+    BENCH_SINK += (size_t)str[0];
+    free(str);
+  }
+}
+
+/* Formats a string of the given size. */
+static void bench_StringFormat(const size_t n, const size_t size) {
+  char *const arg = malloc(size + 1);
+  memset(arg, 'x', size);
+  arg[size] = '\0';
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    char *const str = StringFormat("<%s>", arg);
+    BENCH_SINK += (size_t)str[0];
+    free(str);
+  }
+  free(arg);
+}
+
+static void bench_StringDuplicate(const size_t n, const size_t size) {
+  char *const arg = malloc(size + 1);
+  memset(arg, 'x', size);
+  arg[size] = '\0';
+
+  BenchResetTimer();
+  for (size_t i = 0; i < n; i++) {
+    char *const str = StringDuplicate(arg);
+    BENCH_SINK += (size_t)str[0];
+    free(str);
+  }
+  free(arg);
+}
+
+/* Literals as found in source code, see tests/progs/generate.sh. */
+static const char *const INTEGERS[] = {"0", "7", "42", "1999", "7919",
+                                       "65536", "1583808", "4294967296"};
+static const char *const FLOATS[] = {"0.5", "3.14", "42.0", "1.05",
+                                     "99.97", "1234.567", "0.001", "2.5"};
+
+#define NUM_LITERALS (sizeof(INTEGERS) / sizeof(INTEGERS[0]))
+
+static void bench_StringToUInt(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    const char *const str = INTEGERS[i % NUM_LITERALS];
+    unsigned long long value;
+    StringToUInt(str, strlen(str), &value);
+    BENCH_SINK += (size_t)value;
+  }
+}
+
+static void bench_ScanUInt(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    unsigned long long value;
+    sscanf(INTEGERS[i % NUM_LITERALS], "%llu", &value);
+    BENCH_SINK += (size_t)value;
+  }
+}
+
+static void bench_StringToDouble(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    const char *const str = FLOATS[i % NUM_LITERALS];
+    double value;
+    StringToDouble(str, strlen(str), &value);
+    BENCH_SINK += (size_t)value;
+  }
+}
+
+static void bench_ScanDouble(const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    double value;
+    sscanf(FLOATS[i % NUM_LITERALS], "%lf", &value);
+    BENCH_SINK += (size_t)value;
+  }
+}
+
+BENCH_BEGIN
+BENCH_ADD("StringFormatInt", bench_StringFormatInt)
+BENCH_ADD_SIZED("StringFormat", bench_StringFormat)
+BENCH_ADD_SIZED("StringDuplicate", bench_StringDuplicate)
+BENCH_ADD("StringToUInt", bench_StringToUInt)
+BENCH_ADD("ScanUInt", bench_ScanUInt)
+BENCH_ADD("StringToDouble", bench_StringToDouble)
+BENCH_ADD("ScanDouble", bench_ScanDouble)
+BENCH_END
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -11,47 +12,95 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "alloc.h"
 #include "logger.h"
 
-struct Buffer {
-  size_t length;
-  size_t capacity;
-  char *buffer;
-};
+/**
+ * @brief Check whether the buffer contents are stored in the buffer itself.
+ * @param buf Buffer.
+ * @return True if stored inline, false if stored on the heap.
+ */
+static bool IsInline(const Buffer *const buf) {
+  return buf->buffer == buf->inline_buffer;
+}
 
-static void EnsureCapacity(Buffer *const buf, const size_t needed) {
+/**
+ * @brief Grow the buffer straight to the size needed.
+ * @param buf Buffer.
+ * @param needed Number of additional bytes, excluding terminating null-byte.
+ * @note The capacity at least doubles, so appending is amortized O(1). The
+ *       first heap allocation is at least DEFAULT_BUFFER_CAPACITY bytes.
+ */
+static void Grow(Buffer *const buf, const size_t needed) {
   assert(buf != NULL);
 
-  while ((buf->capacity - buf->length) <= needed) {
-    size_t new_capacity =
-        (buf->capacity > 0) ? buf->capacity * 2 : DEFAULT_BUFFER_CAPACITY;
-    char *new_buffer = (char *)realloc(buf->buffer, new_capacity);
-    if (new_buffer == NULL) {
-      LOG_CRITICAL("realloc(3): Failed to allocate memory: %s",
-                   strerror(errno));
-    }
-    buf->capacity = new_capacity;
-    buf->buffer = new_buffer;
+  size_t new_capacity = buf->capacity * 2;
+  if (new_capacity < buf->length + needed + 1) {
+    new_capacity = buf->length + needed + 1;
+  }
+  if (new_capacity < DEFAULT_BUFFER_CAPACITY) {
+    new_capacity = DEFAULT_BUFFER_CAPACITY;
+  }
+
+  char *new_buffer;
+  if (IsInline(buf)) {
+    new_buffer = (char *)xmalloc(new_capacity);
+    memcpy(new_buffer, buf->inline_buffer, buf->length + 1);
+  } else {
+    new_buffer = (char *)xrealloc(buf->buffer, new_capacity);
   }
+
+  buf->capacity = new_capacity;
+  buf->buffer = new_buffer;
 }
 
-Buffer *BufferCreate(void) {
-  Buffer *buf = (Buffer *)malloc(sizeof(Buffer));
-  if (buf == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
+static void EnsureCapacity(Buffer *const buf, const size_t needed) {
+  assert(buf != NULL);
+
+  if ((buf->capacity - buf->length) <= needed) {
+    Grow(buf, needed);
   }
+}
+
+void BufferInit(Buffer *const buf) {
+  assert(buf != NULL);
 
-  buf->capacity = DEFAULT_BUFFER_CAPACITY;
   buf->length = 0;
-  buf->buffer = (char *)malloc(buf->capacity);
-  if (buf->buffer == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+  buf->capacity = BUFFER_INLINE_CAPACITY;
+  buf->buffer = buf->inline_buffer;
   buf->buffer[0] = '\0';
+}
+
+void BufferDeinit(Buffer *const buf) {
+  assert(buf != NULL);
+
+  if (!IsInline(buf)) {
+    xfree(buf->buffer);
+  }
+  BufferInit(buf);
+}
 
+Buffer *BufferCreate(void) {
+  Buffer *buf = (Buffer *)xmalloc(sizeof(Buffer));
+
+  BufferInit(buf);
   return buf;
 }
 
+void BufferReserve(Buffer *const buf, const size_t needed) {
+  assert(buf != NULL);
+  EnsureCapacity(buf, needed);
+}
+
+void BufferClear(Buffer *const buf) {
+  assert(buf != NULL);
+
+  buf->length = 0;
+  if (buf->capacity > 0) {
+    buf->buffer[0] = '\0';
+  }
+}
+
 const char *BufferData(const Buffer *const buf) {
   assert(buf != NULL);
   return buf->buffer;
@@ -73,54 +122,165 @@ void BufferAppend(Buffer *const buf, const char ch) {
 void BufferPrint(Buffer *const buf, const char *const str) {
   assert(buf != NULL);
   assert(str != NULL);
+  BufferPrintN(buf, str, strlen(str));
+}
+
+void BufferPrintN(Buffer *const buf, const char *const str,
+                  const size_t length) {
+  assert(buf != NULL);
+  assert(str != NULL || length == 0);
 
-  const size_t length = strlen(str);
   EnsureCapacity(buf, length);
-  memcpy(buf->buffer + buf->length, str, length);
+  if (length > 0) {
+    memcpy(buf->buffer + buf->length, str, length);
+  }
   buf->length += length;
   buf->buffer[buf->length] = '\0';
   assert(buf->length <= buf->capacity);
 }
 
-void BufferPrintFormat(Buffer *const buf, const char *const fmt, ...) {
+void BufferVPrintFormat(Buffer *const buf, const char *const fmt,
+                        va_list ap) {
   assert(buf != NULL);
   assert(fmt != NULL);
 
-  va_list ap;
-
-  // Figure out how many bytes we need
-  va_start(ap, fmt);
-  const int length = vsnprintf(NULL, 0, fmt, ap);
-  va_end(ap);
+  // Format straight into the spare capacity, which is usually enough
+  va_list copy;
+  va_copy(copy, ap);
+  const size_t available = buf->capacity - buf->length;
+  const int length = vsnprintf((available > 0) ? buf->buffer + buf->length
+                                               : NULL,
+                               available, fmt, copy);
+  va_end(copy);
 
   if (length < 0) {
     LOG_CRITICAL("vsnprintf(3): Unexpected return value (%d < 0): %s", length,
                  strerror(errno));
   }
-  EnsureCapacity(buf, (size_t)length);
 
+  // Output was truncated, grow to the exact size and format again
+  if ((size_t)length >= available) {
+    EnsureCapacity(buf, (size_t)length);
+    const int ret = vsnprintf(buf->buffer + buf->length,
+                              buf->capacity - buf->length, fmt, ap);
+    if (ret != length) {
+      LOG_CRITICAL("vsnprintf(3): Unexpected return value (%d != %d): %s", ret,
+                   length, strerror(errno));
+    }
+  }
+
+  buf->length += (size_t)length;
+  assert(buf->length < buf->capacity);
+}
+
+void BufferPrintFormat(Buffer *const buf, const char *const fmt, ...) {
+  assert(buf != NULL);
+  assert(fmt != NULL);
+
+  va_list ap;
   va_start(ap, fmt);
-  const int ret = vsnprintf(buf->buffer + buf->length,
-                            buf->capacity - buf->length, fmt, ap);
+  BufferVPrintFormat(buf, fmt, ap);
   va_end(ap);
+}
+
+/* Two-digit lookup table, which halves the number of divisions needed to
+ * convert an integer. */
+static const char DIGIT_PAIRS[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
 
-  if (ret != length) {
-    LOG_CRITICAL("vsnprintf(3): Unexpected return value (%d != %d): %s", ret,
-                 length, strerror(errno));
+/**
+ * @brief Convert an unsigned integer to decimal digits.
+ * @param value The integer.
+ * @param end One past the last byte to write.
+ * @return Pointer to the first digit written.
+ * @note Digits are written backwards from end.
+ */
+static char *FormatDigits(unsigned long long value, char *end) {
+  while (value >= 100) {
+    const size_t i = (size_t)(value % 100) * 2;
+    value /= 100;
+    *--end = DIGIT_PAIRS[i + 1];
+    *--end = DIGIT_PAIRS[i];
+  }
+  if (value >= 10) {
+    const size_t i = (size_t)value * 2;
+    *--end = DIGIT_PAIRS[i + 1];
+    *--end = DIGIT_PAIRS[i];
+  } else {
+    *--end = (char)('0' + value);
   }
+  return end;
+}
 
-  buf->length += (size_t)length;
-  assert(buf->length <= buf->capacity);
+void BufferPrintUInt(Buffer *const buf, const unsigned long long value) {
+  assert(buf != NULL);
+
+  char digits[20];
+  char *const end = digits + sizeof(digits);
+  const char *const start = FormatDigits(value, end);
+  BufferPrintN(buf, start, (size_t)(end - start));
+}
+
+void BufferPrintInt(Buffer *const buf, const long long value) {
+  assert(buf != NULL);
+
+  char digits[21];
+  char *const end = digits + sizeof(digits);
+
+  // Negate in unsigned arithmetic, which is well defined for LLONG_MIN
+  const unsigned long long magnitude =
+      (value < 0) ? 0ULL - (unsigned long long)value
+                  : (unsigned long long)value;
+  char *start = FormatDigits(magnitude, end);
+  if (value < 0) {
+    *--start = '-';
+  }
+  BufferPrintN(buf, start, (size_t)(end - start));
+}
+
+void BufferPrintFloat(Buffer *const buf, const double value) {
+  assert(buf != NULL);
+
+  /* Integral values below 2^53 are exact, so their "%f" representation is
+   * just the digits followed by six zeros. Anything else needs correct
+   * rounding of the binary fraction, which is left to printf. */
+  if (value > -9007199254740992.0 && value < 9007199254740992.0 &&
+      value == (double)(long long)value) {
+    if (value == 0.0 && signbit(value)) {
+      BufferPrintN(buf, "-", 1);
+    }
+    BufferPrintInt(buf, (long long)value);
+    BufferPrintN(buf, ".000000", 7);
+    return;
+  }
+
+  BufferPrintFormat(buf, "%f", value);
 }
 
 char *BufferToString(Buffer *const buf) {
   assert(buf != NULL);
-  char *const str = buf->buffer;
-  free(buf);
+
+  char *str = buf->buffer;
+  if (IsInline(buf)) {
+    str = (char *)xmalloc(buf->length + 1);
+    memcpy(str, buf->inline_buffer, buf->length + 1);
+  }
+
+  xfree(buf);
   return str;
 }
 
 Buffer *BufferFromString(const char *const str) {
+  assert(str != NULL);
+
   Buffer *const buf = BufferCreate();
   BufferPrint(buf, str);
   return buf;
@@ -137,10 +297,20 @@ bool BufferReadFile(Buffer *const buf, const char *const filename) {
     return false;
   }
 
+  /* Make room for the whole file up front if we can tell its size. The extra
+   * byte lets the final read detect end of file without growing the buffer. */
+  struct stat sb;
+  if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+    EnsureCapacity(buf, (size_t)sb.st_size + 1);
+  }
+
   ssize_t n_read = 0;
   do {
-    EnsureCapacity(buf, DEFAULT_BUFFER_CAPACITY);
-    n_read = read(fd, buf->buffer + buf->length, DEFAULT_BUFFER_CAPACITY);
+    if ((buf->capacity - buf->length) <= 1) {
+      EnsureCapacity(buf, DEFAULT_BUFFER_CAPACITY);
+    }
+    const size_t available = buf->capacity - buf->length - 1;
+    n_read = read(fd, buf->buffer + buf->length, available);
     if (n_read < 0) {
       LOG_ERROR("Failed to read file '%s': %s", filename, strerror(errno));
       close(fd);
@@ -161,7 +331,9 @@ bool BufferReadFile(Buffer *const buf, const char *const filename) {
 void BufferDestroy(void *const ptr) {
   Buffer *const buf = (Buffer *)ptr;
   if (buf != NULL) {
-    free(buf->buffer);
-    free(buf);
+    if (!IsInline(buf)) {
+      xfree(buf->buffer);
+    }
+    xfree(buf);
   }
 }
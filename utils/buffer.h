@@ -1,10 +1,25 @@
 #ifndef _AETHER_BUFFER_H
 #define _AETHER_BUFFER_H
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
-typedef struct Buffer Buffer;
+/* Number of bytes that fit in the buffer itself, including the terminating
+ * null-byte, before it moves its contents to the heap. */
+#define BUFFER_INLINE_CAPACITY 64
+
+/**
+ * @note The struct is public so that buffers can live on the stack (see
+ *       BufferInit()). Its members are private. A buffer may point into
+ *       itself, so it must never be copied or moved by value.
+ */
+typedef struct Buffer {
+  size_t length;
+  size_t capacity;
+  char *buffer;
+  char inline_buffer[BUFFER_INLINE_CAPACITY];
+} Buffer;
 
 /**
  * @brief Create a buffer.
@@ -13,6 +28,37 @@ typedef struct Buffer Buffer;
  */
 Buffer *BufferCreate(void);
 
+/**
+ * @brief Initialize a buffer allocated by the caller, e.g., on the stack.
+ * @param buf Buffer.
+ * @note Short contents are stored in the buffer itself, without allocating.
+ *       Release any memory the buffer acquired with BufferDeinit().
+ */
+void BufferInit(Buffer *buf);
+
+/**
+ * @brief Release memory held by a buffer initialized with BufferInit().
+ * @param buf Buffer.
+ * @note The buffer itself is not freed, and may be initialized again.
+ */
+void BufferDeinit(Buffer *buf);
+
+/**
+ * @brief Make room for a number of additional bytes.
+ * @param buf Buffer.
+ * @param needed Number of bytes to make room for, excluding terminating
+ *               null-byte.
+ * @note Use this before a series of appends of known total size, to grow the
+ *       buffer at most once.
+ */
+void BufferReserve(Buffer *buf, size_t needed);
+
+/**
+ * @brief Empty the buffer, keeping its capacity.
+ * @param buf Buffer.
+ */
+void BufferClear(Buffer *buf);
+
 /**
  * @brief Get buffer data.
  * @param buf Buffer.
@@ -41,14 +87,57 @@ void BufferAppend(Buffer *buf, char ch);
  */
 void BufferPrint(Buffer *buf, const char *str);
 
+/**
+ * @brief Print string of known length to buffer.
+ * @param buf Buffer.
+ * @param str String.
+ * @param length Number of bytes to print from string.
+ */
+void BufferPrintN(Buffer *buf, const char *str, size_t length);
+
 /**
  * @brief Print string to buffer.
  * @param buf Buffer.
  * @param fmt Format string.
  * @param ... Format arguments.
+ * @note The string is formatted directly into the buffer. It's only formatted
+ *       a second time if it did not fit.
  */
 void BufferPrintFormat(Buffer *buf, const char *fmt, ...);
 
+/**
+ * @brief Print string to buffer.
+ * @param buf Buffer.
+ * @param fmt Format string.
+ * @param ap Format arguments.
+ */
+void BufferVPrintFormat(Buffer *buf, const char *fmt, va_list ap);
+
+/**
+ * @brief Print signed integer to buffer.
+ * @param buf Buffer.
+ * @param value Integer.
+ * @note Same output as "%lld", without parsing a format string.
+ */
+void BufferPrintInt(Buffer *buf, long long value);
+
+/**
+ * @brief Print unsigned integer to buffer.
+ * @param buf Buffer.
+ * @param value Integer.
+ * @note Same output as "%llu", without parsing a format string.
+ */
+void BufferPrintUInt(Buffer *buf, unsigned long long value);
+
+/**
+ * @brief Print floating point number to buffer.
+ * @param buf Buffer.
+ * @param value Number.
+ * @note Same output as "%f". Integral values take a fast path, anything else
+ *       is formatted by printf.
+ */
+void BufferPrintFloat(Buffer *buf, double value);
+
 /**
  * @brief Convert buffer to string.
  * @param buf Buffer.
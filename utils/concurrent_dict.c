@@ -0,0 +1,162 @@
+#include "concurrent_dict.h"
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "dict.h"
+#include "logger.h"
+
+typedef struct Stripe {
+  pthread_rwlock_t lock;
+  Dict *dict;
+} Stripe;
+
+struct ConcurrentDict {
+  Stripe stripes[DEFAULT_CONCURRENT_DICT_STRIPES];
+};
+
+/**
+ * @brief Find the stripe holding a key.
+ * @param dict The dictionary.
+ * @param hash Hash of the key, as returned by DictHashKey().
+ * @return The stripe.
+ * @note The lock is part of the stripe, hence it is returned as mutable even
+ *       for read-only operations. The hash is passed on to the stripe
+ *       dictionary, so that keys are only hashed once.
+ */
+static Stripe *GetStripe(const ConcurrentDict *const dict,
+                         const uint64_t hash) {
+  assert(dict != NULL);
+
+  // Use the high bits, the stripe dictionary indexes by the low ones
+  const size_t i = (size_t)(hash >> 32) % DEFAULT_CONCURRENT_DICT_STRIPES;
+  return (Stripe *)&dict->stripes[i];
+}
+
+/**
+ * @brief Lock a stripe.
+ * @param stripe The stripe.
+ * @param write Whether to lock for writing.
+ */
+static void Lock(Stripe *const stripe, const bool write) {
+  const int ret = (write) ? pthread_rwlock_wrlock(&stripe->lock)
+                          : pthread_rwlock_rdlock(&stripe->lock);
+  if (ret != 0) {
+    LOG_CRITICAL("pthread_rwlock_%slock(3): Failed to lock: %s",
+                 (write) ? "wr" : "rd", strerror(ret));
+  }
+}
+
+/**
+ * @brief Unlock a stripe.
+ * @param stripe The stripe.
+ */
+static void Unlock(Stripe *const stripe) {
+  const int ret = pthread_rwlock_unlock(&stripe->lock);
+  if (ret != 0) {
+    LOG_CRITICAL("pthread_rwlock_unlock(3): Failed to unlock: %s",
+                 strerror(ret));
+  }
+}
+
+ConcurrentDict *ConcurrentDictCreate(void) {
+  ConcurrentDict *const dict =
+      (ConcurrentDict *)xmalloc(sizeof(ConcurrentDict));
+
+  // The default capacity is spread over the stripes
+  const size_t capacity =
+      (size_t)((float)DEFAULT_DICT_CAPACITY * DEFAULT_DICT_MAX_LOAD_FACTOR) /
+      DEFAULT_CONCURRENT_DICT_STRIPES;
+
+  for (size_t i = 0; i < DEFAULT_CONCURRENT_DICT_STRIPES; i++) {
+    Stripe *const stripe = dict->stripes + i;
+    const int ret = pthread_rwlock_init(&stripe->lock, NULL);
+    if (ret != 0) {
+      LOG_CRITICAL("pthread_rwlock_init(3): Failed to initialize lock: %s",
+                   strerror(ret));
+    }
+    stripe->dict = DictCreateWithCapacity(capacity);
+  }
+
+  return dict;
+}
+
+void ConcurrentDictDestroy(void *const ptr) {
+  ConcurrentDict *const dict = (ConcurrentDict *)ptr;
+  if (dict == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < DEFAULT_CONCURRENT_DICT_STRIPES; i++) {
+    Stripe *const stripe = dict->stripes + i;
+    DictDestroy(stripe->dict);
+    pthread_rwlock_destroy(&stripe->lock);
+  }
+
+  xfree(dict);
+}
+
+size_t ConcurrentDictLength(const ConcurrentDict *const dict) {
+  assert(dict != NULL);
+
+  size_t length = 0;
+  for (size_t i = 0; i < DEFAULT_CONCURRENT_DICT_STRIPES; i++) {
+    Stripe *const stripe = (Stripe *)&dict->stripes[i];
+    Lock(stripe, false);
+    length += DictLength(stripe->dict);
+    Unlock(stripe);
+  }
+
+  return length;
+}
+
+void ConcurrentDictSet(ConcurrentDict *const dict, const char *const key,
+                       void *const value, void (*destroy)(void *)) {
+  const uint64_t hash = DictHashKey(key);
+  Stripe *const stripe = GetStripe(dict, hash);
+  Lock(stripe, true);
+  DictSetHashed(stripe->dict, key, hash, value, destroy);
+  Unlock(stripe);
+}
+
+bool ConcurrentDictHasKey(const ConcurrentDict *const dict,
+                          const char *const key) {
+  const uint64_t hash = DictHashKey(key);
+  Stripe *const stripe = GetStripe(dict, hash);
+  Lock(stripe, false);
+  const bool found = DictGetHashed(stripe->dict, key, hash, NULL);
+  Unlock(stripe);
+  return found;
+}
+
+bool ConcurrentDictGet(const ConcurrentDict *const dict, const char *const key,
+                       void *(*copy)(const void *), void **const value) {
+  assert(value != NULL);
+
+  const uint64_t hash = DictHashKey(key);
+  Stripe *const stripe = GetStripe(dict, hash);
+  Lock(stripe, false);
+  const void *item;
+  const bool found = DictGetHashed(stripe->dict, key, hash, &item);
+  if (found) {
+    *value = (copy != NULL) ? copy(item) : (void *)item;
+  }
+  Unlock(stripe);
+  return found;
+}
+
+bool ConcurrentDictRemove(ConcurrentDict *const dict, const char *const key,
+                          void **const value) {
+  assert(value != NULL);
+
+  const uint64_t hash = DictHashKey(key);
+  Stripe *const stripe = GetStripe(dict, hash);
+  Lock(stripe, true);
+  const bool found = DictRemoveHashed(stripe->dict, key, hash, value);
+  Unlock(stripe);
+  return found;
+}
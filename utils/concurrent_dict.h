@@ -0,0 +1,82 @@
+#ifndef _AETHER_CONCURRENT_DICT_H
+#define _AETHER_CONCURRENT_DICT_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct ConcurrentDict ConcurrentDict;
+
+/**
+ * @brief Create a dictionary that can be shared between threads.
+ * @return The dictionary.
+ * @note Caller takes ownership of returned value. Keys are spread over a
+ *       number of stripes, each with its own read-write lock, so threads
+ *       working on different stripes never wait for each other.
+ */
+ConcurrentDict *ConcurrentDictCreate(void);
+
+/**
+ * @brief Destroy the dictionary.
+ * @param dict Pointer to dictionary.
+ * @note If ptr is NULL, no operation is performed. Otherwise, values are
+ *       destroyed using passed destroy function unless it's NULL. No other
+ *       thread may use the dictionary at this point.
+ */
+void ConcurrentDictDestroy(void *dict);
+
+/**
+ * @brief Get number of entries in dictionary.
+ * @param dict The dictionary.
+ * @return Number of entries in dictionary.
+ * @note The stripes are counted one at a time, so the result is only exact if
+ *       no other thread modifies the dictionary meanwhile.
+ */
+size_t ConcurrentDictLength(const ConcurrentDict *dict);
+
+/**
+ * @brief Create/update entry in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param value Value of entry.
+ * @param destroy Function to destroy the value of the entry or NULL.
+ */
+void ConcurrentDictSet(ConcurrentDict *dict, const char *key, void *value,
+                       void (*destroy)(void *));
+
+/**
+ * @brief Check for existance of entry in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return True if entry with key exists.
+ */
+bool ConcurrentDictHasKey(const ConcurrentDict *dict, const char *key);
+
+/**
+ * @brief Get a copy of the value of entry with key in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param copy Function to copy the value while the entry is locked, or NULL
+ *             to get the value itself.
+ * @param value Output for the copy.
+ * @return True if entry with key exists.
+ * @note Another thread may replace or remove the entry as soon as this
+ *       returns, so borrowed values are only safe to use if they outlive the
+ *       dictionary. Caller takes ownership of the copy.
+ */
+bool ConcurrentDictGet(const ConcurrentDict *dict, const char *key,
+                       void *(*copy)(const void *), void **value);
+
+/**
+ * @brief Remove entry from dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param value Output for value of entry.
+ * @return True if entry with key existed.
+ * @note Caller takes ownership of returned value. Unlike DictRemove(), a
+ *       missing key is not an error, since another thread may have removed
+ *       it first.
+ */
+bool ConcurrentDictRemove(ConcurrentDict *dict, const char *key,
+                          void **value);
+
+#endif // _AETHER_CONCURRENT_DICT_H
@@ -2,159 +2,607 @@
 #include "config.h"
 
 #include <assert.h>
-#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "alloc.h"
+#include "hash.h"
 #include "list.h"
 #include "logger.h"
 #include "string_lib.h"
 
+/* Each insert adds at most one entry to the new index while a resize is in
+ * progress. Migrating fewer slots than this per operation could fill the new
+ * index before the old one is drained. */
+#if DEFAULT_DICT_REHASH_STEP < 4
+#error "DEFAULT_DICT_REHASH_STEP must be at least 4"
+#endif
+
+/* Index slots hold the position of an entry plus one, so that zero can mark an
+ * empty slot. */
+#define INDEX_EMPTY 0
+#define INDEX_MOVED UINT32_MAX
+#define MAX_ENTRIES ((size_t)UINT32_MAX - 1)
+
 typedef struct Entry {
-  char *key;
+  size_t hash;
+  size_t length; // Length of the key
+  char *key;     // NULL if the entry is removed
   void *value;
   void (*destroy)(void *);
-  bool invalidated;
 } Entry;
 
+/* Entries are stored densely in insertion order. A separate open addressing
+ * index maps hashes to positions in the entry array. Removing an entry frees
+ * its index slot, but leaves a hole in the entry array, which is reclaimed by
+ * an incremental compaction once holes make up a third of the array.
+ *
+ * The entry array is split into segments that never move once allocated. The
+ * first segment holds the initial capacity. The second holds that capacity
+ * rounded up to a power of two, and every further segment is twice the size
+ * of the previous one. Hence, growing the array allocates one segment rather
+ * than copying every entry, and a position maps to its segment in constant
+ * time.
+ *
+ * Compared to one contiguous array, this costs a branch on every entry access,
+ * plus a bit scan and an extra indirection past the first segment. Iteration
+ * still scans memory linearly, one segment after another. In exchange, no
+ * operation but DictShrinkToFit() touches more than a bounded number of
+ * entries. At a steady length, the segments hold at most about three times
+ * the live entries.
+ */
 struct Dict {
   size_t length;
+  size_t num_entries;      // Positions in use, including holes
+  size_t entries_capacity; // Total size of the segments
+  Entry **segments;
+  size_t num_segments;
+  size_t first_capacity; // Size of the first segment
+  unsigned int shift;    // Log2 of the size of the second segment
+
   size_t capacity;
   size_t in_use;
-  Entry **buffer;
+  uint32_t *index;
+
+  /* While the index is being resized, slots not yet migrated remain in the
+   * old index. Both indices are consulted on lookup, and each modifying
+   * operation migrates a bounded number of slots from the old index to the
+   * new one. Migrated slots are marked as moved, which keeps the probe
+   * sequences through them intact. */
+  size_t old_capacity;
+  size_t rehash_index;
+  uint32_t *old_index;
+
+  /* While holes are being squeezed out of the entry array, entries before
+   * compact_write are compacted, entries from compact_read on are not yet,
+   * and the positions in between are holes. Like the index resize, each
+   * modifying operation moves a bounded number of entries. */
+  bool compacting;
+  size_t compact_read;
+  size_t compact_write;
 };
 
+/**
+ * @brief Get the position of the highest set bit.
+ * @param value The value, must not be zero.
+ * @return The position, zero for the least significant bit.
+ */
+static unsigned int HighestBit(const size_t value) {
+  assert(value != 0);
+#if defined(__GNUC__)
+  return (unsigned int)(sizeof(unsigned long long) * CHAR_BIT - 1) -
+         (unsigned int)__builtin_clzll((unsigned long long)value);
+#else
+  unsigned int bit = 0;
+  for (size_t rest = value >> 1; rest != 0; rest >>= 1) {
+    bit += 1;
+  }
+  return bit;
+#endif
+}
+
+/**
+ * @brief Get the entry at a position of the entry array.
+ * @param dict The dictionary.
+ * @param position The position.
+ * @return The entry.
+ */
+static Entry *GetEntry(const Dict *const dict, size_t position) {
+  assert(dict != NULL);
+  assert(position < dict->entries_capacity);
+
+  if (position < dict->first_capacity) {
+    return dict->segments[0] + position;
+  }
+
+  /* Segment k + 1 starts (2^k - 1) second segment sizes after the end of
+   * the first segment. */
+  position -= dict->first_capacity;
+  const unsigned int k = HighestBit((position >> dict->shift) + 1);
+  const size_t start = (((size_t)1 << k) - 1) << dict->shift;
+  return dict->segments[k + 1] + (position - start);
+}
+
 /**
  * @brief Hash a key.
  * @param key The key.
+ * @param length Length of the key.
  * @return The hash.
+ * @note The hash is keyed with a random seed, which prevents crafted keys from
+ *       colliding in the index.
  */
-static size_t HashKey(const char *const key) {
+static uint64_t HashKey(const char *const key, const size_t length) {
   assert(key != NULL);
-
-  size_t hash = 5381;
-  const size_t length = strlen(key);
-  for (size_t i = 0; i < length; i++) {
-    hash = ((hash << 5) + hash) + (size_t)key[i];
-  }
-  return hash;
+  return HashBytes(key, length);
 }
 
 /**
- * @brief Compute the available index of a new entry in a dictionary.
+ * @brief Find the slot of a key in an index.
  * @param dict The dictionary.
+ * @param index The index.
+ * @param capacity The number of slots in the index.
+ * @param hash Hash of the key.
  * @param key The key.
- * @return The index.
+ * @param length Length of the key.
+ * @return Slot referring to the entry with the key, or the empty slot
+ *         terminating the probe sequence.
  */
-static size_t ComputeIndex(const Dict *const dict, const char *const key) {
+static size_t FindSlot(const Dict *const dict, const uint32_t *const index,
+                       const size_t capacity, const size_t hash,
+                       const char *const key, const size_t length) {
   assert(dict != NULL);
-  assert(dict->buffer != NULL);
+  assert(index != NULL);
   assert(key != NULL);
 
-  size_t index = HashKey(key) % dict->capacity;
+  const size_t mask = capacity - 1;
+  size_t slot = hash & mask;
   while (true) {
-    Entry *entry = dict->buffer[index];
-    if (entry == NULL) {
+    const uint32_t position = index[slot];
+    if (position == INDEX_EMPTY) {
       break;
     }
-    if (!entry->invalidated && StringEqual(entry->key, key)) {
+    if (position != INDEX_MOVED) {
+      const Entry *const entry = GetEntry(dict, position - 1);
+      assert(entry->key != NULL);
+      if (entry->hash == hash && entry->length == length &&
+          memcmp(entry->key, key, length) == 0) {
+        break;
+      }
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  return slot;
+}
+
+/**
+ * @brief Add an entry to an index.
+ * @param index The index.
+ * @param capacity The number of slots in the index.
+ * @param hash Hash of the entry key.
+ * @param position Position of the entry in the entry array.
+ * @note The key must not already be in the index.
+ */
+static void IndexInsert(uint32_t *const index, const size_t capacity,
+                        const size_t hash, const size_t position) {
+  assert(index != NULL);
+  assert(position < MAX_ENTRIES);
+
+  const size_t mask = capacity - 1;
+  size_t slot = hash & mask;
+  while (index[slot] != INDEX_EMPTY) {
+    slot = (slot + 1) & mask;
+  }
+  index[slot] = (uint32_t)(position + 1);
+}
+
+/**
+ * @brief Remove a slot from an index by shifting back the slots after it.
+ * @param dict The dictionary.
+ * @param index The index.
+ * @param capacity The number of slots in the index.
+ * @param slot The slot to remove.
+ * @note Following slots are moved into the hole for as long as that brings
+ *       them closer to their home slot. This leaves the index exactly as if the
+ *       removed entry had never been inserted, so no tombstones are needed and
+ *       probe sequences do not degrade with churn.
+ */
+static void IndexRemove(const Dict *const dict, uint32_t *const index,
+                        const size_t capacity, size_t slot) {
+  assert(dict != NULL);
+  assert(index != NULL);
+  assert(index[slot] != INDEX_EMPTY);
+
+  const size_t mask = capacity - 1;
+  size_t next = slot;
+  while (true) {
+    next = (next + 1) & mask;
+    const uint32_t position = index[next];
+    if (position == INDEX_EMPTY) {
       break;
     }
-    index = (index + 1) % dict->capacity;
+
+    /* The entry may fill the hole unless its home slot lies cyclically in
+     * (slot, next], in which case moving it would put it before its home. */
+    const size_t home = GetEntry(dict, position - 1)->hash & mask;
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      index[slot] = position;
+      slot = next;
+    }
   }
+  index[slot] = INDEX_EMPTY;
+}
 
-  return index;
+/**
+ * @brief Find the entry with a given key in either index.
+ * @param dict The dictionary.
+ * @param key The key.
+ * @param length Length of the key.
+ * @param hash Hash of the key.
+ * @return The entry or NULL if there is no such entry.
+ */
+static Entry *FindEntry(const Dict *const dict, const char *const key,
+                        const size_t length, const size_t hash) {
+  assert(dict != NULL);
+  assert(dict->index != NULL);
+
+  size_t slot = FindSlot(dict, dict->index, dict->capacity, hash, key, length);
+  uint32_t position = dict->index[slot];
+
+  if (position == INDEX_EMPTY && dict->old_index != NULL) {
+    slot = FindSlot(dict, dict->old_index, dict->old_capacity, hash, key,
+                    length);
+    position = dict->old_index[slot];
+  }
+
+  return (position == INDEX_EMPTY) ? NULL : GetEntry(dict, position - 1);
 }
 
-static void EnsureCapacity(Dict *const dict) {
+/**
+ * @brief Point the index slot referring to an entry to its new position.
+ * @param index The index.
+ * @param capacity The number of slots in the index.
+ * @param hash Hash of the entry key.
+ * @param from Old position of the entry.
+ * @param to New position of the entry.
+ * @return False if the index has no slot referring to the entry.
+ * @note Slots are matched by position, hence no keys are compared.
+ */
+static bool IndexMove(uint32_t *const index, const size_t capacity,
+                      const size_t hash, const size_t from, const size_t to) {
+  assert(index != NULL);
+
+  const size_t mask = capacity - 1;
+  for (size_t slot = hash & mask; index[slot] != INDEX_EMPTY;
+       slot = (slot + 1) & mask) {
+    if (index[slot] == (uint32_t)(from + 1)) {
+      index[slot] = (uint32_t)(to + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Allocate an empty index.
+ * @param capacity The number of slots in the index.
+ * @return The index.
+ */
+static uint32_t *CreateIndex(const size_t capacity) {
+  assert(capacity > 0);
+  assert((capacity & (capacity - 1)) == 0);
+
+  return (uint32_t *)xcalloc(capacity, sizeof(uint32_t));
+}
+
+/**
+ * @brief Compute the index size needed to hold a number of entries.
+ * @param length The number of entries.
+ * @return The capacity.
+ * @note The index always keeps at least one empty slot, which terminates
+ *       probing, and its size is always a power of two.
+ */
+static size_t CapacityFor(const size_t length) {
+  const size_t needed =
+      (size_t)((float)length / DEFAULT_DICT_MAX_LOAD_FACTOR) + 1;
+  size_t capacity = 1;
+  while (capacity < needed) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+/**
+ * @brief Migrate a bounded number of slots from the old index to the new one.
+ * @param dict The dictionary.
+ * @param n_slots Maximum number of slots to migrate.
+ * @note The old index is released once every slot is migrated.
+ */
+static void RehashStep(Dict *const dict, const size_t n_slots) {
   assert(dict != NULL);
-  assert(DEFAULT_DICT_MAX_LOAD_FACTOR > DEFAULT_DICT_MIN_LOAD_FACTOR);
 
-  if ((float)dict->in_use <
-      ((float)dict->capacity * DEFAULT_DICT_MAX_LOAD_FACTOR)) {
+  if (dict->old_index == NULL) {
     return;
   }
 
-  /* If we can free enough of the capacity by removing invalidated items, there
-   * is no need to expand the buffer. */
-  assert(dict->in_use >= dict->length);
-  const bool expand =
-      (((float)dict->capacity / 100.f) * (float)(dict->in_use - dict->length)) <
-      DEFAULT_DICT_MIN_LOAD_FACTOR;
+  for (size_t i = 0;
+       (i < n_slots) && (dict->rehash_index < dict->old_capacity); i++) {
+    uint32_t *const slot = dict->old_index + dict->rehash_index++;
+    const uint32_t position = *slot;
+    if (position == INDEX_EMPTY || position == INDEX_MOVED) {
+      continue;
+    }
 
-  const size_t new_capacity = (expand) ? dict->capacity * 2 : dict->capacity;
-  Entry **const new_buffer = (Entry **)calloc(new_capacity, sizeof(Entry *));
-  if (new_buffer == NULL) {
-    LOG_CRITICAL("calloc(3): Failed to allocate memory: %s", strerror(errno));
+    const Entry *const entry = GetEntry(dict, position - 1);
+    IndexInsert(dict->index, dict->capacity, entry->hash, position - 1);
+    dict->in_use += 1;
+    *slot = INDEX_MOVED;
   }
 
-  Entry **const old_buffer = dict->buffer;
-  dict->buffer = new_buffer;
-  const size_t old_capacity = dict->capacity;
-  dict->capacity = new_capacity;
+  if (dict->rehash_index >= dict->old_capacity) {
+    xfree(dict->old_index);
+    dict->old_index = NULL;
+    dict->old_capacity = 0;
+    dict->rehash_index = 0;
+  }
+}
+
+/**
+ * @brief Move a bounded number of entries over the holes before them.
+ * @param dict The dictionary.
+ * @param n_positions Maximum number of positions to advance by.
+ * @note Once every position is visited, the holes left at the end of the
+ *       entry array are reclaimed.
+ */
+static void CompactStep(Dict *const dict, const size_t n_positions) {
+  assert(dict != NULL);
 
-  for (size_t i = 0; expand && (i < old_capacity); i++) {
-    Entry *const entry = old_buffer[i];
-    if (entry == NULL) {
+  if (!dict->compacting) {
+    return;
+  }
+
+  for (size_t i = 0;
+       (i < n_positions) && (dict->compact_read < dict->num_entries); i++) {
+    const size_t from = dict->compact_read++;
+    Entry *const entry = GetEntry(dict, from);
+    if (entry->key == NULL) {
       continue;
     }
 
-    if (entry->invalidated) {
-      free(entry);
+    const size_t to = dict->compact_write++;
+    if (to == from) {
       continue;
     }
 
-    const size_t index = ComputeIndex(dict, entry->key);
-    assert(new_buffer[index] == NULL);
-    new_buffer[index] = entry;
+    *GetEntry(dict, to) = *entry;
+    entry->key = NULL;
+
+    // Entries not yet migrated by a resize in progress are in the old index
+    if (!IndexMove(dict->index, dict->capacity, entry->hash, from, to)) {
+      const bool moved = (dict->old_index != NULL) &&
+                         IndexMove(dict->old_index, dict->old_capacity,
+                                   entry->hash, from, to);
+      assert(moved);
+      (void)moved;
+    }
   }
 
-  dict->in_use = dict->length;
-  free(old_buffer);
+  if (dict->compact_read >= dict->num_entries) {
+    dict->num_entries = dict->compact_write;
+    dict->compacting = false;
+  }
 }
 
-Dict *DictCreate(void) {
-  Dict *dict = (Dict *)malloc(sizeof(Dict));
-  if (dict == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
+/**
+ * @brief Start compacting the entry array if holes make up a third of it.
+ * @param dict The dictionary.
+ */
+static void MaybeCompact(Dict *const dict) {
+  assert(dict != NULL);
+
+  const size_t n_removed = dict->num_entries - dict->length;
+  if (dict->compacting || (n_removed == 0) ||
+      ((n_removed * 2) < dict->length)) {
+    return;
   }
 
-  dict->length = dict->in_use = 0;
-  dict->capacity = DEFAULT_DICT_CAPACITY;
-  dict->buffer = (Entry **)calloc(dict->capacity, sizeof(Entry *));
+  dict->compacting = true;
+  dict->compact_read = dict->compact_write = 0;
+}
+
+/**
+ * @brief Append a segment to the entry array.
+ * @param dict The dictionary.
+ * @param size Number of entries in the segment.
+ */
+static void AddSegment(Dict *const dict, const size_t size) {
+  assert(dict != NULL);
+  assert(size > 0);
 
-  if (dict->buffer == NULL) {
-    LOG_CRITICAL("calloc(3): Failed to allocate memory: %s", strerror(errno));
+  dict->segments = (Entry **)xrealloc(
+      dict->segments, (dict->num_segments + 1) * sizeof(Entry *));
+  dict->segments[dict->num_segments++] =
+      (Entry *)xmalloc(size * sizeof(Entry));
+  dict->entries_capacity += size;
+}
+
+/**
+ * @brief Replace the segments with a single one.
+ * @param dict The dictionary.
+ * @param segment The segment, ownership is transferred to the dictionary.
+ * @param capacity Number of entries in the segment.
+ * @note Entries in the replaced segments are dropped, so the caller must have
+ *       moved them first.
+ */
+static void ResetSegments(Dict *const dict, Entry *const segment,
+                          const size_t capacity) {
+  assert(dict != NULL);
+  assert(segment != NULL);
+  assert(capacity > 0);
+
+  for (size_t i = 0; i < dict->num_segments; i++) {
+    xfree(dict->segments[i]);
   }
+  dict->segments = (Entry **)xrealloc(dict->segments, sizeof(Entry *));
+  dict->segments[0] = segment;
+  dict->num_segments = 1;
+  dict->entries_capacity = dict->first_capacity = capacity;
+
+  dict->shift = HighestBit(capacity);
+  if (((size_t)1 << dict->shift) < capacity) {
+    dict->shift += 1;
+  }
+}
+
+/**
+ * @brief Make room for one more entry in the entry array.
+ * @param dict The dictionary.
+ * @note Existing entries are never moved, growing the array only allocates
+ *       the next segment.
+ */
+static void EnsureEntries(Dict *const dict) {
+  assert(dict != NULL);
+
+  if (dict->num_entries < dict->entries_capacity) {
+    return;
+  }
+
+  if (dict->num_entries >= MAX_ENTRIES) {
+    LOG_CRITICAL("Dictionary exceeded maximum number of entries (%zu)",
+                 MAX_ENTRIES);
+  }
+
+  size_t size = ((size_t)1 << dict->shift) << (dict->num_segments - 1);
+  if (size > MAX_ENTRIES - dict->entries_capacity) {
+    size = MAX_ENTRIES - dict->entries_capacity;
+  }
+  AddSegment(dict, size);
+}
+
+/**
+ * @brief Rebuild the index from the entry array in one go.
+ * @param dict The dictionary.
+ * @param new_capacity Capacity of the new index.
+ * @note Any resize in progress is abandoned.
+ */
+static void Rebuild(Dict *const dict, const size_t new_capacity) {
+  assert(dict != NULL);
+  assert(new_capacity > dict->length);
+
+  xfree(dict->old_index);
+  dict->old_index = NULL;
+  dict->old_capacity = dict->rehash_index = 0;
+
+  xfree(dict->index);
+  dict->index = CreateIndex(new_capacity);
+  dict->capacity = new_capacity;
+  dict->in_use = 0;
+  for (size_t i = 0; i < dict->num_entries; i++) {
+    const Entry *const entry = GetEntry(dict, i);
+    if (entry->key != NULL) {
+      IndexInsert(dict->index, new_capacity, entry->hash, i);
+      dict->in_use += 1;
+    }
+  }
+}
+
+/**
+ * @brief Make room for one more slot in the index.
+ * @param dict The dictionary.
+ */
+static void EnsureCapacity(Dict *const dict) {
+  assert(dict != NULL);
+
+  if ((float)(dict->in_use + 1) <=
+      ((float)dict->capacity * DEFAULT_DICT_MAX_LOAD_FACTOR)) {
+    return;
+  }
+
+  /* The new index filled up before the previous resize completed. This only
+   * happens with a tiny rehash step, finish it before starting another. */
+  RehashStep(dict, SIZE_MAX);
+
+  // Removed entries leave no slots behind, so the index is full of live ones
+  assert(dict->in_use == dict->length);
+  const size_t new_capacity = dict->capacity * 2;
+
+  // Start an incremental resize, slots are migrated by later operations
+  dict->old_index = dict->index;
+  dict->old_capacity = dict->capacity;
+  dict->rehash_index = 0;
+  dict->index = CreateIndex(new_capacity);
+  dict->capacity = new_capacity;
+  dict->in_use = 0;
+}
+
+/**
+ * @brief Create a dictionary with a given index and entry array size.
+ * @param capacity Number of slots in the index.
+ * @param entries_capacity Number of entries to allocate room for.
+ * @return The dictionary.
+ */
+static Dict *CreateDict(const size_t capacity, const size_t entries_capacity) {
+  assert(entries_capacity > 0);
+
+  Dict *dict = (Dict *)xmalloc(sizeof(Dict));
+
+  dict->length = dict->num_entries = 0;
+  dict->segments = NULL;
+  dict->num_segments = 0;
+  ResetSegments(dict, (Entry *)xmalloc(entries_capacity * sizeof(Entry)),
+                entries_capacity);
+
+  dict->in_use = 0;
+  dict->capacity = capacity;
+  dict->index = CreateIndex(capacity);
+
+  dict->old_capacity = dict->rehash_index = 0;
+  dict->old_index = NULL;
+
+  dict->compacting = false;
+  dict->compact_read = dict->compact_write = 0;
 
   return dict;
 }
 
+Dict *DictCreate(void) {
+  const size_t entries_capacity =
+      (size_t)((float)DEFAULT_DICT_CAPACITY * DEFAULT_DICT_MAX_LOAD_FACTOR);
+  return CreateDict(DEFAULT_DICT_CAPACITY,
+                    (entries_capacity > 0) ? entries_capacity : 1);
+}
+
+Dict *DictCreateWithCapacity(const size_t capacity) {
+  return CreateDict(CapacityFor(capacity), (capacity > 0) ? capacity : 1);
+}
+
 void DictDestroy(void *const ptr) {
   Dict *const dict = (Dict *)ptr;
   if (dict == NULL) {
     return;
   }
 
-  assert(dict->buffer != NULL);
-
-  for (size_t i = 0; i < dict->capacity; i++) {
-    Entry *entry = dict->buffer[i];
-    if (entry == NULL) {
+  assert(dict->segments != NULL);
+  for (size_t i = 0; i < dict->num_entries; i++) {
+    Entry *const entry = GetEntry(dict, i);
+    if (entry->key == NULL) {
       continue;
     }
 
-    if (!entry->invalidated) {
-      free(entry->key);
-      if (entry->destroy != NULL) {
-        entry->destroy(entry->value);
-      }
+    xfree(entry->key);
+    if (entry->destroy != NULL) {
+      entry->destroy(entry->value);
     }
-
-    free(entry);
   }
 
-  free(dict->buffer);
-  free(dict);
+  for (size_t i = 0; i < dict->num_segments; i++) {
+    xfree(dict->segments[i]);
+  }
+  xfree(dict->segments);
+  xfree(dict->index);
+  xfree(dict->old_index);
+  xfree(dict);
 }
 
 size_t DictLength(const Dict *const dict) {
@@ -162,17 +610,32 @@ size_t DictLength(const Dict *const dict) {
   return dict->length;
 }
 
+uint64_t DictHashKey(const char *const key) {
+  assert(key != NULL);
+  return HashKey(key, strlen(key));
+}
+
 void DictSet(Dict *const dict, const char *const key, void *const value,
              void (*destroy)(void *)) {
+  DictSetHashed(dict, key, DictHashKey(key), value, destroy);
+}
+
+void DictSetHashed(Dict *const dict, const char *const key,
+                   const uint64_t key_hash, void *const value,
+                   void (*destroy)(void *)) {
   assert(dict != NULL);
-  assert(dict->buffer != NULL);
+  assert(dict->index != NULL);
   assert(key != NULL);
+  assert(key_hash == DictHashKey(key));
 
-  EnsureCapacity(dict);
+  RehashStep(dict, DEFAULT_DICT_REHASH_STEP);
+  CompactStep(dict, DEFAULT_DICT_REHASH_STEP);
+
+  const size_t length = strlen(key);
+  const size_t hash = (size_t)key_hash;
 
-  const size_t index = ComputeIndex(dict, key);
-  if (dict->buffer[index] != NULL) {
-    Entry *const item = dict->buffer[index];
+  Entry *const item = FindEntry(dict, key, length, hash);
+  if (item != NULL) {
     assert(item->key != NULL);
     assert(StringEqual(key, item->key));
 
@@ -181,82 +644,216 @@ void DictSet(Dict *const dict, const char *const key, void *const value,
     }
     item->value = value;
     item->destroy = destroy;
+    return;
   }
 
-  Entry *entry = (Entry *)malloc(sizeof(Entry));
-  if (entry == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+  EnsureEntries(dict);
+  EnsureCapacity(dict);
 
-  entry->key = StringDuplicate(key);
+  const size_t position = dict->num_entries++;
+  Entry *const entry = GetEntry(dict, position);
+  entry->hash = hash;
+  entry->length = length;
+  entry->key = StringDuplicateN(key, length);
   entry->value = value;
   entry->destroy = destroy;
-  entry->invalidated = false;
 
-  dict->buffer[index] = entry;
+  // New entries always go into the new index
+  IndexInsert(dict->index, dict->capacity, entry->hash, position);
   dict->in_use += 1;
   dict->length += 1;
 }
 
 bool DictHasKey(const Dict *const dict, const char *const key) {
   assert(dict != NULL);
-  assert(dict->buffer != NULL);
+  assert(dict->index != NULL);
   assert(key != NULL);
 
-  const size_t index = ComputeIndex(dict, key);
-  return dict->buffer[index] != NULL;
+  const size_t length = strlen(key);
+  return FindEntry(dict, key, length, (size_t)HashKey(key, length)) != NULL;
 }
 
 List *DictGetKeys(const Dict *const dict) {
   assert(dict != NULL);
-  assert(dict->buffer != NULL);
 
-  List *const keys = ListCreate();
-  for (size_t i = 0; i < dict->capacity; i++) {
-    Entry *const entry = dict->buffer[i];
-    if (entry == NULL || entry->invalidated) {
+  List *const keys = ListCreateWithCapacity(dict->length);
+  for (size_t i = 0; i < dict->num_entries; i++) {
+    const Entry *const entry = GetEntry(dict, i);
+    if (entry->key == NULL) {
       continue;
     }
 
-    assert(entry->key != NULL);
-    char *const key = StringDuplicate(entry->key);
-    ListAppend(keys, key, free);
+    char *const key = StringDuplicateN(entry->key, entry->length);
+    ListAppend(keys, key, xfree);
   }
 
   return keys;
 }
 
+void DictForEach(const Dict *const dict,
+                 void (*callback)(const char *key, const void *value,
+                                  void *data),
+                 void *const data) {
+  assert(dict != NULL);
+  assert(callback != NULL);
+
+  for (size_t i = 0; i < dict->num_entries; i++) {
+    const Entry *const entry = GetEntry(dict, i);
+    if (entry->key != NULL) {
+      callback(entry->key, entry->value, data);
+    }
+  }
+}
+
+bool DictIterate(const Dict *const dict, size_t *const cursor,
+                 const char **const key, const void **const value) {
+  assert(dict != NULL);
+  assert(cursor != NULL);
+
+  while (*cursor < dict->num_entries) {
+    const Entry *const entry = GetEntry(dict, (*cursor)++);
+    if (entry->key == NULL) {
+      continue;
+    }
+
+    if (key != NULL) {
+      *key = entry->key;
+    }
+    if (value != NULL) {
+      *value = entry->value;
+    }
+    return true;
+  }
+
+  return false;
+}
+
 const void *DictGet(const Dict *const dict, const char *const key) {
   assert(dict != NULL);
-  assert(dict->buffer != NULL);
+  assert(dict->index != NULL);
   assert(key != NULL);
 
-  const size_t index = ComputeIndex(dict, key);
-  Entry *entry = dict->buffer[index];
+  const size_t length = strlen(key);
+  Entry *entry = FindEntry(dict, key, length, (size_t)HashKey(key, length));
   assert(entry != NULL);
   return entry->value;
 }
 
+bool DictGetHashed(const Dict *const dict, const char *const key,
+                   const uint64_t key_hash, const void **const value) {
+  assert(dict != NULL);
+  assert(dict->index != NULL);
+  assert(key != NULL);
+  assert(key_hash == DictHashKey(key));
+
+  const Entry *const entry =
+      FindEntry(dict, key, strlen(key), (size_t)key_hash);
+  if (entry == NULL) {
+    return false;
+  }
+
+  if (value != NULL) {
+    *value = entry->value;
+  }
+  return true;
+}
+
 void *DictRemove(Dict *const dict, const char *const key) {
+  void *value;
+  const bool found = DictRemoveHashed(dict, key, DictHashKey(key), &value);
+  assert(found);
+  (void)found;
+  return value;
+}
+
+bool DictRemoveHashed(Dict *const dict, const char *const key,
+                      const uint64_t key_hash, void **const value) {
   assert(dict != NULL);
-  assert(dict->buffer != NULL);
+  assert(dict->index != NULL);
   assert(key != NULL);
+  assert(key_hash == DictHashKey(key));
 
-  const size_t index = ComputeIndex(dict, key);
-  Entry *const entry = dict->buffer[index];
-  assert(entry != NULL);
+  RehashStep(dict, DEFAULT_DICT_REHASH_STEP);
+  CompactStep(dict, DEFAULT_DICT_REHASH_STEP);
+
+  const size_t length = strlen(key);
+  const size_t hash = (size_t)key_hash;
+
+  uint32_t position;
+  size_t slot = FindSlot(dict, dict->index, dict->capacity, hash, key, length);
+  if (dict->index[slot] != INDEX_EMPTY) {
+    position = dict->index[slot];
+    IndexRemove(dict, dict->index, dict->capacity, slot);
+    dict->in_use -= 1;
+  } else {
+    if (dict->old_index == NULL) {
+      return false;
+    }
+
+    /* The old index is drained shortly, so marking the slot as moved is
+     * cheaper than shifting it. */
+    slot = FindSlot(dict, dict->old_index, dict->old_capacity, hash, key,
+                    length);
+    position = dict->old_index[slot];
+    if (position == INDEX_EMPTY) {
+      return false;
+    }
+    dict->old_index[slot] = INDEX_MOVED;
+  }
+
+  Entry *const entry = GetEntry(dict, position - 1);
   assert(entry->key != NULL);
   assert(StringEqual(entry->key, key));
-  assert(!entry->invalidated);
 
-  free(entry->key);
+  xfree(entry->key);
   entry->key = NULL;
+  if (value != NULL) {
+    *value = entry->value;
+  }
 
-  void *value = entry->value;
-  entry->invalidated = true;
+  // A hole at the end of the entry array is reclaimed right away
+  if (position == dict->num_entries) {
+    dict->num_entries -= 1;
+    CompactStep(dict, 0);
+  }
 
   assert(dict->length > 0);
   dict->length -= 1;
+  MaybeCompact(dict);
 
-  return value;
-}
\ No newline at end of file
+  return true;
+}
+
+void DictShrinkToFit(Dict *const dict) {
+  assert(dict != NULL);
+  assert(dict->index != NULL);
+
+  /* Unlike the incremental compaction and resize, this is done in one go,
+   * since the caller asked for it. */
+  const size_t entries_capacity = (dict->length > 0) ? dict->length : 1;
+  const bool compact = (dict->num_entries > dict->length) ||
+                       (dict->entries_capacity > entries_capacity);
+  if (compact) {
+    Entry *const entries =
+        (Entry *)xmalloc(entries_capacity * sizeof(Entry));
+    size_t length = 0;
+    for (size_t i = 0; i < dict->num_entries; i++) {
+      const Entry *const entry = GetEntry(dict, i);
+      if (entry->key != NULL) {
+        entries[length++] = *entry;
+      }
+    }
+    assert(length == dict->length);
+
+    ResetSegments(dict, entries, entries_capacity);
+    dict->num_entries = length;
+    dict->compacting = false;
+  }
+
+  const size_t new_capacity = CapacityFor(dict->length);
+  if (compact || (new_capacity < dict->capacity) ||
+      (dict->old_index != NULL)) {
+    Rebuild(dict, (new_capacity < dict->capacity) ? new_capacity
+                                                  : dict->capacity);
+  }
+}
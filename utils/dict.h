@@ -2,6 +2,7 @@
 #define _AETHER_DICT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "list.h"
@@ -15,6 +16,16 @@ typedef struct Dict Dict;
  */
 Dict *DictCreate(void);
 
+/**
+ * @brief Create a dictionary with room for a given number of entries.
+ * @param capacity Number of entries to allocate room for.
+ * @return The dictionary.
+ * @note Caller takes ownership of returned value. Use this instead of
+ *       DictCreate() when the final length is known, to avoid both regrowing
+ *       and over-allocating.
+ */
+Dict *DictCreateWithCapacity(size_t capacity);
+
 /**
  * @brief Destroy the dictionary.
  * @param dict Pointer to dictionary.
@@ -45,16 +56,44 @@ void DictSet(Dict *dict, const char *key, void *value, void (*destroy)(void *));
  * @param key Key of entry.
  * @return True if entry with key exists.
  */
-bool LCH_DictHasKey(const Dict *dict, const char *key);
+bool DictHasKey(const Dict *dict, const char *key);
 
 /**
  * @brief Get list of keys in dictionary.
  * @param dict The dictionary.
- * @return List of existing keys.
- * @note Caller takes ownership of returned value.
+ * @return List of existing keys in insertion order.
+ * @note Caller takes ownership of returned value. Use DictForEach() or
+ *       DictIterate() to visit the entries without copying the keys.
  */
 List *DictGetKeys(const Dict *dict);
 
+/**
+ * @brief Call a function for each entry in dictionary.
+ * @param dict The dictionary.
+ * @param callback Function called with the key and value of each entry, in
+ *                 insertion order.
+ * @param data User data passed on to callback.
+ * @note Keys and values are borrowed and the callback must not modify the
+ *       dictionary.
+ */
+void DictForEach(const Dict *dict,
+                 void (*callback)(const char *key, const void *value,
+                                  void *data),
+                 void *data);
+
+/**
+ * @brief Advance an iterator over entries in dictionary.
+ * @param dict The dictionary.
+ * @param cursor Iterator state, must be initialized to zero.
+ * @param key Output for key of the next entry or NULL.
+ * @param value Output for value of the next entry or NULL.
+ * @return True if an entry was produced, false if there are no more entries.
+ * @note Entries are produced in insertion order. Keys and values are borrowed
+ *       and the dictionary must not be modified while iterating.
+ */
+bool DictIterate(const Dict *dict, size_t *cursor, const char **key,
+                 const void **value);
+
 /**
  * @brief Get value of entry with key in dictionary.
  * @param dict The dictionary.
@@ -72,4 +111,60 @@ const void *DictGet(const Dict *dict, const char *key);
  */
 void *DictRemove(Dict *dict, const char *key);
 
+/**
+ * @brief Release unused capacity of the dictionary.
+ * @param dict The dictionary.
+ * @note Space left by removed entries is reclaimed, and the entries are
+ *       rehashed into the smallest index that can hold them within the max
+ *       load factor. Unlike other operations, which grow and compact the
+ *       dictionary a bounded step at a time, this takes time linear in its
+ *       length.
+ */
+void DictShrinkToFit(Dict *dict);
+
+/**
+ * @brief Hash a key the way dictionaries do.
+ * @param key The key.
+ * @return The hash.
+ * @note Containers built on top of dictionaries can use this to pick a shard
+ *       by the high bits, and pass the hash on to the *Hashed() functions
+ *       below so that each key is only hashed once. Dictionaries index by the
+ *       low bits.
+ */
+uint64_t DictHashKey(const char *key);
+
+/**
+ * @brief Create/update entry in dictionary, given the hash of its key.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param key_hash Hash of the key, as returned by DictHashKey().
+ * @param value Value of entry.
+ * @param destroy Function to destroy the value of the entry or NULL.
+ */
+void DictSetHashed(Dict *dict, const char *key, uint64_t key_hash, void *value,
+                   void (*destroy)(void *));
+
+/**
+ * @brief Look up entry in dictionary, given the hash of its key.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param key_hash Hash of the key, as returned by DictHashKey().
+ * @param value Output for value of entry or NULL.
+ * @return True if entry with key exists.
+ */
+bool DictGetHashed(const Dict *dict, const char *key, uint64_t key_hash,
+                   const void **value);
+
+/**
+ * @brief Remove entry from dictionary, given the hash of its key.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param key_hash Hash of the key, as returned by DictHashKey().
+ * @param value Output for value of entry or NULL.
+ * @return True if entry with key existed.
+ * @note Caller takes ownership of the value.
+ */
+bool DictRemoveHashed(Dict *dict, const char *key, uint64_t key_hash,
+                      void **value);
+
 #endif // _AETHER_DICT_H
@@ -0,0 +1,139 @@
+#include "hash.h"
+#include "config.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The seed is drawn exactly once, even if several threads hash their first
+ * key at the same time. Otherwise they could end up with different seeds and
+ * disagree on where keys live in a shared table. */
+static pthread_once_t SEEDED = PTHREAD_ONCE_INIT;
+static uint64_t SEED[2];
+
+/**
+ * @brief Draw a random seed for HashBytes().
+ * @note If the system cannot provide entropy, we fall back to mixing the
+ *       clock, the process ID and the address of a static variable.
+ */
+static void SeedRandom(void) {
+#ifdef HAVE_GETENTROPY
+  if (getentropy(SEED, sizeof(SEED)) == 0) {
+    return;
+  }
+#endif // HAVE_GETENTROPY
+
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  const uint64_t k0 = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec;
+  const uint64_t k1 = ((uint64_t)getpid() << 32) ^ (uint64_t)(uintptr_t)&SEED;
+  SEED[0] = k0 * 0x9e3779b97f4a7c15ULL;
+  SEED[1] = k1 * 0xbf58476d1ce4e5b9ULL;
+}
+
+void HashSetSeed(const uint64_t k0, const uint64_t k1) {
+  pthread_once(&SEEDED, SeedRandom);
+  SEED[0] = k0;
+  SEED[1] = k1;
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND                                                               \
+  do {                                                                         \
+    v0 += v1;                                                                  \
+    v1 = ROTL(v1, 13);                                                         \
+    v1 ^= v0;                                                                  \
+    v0 = ROTL(v0, 32);                                                         \
+    v2 += v3;                                                                  \
+    v3 = ROTL(v3, 16);                                                         \
+    v3 ^= v2;                                                                  \
+    v0 += v3;                                                                  \
+    v3 = ROTL(v3, 21);                                                         \
+    v3 ^= v0;                                                                  \
+    v2 += v1;                                                                  \
+    v1 = ROTL(v1, 17);                                                         \
+    v1 ^= v2;                                                                  \
+    v2 = ROTL(v2, 32);                                                         \
+  } while (0)
+
+uint64_t HashBytes(const void *const data, const size_t length) {
+  pthread_once(&SEEDED, SeedRandom);
+  return HashBytesKeyed(data, length, SEED[0], SEED[1]);
+}
+
+uint64_t HashBytesKeyed(const void *const data, const size_t length,
+                        const uint64_t k0, const uint64_t k1) {
+  assert(data != NULL || length == 0);
+
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+  /* Words are loaded in little-endian byte order, as specified by SipHash,
+   * so that keyed hashes stored on disk are the same on every host.
+   * Compilers turn this into a single load on little-endian hosts. */
+  const unsigned char *in = (const unsigned char *)data;
+  const unsigned char *const end = in + (length - (length % 8));
+  for (; in != end; in += 8) {
+    const uint64_t m =
+        (uint64_t)in[0] | ((uint64_t)in[1] << 8) | ((uint64_t)in[2] << 16) |
+        ((uint64_t)in[3] << 24) | ((uint64_t)in[4] << 32) |
+        ((uint64_t)in[5] << 40) | ((uint64_t)in[6] << 48) |
+        ((uint64_t)in[7] << 56);
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  uint64_t b = (uint64_t)length << 56;
+  switch (length % 8) {
+  case 7:
+    b |= (uint64_t)in[6] << 48;
+    /* fall through */
+  case 6:
+    b |= (uint64_t)in[5] << 40;
+    /* fall through */
+  case 5:
+    b |= (uint64_t)in[4] << 32;
+    /* fall through */
+  case 4:
+    b |= (uint64_t)in[3] << 24;
+    /* fall through */
+  case 3:
+    b |= (uint64_t)in[2] << 16;
+    /* fall through */
+  case 2:
+    b |= (uint64_t)in[1] << 8;
+    /* fall through */
+  case 1:
+    b |= (uint64_t)in[0];
+    break;
+  default:
+    break;
+  }
+
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+uint64_t HashUInt64(uint64_t value) {
+  pthread_once(&SEEDED, SeedRandom);
+
+  // The splitmix64 finalizer, applied on top of the seed
+  value ^= SEED[0];
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return value ^ SEED[1];
+}
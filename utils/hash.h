@@ -0,0 +1,52 @@
+#ifndef _AETHER_HASH_H
+#define _AETHER_HASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Hash a sequence of bytes.
+ * @param data The bytes.
+ * @param length Number of bytes.
+ * @return The hash.
+ * @note This is SipHash-1-3 keyed with a random per-process seed, so hashes
+ *       cannot be predicted by an attacker and differ between runs. They must
+ *       never be stored or shown to the user.
+ */
+uint64_t HashBytes(const void *data, size_t length);
+
+/**
+ * @brief Hash a sequence of bytes with an explicit key.
+ * @param data The bytes.
+ * @param length Number of bytes.
+ * @param k0 First half of the key.
+ * @param k1 Second half of the key.
+ * @return The hash.
+ * @note Unlike HashBytes(), the result is the same in every process using the
+ *       same key, so it can be stored on disk (e.g., as a checksum). Do not
+ *       use it for hash tables fed with untrusted keys.
+ */
+uint64_t HashBytesKeyed(const void *data, size_t length, uint64_t k0,
+                        uint64_t k1);
+
+/**
+ * @brief Hash an integer.
+ * @param value The integer.
+ * @return The hash.
+ * @note This is a much cheaper keyed mix than HashBytes(), using the same
+ *       seed. Every bit of the value affects every bit of the hash, but it
+ *       makes no cryptographic claims.
+ */
+uint64_t HashUInt64(uint64_t value);
+
+/**
+ * @brief Set the seed used by HashBytes().
+ * @param k0 First half of the seed.
+ * @param k1 Second half of the seed.
+ * @note By default a random seed is drawn on first use. Only use this for
+ *       reproducible tests and benchmarks, and call it before any hash is
+ *       computed.
+ */
+void HashSetSeed(uint64_t k0, uint64_t k1);
+
+#endif // _AETHER_HASH_H
@@ -0,0 +1,283 @@
+#include "int_dict.h"
+#include "config.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "hash.h"
+#include "logger.h"
+
+/* Index slots hold the position of an entry plus one, so that zero can mark an
+ * empty slot. */
+#define INDEX_EMPTY 0
+#define MAX_ENTRIES ((size_t)UINT32_MAX - 1)
+
+typedef struct Entry {
+  uint64_t key;
+  void *value;
+  void (*destroy)(void *);
+} Entry;
+
+/* Same layout as Dict: entries are stored densely, and an open addressing
+ * index maps hashes to positions in the entry array. Since integer keys are
+ * cheap to hash, the index is rebuilt in one go when it fills up, and removed
+ * entries are filled by the last entry so that the array never has holes. */
+struct IntDict {
+  size_t length;
+  size_t entries_capacity;
+  Entry *entries;
+
+  size_t capacity;
+  uint32_t *index;
+};
+
+/**
+ * @brief Find the slot of a key in the index.
+ * @param dict The dictionary.
+ * @param key The key.
+ * @return Slot referring to the entry with the key, or the empty slot
+ *         terminating the probe sequence.
+ */
+static size_t FindSlot(const IntDict *const dict, const uint64_t key) {
+  assert(dict != NULL);
+  assert(dict->index != NULL);
+
+  const size_t mask = dict->capacity - 1;
+  size_t slot = (size_t)HashUInt64(key) & mask;
+  while (true) {
+    const uint32_t position = dict->index[slot];
+    if (position == INDEX_EMPTY || dict->entries[position - 1].key == key) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  return slot;
+}
+
+/**
+ * @brief Allocate an empty index and add all entries to it.
+ * @param dict The dictionary.
+ * @param capacity The number of slots in the index.
+ */
+static void Reindex(IntDict *const dict, const size_t capacity) {
+  assert(dict != NULL);
+  assert(capacity > dict->length);
+  assert((capacity & (capacity - 1)) == 0);
+
+  uint32_t *const index = (uint32_t *)xcalloc(capacity, sizeof(uint32_t));
+
+  const size_t mask = capacity - 1;
+  for (size_t i = 0; i < dict->length; i++) {
+    size_t slot = (size_t)HashUInt64(dict->entries[i].key) & mask;
+    while (index[slot] != INDEX_EMPTY) {
+      slot = (slot + 1) & mask;
+    }
+    index[slot] = (uint32_t)(i + 1);
+  }
+
+  xfree(dict->index);
+  dict->index = index;
+  dict->capacity = capacity;
+}
+
+/**
+ * @brief Compute the index size needed to hold a number of entries.
+ * @param length The number of entries.
+ * @return The capacity.
+ */
+static size_t CapacityFor(const size_t length) {
+  const size_t needed =
+      (size_t)((float)length / DEFAULT_DICT_MAX_LOAD_FACTOR) + 1;
+  size_t capacity = 1;
+  while (capacity < needed) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+/**
+ * @brief Make room for one more entry.
+ * @param dict The dictionary.
+ */
+static void EnsureCapacity(IntDict *const dict) {
+  assert(dict != NULL);
+
+  if (dict->length >= dict->entries_capacity) {
+    if (dict->entries_capacity >= MAX_ENTRIES) {
+      LOG_CRITICAL("Dictionary exceeded maximum number of entries (%zu)",
+                   MAX_ENTRIES);
+    }
+
+    size_t new_capacity = dict->entries_capacity * 2;
+    if (new_capacity > MAX_ENTRIES) {
+      new_capacity = MAX_ENTRIES;
+    }
+
+    Entry *const entries =
+        (Entry *)xrealloc(dict->entries, new_capacity * sizeof(Entry));
+    dict->entries = entries;
+    dict->entries_capacity = new_capacity;
+  }
+
+  if ((float)(dict->length + 1) >
+      ((float)dict->capacity * DEFAULT_DICT_MAX_LOAD_FACTOR)) {
+    Reindex(dict, dict->capacity * 2);
+  }
+}
+
+/**
+ * @brief Create a dictionary with a given index and entry array size.
+ * @param capacity Number of slots in the index.
+ * @param entries_capacity Number of entries to allocate room for.
+ * @return The dictionary.
+ */
+static IntDict *CreateIntDict(const size_t capacity,
+                              const size_t entries_capacity) {
+  assert(entries_capacity > 0);
+
+  IntDict *dict = (IntDict *)xmalloc(sizeof(IntDict));
+
+  dict->length = 0;
+  dict->entries_capacity = entries_capacity;
+  dict->entries = (Entry *)xmalloc(entries_capacity * sizeof(Entry));
+
+  dict->index = NULL;
+  Reindex(dict, capacity);
+
+  return dict;
+}
+
+IntDict *IntDictCreate(void) {
+  const size_t entries_capacity =
+      (size_t)((float)DEFAULT_DICT_CAPACITY * DEFAULT_DICT_MAX_LOAD_FACTOR);
+  return CreateIntDict(DEFAULT_DICT_CAPACITY,
+                       (entries_capacity > 0) ? entries_capacity : 1);
+}
+
+IntDict *IntDictCreateWithCapacity(const size_t capacity) {
+  return CreateIntDict(CapacityFor(capacity), (capacity > 0) ? capacity : 1);
+}
+
+void IntDictDestroy(void *const ptr) {
+  IntDict *const dict = (IntDict *)ptr;
+  if (dict == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < dict->length; i++) {
+    Entry *const entry = dict->entries + i;
+    if (entry->destroy != NULL) {
+      entry->destroy(entry->value);
+    }
+  }
+
+  xfree(dict->entries);
+  xfree(dict->index);
+  xfree(dict);
+}
+
+size_t IntDictLength(const IntDict *const dict) {
+  assert(dict != NULL);
+  return dict->length;
+}
+
+void IntDictSet(IntDict *const dict, const uint64_t key, void *const value,
+                void (*destroy)(void *)) {
+  assert(dict != NULL);
+
+  size_t slot = FindSlot(dict, key);
+  if (dict->index[slot] != INDEX_EMPTY) {
+    Entry *const item = dict->entries + (dict->index[slot] - 1);
+    if (item->destroy != NULL) {
+      item->destroy(item->value);
+    }
+    item->value = value;
+    item->destroy = destroy;
+    return;
+  }
+
+  const size_t capacity = dict->capacity;
+  EnsureCapacity(dict);
+  if (dict->capacity != capacity) {
+    slot = FindSlot(dict, key);
+  }
+
+  Entry *const entry = dict->entries + dict->length;
+  entry->key = key;
+  entry->value = value;
+  entry->destroy = destroy;
+
+  dict->index[slot] = (uint32_t)(dict->length + 1);
+  dict->length += 1;
+}
+
+bool IntDictHasKey(const IntDict *const dict, const uint64_t key) {
+  assert(dict != NULL);
+  return dict->index[FindSlot(dict, key)] != INDEX_EMPTY;
+}
+
+const void *IntDictGet(const IntDict *const dict, const uint64_t key) {
+  assert(dict != NULL);
+
+  const uint32_t position = dict->index[FindSlot(dict, key)];
+  assert(position != INDEX_EMPTY);
+  return dict->entries[position - 1].value;
+}
+
+void *IntDictRemove(IntDict *const dict, const uint64_t key) {
+  assert(dict != NULL);
+
+  size_t slot = FindSlot(dict, key);
+  const uint32_t position = dict->index[slot];
+  assert(position != INDEX_EMPTY);
+  void *const value = dict->entries[position - 1].value;
+
+  // Backward-shift deletion, see IndexRemove() in dict.c
+  const size_t mask = dict->capacity - 1;
+  size_t next = slot;
+  while (true) {
+    next = (next + 1) & mask;
+    const uint32_t other = dict->index[next];
+    if (other == INDEX_EMPTY) {
+      break;
+    }
+
+    const size_t home = (size_t)HashUInt64(dict->entries[other - 1].key) & mask;
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      dict->index[slot] = other;
+      slot = next;
+    }
+  }
+  dict->index[slot] = INDEX_EMPTY;
+
+  // Fill the hole in the entry array with the last entry
+  dict->length -= 1;
+  if (position - 1 != dict->length) {
+    const Entry *const last = dict->entries + dict->length;
+    dict->index[FindSlot(dict, last->key)] = position;
+    dict->entries[position - 1] = *last;
+  }
+
+  return value;
+}
+
+bool IntDictIterate(const IntDict *const dict, size_t *const cursor,
+                    uint64_t *const key, const void **const value) {
+  assert(dict != NULL);
+  assert(cursor != NULL);
+
+  if (*cursor >= dict->length) {
+    return false;
+  }
+
+  const Entry *const entry = dict->entries + (*cursor)++;
+  if (key != NULL) {
+    *key = entry->key;
+  }
+  if (value != NULL) {
+    *value = entry->value;
+  }
+  return true;
+}
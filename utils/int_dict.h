@@ -0,0 +1,90 @@
+#ifndef _AETHER_INT_DICT_H
+#define _AETHER_INT_DICT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct IntDict IntDict;
+
+/**
+ * @brief Create an integer keyed dictionary.
+ * @return The dictionary.
+ * @note Caller takes ownership of returned value.
+ */
+IntDict *IntDictCreate(void);
+
+/**
+ * @brief Create an integer keyed dictionary with room for a given number of
+ *        entries.
+ * @param capacity Number of entries to allocate room for.
+ * @return The dictionary.
+ * @note Caller takes ownership of returned value.
+ */
+IntDict *IntDictCreateWithCapacity(size_t capacity);
+
+/**
+ * @brief Destroy the dictionary.
+ * @param dict Pointer to dictionary.
+ * @note If ptr is NULL, no operation is performed. Otherwise, values are
+ *       destroyed using passed destroy function unless it's NULL.
+ */
+void IntDictDestroy(void *dict);
+
+/**
+ * @brief Get number of entries in dictionary.
+ * @param dict The dictionary.
+ * @return Number of entries in dictionary.
+ */
+size_t IntDictLength(const IntDict *dict);
+
+/**
+ * @brief Create/update entry in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param value Value of entry.
+ * @param destroy Function to destroy the value of the entry or NULL.
+ */
+void IntDictSet(IntDict *dict, uint64_t key, void *value,
+                void (*destroy)(void *));
+
+/**
+ * @brief Check for existance of entry in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return True if entry with key exists.
+ */
+bool IntDictHasKey(const IntDict *dict, uint64_t key);
+
+/**
+ * @brief Get value of entry with key in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return Value of entry.
+ */
+const void *IntDictGet(const IntDict *dict, uint64_t key);
+
+/**
+ * @brief Remove entry from dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return Value of entry.
+ * @note Caller takes ownership of returned value.
+ */
+void *IntDictRemove(IntDict *dict, uint64_t key);
+
+/**
+ * @brief Advance an iterator over entries in dictionary.
+ * @param dict The dictionary.
+ * @param cursor Iterator state, must be initialized to zero.
+ * @param key Output for key of the next entry or NULL.
+ * @param value Output for value of the next entry or NULL.
+ * @return True if an entry was produced, false if there are no more entries.
+ * @note Entries are produced in insertion order, except that removing an
+ *       entry moves the last inserted entry into its place. The dictionary
+ *       must not be modified while iterating.
+ */
+bool IntDictIterate(const IntDict *dict, size_t *cursor, uint64_t *key,
+                    const void **value);
+
+#endif // _AETHER_INT_DICT_H
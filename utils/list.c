@@ -2,10 +2,10 @@
 #include <list.h>
 
 #include <assert.h>
-#include <errno.h>
 #include <string.h>
 
-#include "logger.h"
+#include "alloc.h"
+#include "pool.h"
 
 typedef struct Element {
   void *value;
@@ -21,7 +21,7 @@ struct List {
 static void EnsureCapacity(List *const list, const size_t n_elements) {
   assert(list != NULL);
 
-  size_t new_capacity = list->capacity;
+  size_t new_capacity = (list->capacity > 0) ? list->capacity : 1;
   while (new_capacity < list->length + n_elements) {
     new_capacity *= 2;
   }
@@ -31,28 +31,20 @@ static void EnsureCapacity(List *const list, const size_t n_elements) {
   }
 
   Element **new_buffer =
-      (Element **)realloc(list->buffer, sizeof(Element *) * new_capacity);
-  if (new_buffer == NULL) {
-    LOG_CRITICAL("realloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+      (Element **)xrealloc(list->buffer, sizeof(Element *) * new_capacity);
 
   list->capacity = new_capacity;
   list->buffer = new_buffer;
 }
 
-List *ListCreate(void) {
-  List *list = (List *)malloc(sizeof(List));
-  if (list == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+List *ListCreate(void) { return ListCreateWithCapacity(DEFAULT_LIST_CAPACITY); }
 
-  list->length = 0;
-  list->capacity = DEFAULT_LIST_CAPACITY;
-  list->buffer = (Element **)calloc(list->capacity, sizeof(Element *));
+List *ListCreateWithCapacity(const size_t capacity) {
+  List *list = (List *)xmalloc(sizeof(List));
 
-  if (list->buffer == NULL) {
-    LOG_CRITICAL("calloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+  list->length = 0;
+  list->capacity = (capacity > 0) ? capacity : 1;
+  list->buffer = (Element **)xcalloc(list->capacity, sizeof(Element *));
 
   return list;
 }
@@ -70,11 +62,11 @@ void ListDestroy(void *const ptr) {
     if (element->destroy != NULL) {
       element->destroy(element->value);
     }
-    free(element);
+    PoolFree(element, sizeof(Element));
   }
 
-  free(list->buffer);
-  free(list);
+  xfree(list->buffer);
+  xfree(list);
 }
 
 size_t ListLength(const List *const list) {
@@ -89,10 +81,7 @@ void ListAppend(List *const list, void *const value, void (*destroy)(void *)) {
   EnsureCapacity(list, 1);
 
   // Create element
-  Element *element = (Element *)malloc(sizeof(Element));
-  if (element == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+  Element *element = (Element *)PoolAlloc(sizeof(Element));
   element->value = value;
   element->destroy = destroy;
 
@@ -132,7 +121,7 @@ void *ListRemove(List *const list, const size_t index) {
 
   // Remove element
   void *const value = list->buffer[index]->value;
-  free(list->buffer[index]);
+  PoolFree(list->buffer[index], sizeof(Element));
 
   // Shift elements to the left
   list->length -= 1;
@@ -149,10 +138,7 @@ void ListInsert(List *const list, const size_t index, void *const value,
 
   EnsureCapacity(list, 1);
 
-  Element *const element = (Element *)malloc(sizeof(Element));
-  if (element == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+  Element *const element = (Element *)PoolAlloc(sizeof(Element));
   element->value = value;
   element->destroy = destroy;
 
@@ -161,3 +147,19 @@ void ListInsert(List *const list, const size_t index, void *const value,
   list->buffer[index] = element;
   list->length += 1;
 }
+
+void ListShrinkToFit(List *const list) {
+  assert(list != NULL);
+  assert(list->buffer != NULL);
+
+  const size_t new_capacity = (list->length > 0) ? list->length : 1;
+  if (new_capacity == list->capacity) {
+    return;
+  }
+
+  Element **new_buffer =
+      (Element **)xrealloc(list->buffer, sizeof(Element *) * new_capacity);
+
+  list->capacity = new_capacity;
+  list->buffer = new_buffer;
+}
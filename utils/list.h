@@ -12,6 +12,16 @@ typedef struct List List;
  */
 List *ListCreate(void);
 
+/**
+ * @brief Create a list with room for a given number of elements.
+ * @param capacity Number of elements to allocate room for.
+ * @return The list.
+ * @note Caller takes ownership of returned value. Use this instead of
+ *       ListCreate() when the final length is known, to avoid both regrowing
+ *       and over-allocating.
+ */
+List *ListCreateWithCapacity(size_t capacity);
+
 /**
  * @brief Destroy the list.
  * @param ptr Pointer to the list.
@@ -73,4 +83,12 @@ void *ListRemove(List *list, size_t index);
  */
 void ListInsert(List *list, size_t index, void *value, void (*destroy)(void *));
 
+/**
+ * @brief Release unused capacity of the list.
+ * @param list The list.
+ * @note Appending to the list afterwards is still allowed, but may cause it
+ *       to regrow.
+ */
+void ListShrinkToFit(List *list);
+
 #endif // _AETHER_LIST_H
@@ -1,21 +1,647 @@
 #include "logger.h"
+#include "config.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "buffer.h"
+
+#if (DEFAULT_LOGGER_QUEUE_SIZE & (DEFAULT_LOGGER_QUEUE_SIZE - 1)) != 0
+#error "DEFAULT_LOGGER_QUEUE_SIZE must be a power of two"
+#endif
+
+/* Messages whose format string and arguments do not fit in a slot are
+ * formatted by the caller instead, and truncated to fit. */
+#define SLOT_SIZE 512
+
+// Longest time the background thread sleeps while the queue is empty
+#define MAX_IDLE_NANOSECONDS 1000000L
 
 static bool LOGGER_LOG_DEBUG = false;
 
 void LoggerSetDebug(const bool enable) { LOGGER_LOG_DEBUG = enable; }
 
+bool LoggerGetDebug(void) { return LOGGER_LOG_DEBUG; }
+
+/****************************************************************************/
+
+/**
+ * A queued message. The data holds either the formatted message, or the
+ * format string (including terminating null-byte) followed by the arguments
+ * in the order they are consumed.
+ */
+typedef struct {
+  atomic_size_t sequence;
+  enum LoggerLogLevel level;
+  const char *file;
+  int line;
+  bool formatted;
+  size_t length;
+  char data[SLOT_SIZE];
+} Slot;
+
+/**
+ * A bounded multi-producer single-consumer queue. Each slot carries a
+ * sequence number telling whether it is free for the producer claiming
+ * position pos (sequence == pos), or holds a message for the consumer
+ * (sequence == pos + 1). Producers claim positions with a compare-and-swap,
+ * hence no thread ever holds a lock.
+ */
+static struct {
+  atomic_bool running;
+  enum LoggerOverflowPolicy policy;
+  Slot *slots;
+  pthread_t thread;
+  atomic_size_t enqueue_pos;
+  size_t dequeue_pos; // Only touched by the background thread
+  atomic_size_t written_pos;
+  atomic_size_t logged;
+  atomic_size_t dropped;
+  atomic_size_t batches;
+} ASYNC = {0};
+
+#define QUEUE_MASK ((size_t)DEFAULT_LOGGER_QUEUE_SIZE - 1)
+
+/****************************************************************************/
+
+/**
+ * A single conversion specification of a format string, e.g., "%-*.3lld".
+ */
+typedef struct {
+  const char *start; // Points at the '%'
+  const char *end;   // Points just past the conversion specifier
+  bool star_width;
+  bool star_precision;
+  int precision; // Literal precision, or -1 if there is none
+  char length[3]; // Length modifier, e.g., "ll", or empty
+  char conversion;
+} Spec;
+
+/**
+ * @brief Parse the conversion specification at format.
+ * @return False if the specification is not supported by the asynchronous
+ *         logger (e.g., wide characters or positional arguments).
+ */
+static bool ParseSpec(const char *format, Spec *const spec) {
+  assert(*format == '%');
+  memset(spec, 0, sizeof(Spec));
+  spec->precision = -1;
+  spec->start = format++;
+
+  while (*format != '\0' && strchr("-+ #0", *format) != NULL) {
+    format++;
+  }
+
+  if (*format == '*') {
+    spec->star_width = true;
+    format++;
+  } else {
+    while (*format >= '0' && *format <= '9') {
+      format++;
+    }
+  }
+
+  if (*format == '$') {
+    return false;
+  }
+
+  if (*format == '.') {
+    format++;
+    if (*format == '*') {
+      spec->star_precision = true;
+      format++;
+    } else {
+      spec->precision = 0;
+      while (*format >= '0' && *format <= '9') {
+        const int digit = *format++ - '0';
+        spec->precision = (spec->precision > (INT_MAX - digit) / 10)
+                              ? INT_MAX
+                              : spec->precision * 10 + digit;
+      }
+    }
+  }
+
+  size_t n = 0;
+  while (*format != '\0' && strchr("hlLjzt", *format) != NULL) {
+    if (n == sizeof(spec->length) - 1) {
+      return false;
+    }
+    spec->length[n++] = *format++;
+  }
+
+  spec->conversion = *format;
+  if (spec->conversion == '\0') {
+    return false;
+  }
+  spec->end = format + 1;
+
+  switch (spec->conversion) {
+  case 'd':
+  case 'i':
+  case 'u':
+  case 'o':
+  case 'x':
+  case 'X':
+  case 'p':
+  case 'f':
+  case 'F':
+  case 'e':
+  case 'E':
+  case 'g':
+  case 'G':
+  case 'a':
+  case 'A':
+  case '%':
+    return true;
+  case 'c':
+  case 's':
+    return n == 0; // No wide characters
+  default:
+    return false; // E.g., %n
+  }
+}
+
+static bool IsSigned(const Spec *const spec) {
+  return spec->conversion == 'd' || spec->conversion == 'i';
+}
+
+static bool IsFloat(const Spec *const spec) {
+  return strchr("fFeEgGaA", spec->conversion) != NULL;
+}
+
+/****************************************************************************/
+
+/* Every integer argument is widened to one of these, and narrowed back to its
+ * original type when formatted. */
+typedef union {
+  long long i;
+  unsigned long long u;
+  long double f;
+  void *p;
+} Value;
+
+static bool Append(Slot *const slot, const void *const data,
+                   const size_t length) {
+  if (SLOT_SIZE - slot->length < length) {
+    return false;
+  }
+  memcpy(slot->data + slot->length, data, length);
+  slot->length += length;
+  return true;
+}
+
+static bool EncodeInt(Slot *const slot, const int value) {
+  return Append(slot, &value, sizeof(value));
+}
+
+/**
+ * @brief Copy the format string and a binary encoding of the arguments into
+ *        a slot.
+ * @return False if they do not fit, or the format string is not supported.
+ */
+static bool Encode(Slot *const slot, const char *const format, va_list ap) {
+  slot->length = 0;
+  if (!Append(slot, format, strlen(format) + 1)) {
+    return false;
+  }
+
+  for (const char *ch = strchr(format, '%'); ch != NULL;
+       ch = strchr(ch, '%')) {
+    Spec spec;
+    if (!ParseSpec(ch, &spec)) {
+      return false;
+    }
+    ch = spec.end;
+
+    if (spec.conversion == '%') {
+      continue;
+    }
+    if (spec.star_width && !EncodeInt(slot, va_arg(ap, int))) {
+      return false;
+    }
+    int precision = spec.precision;
+    if (spec.star_precision) {
+      precision = va_arg(ap, int);
+      if (!EncodeInt(slot, precision)) {
+        return false;
+      }
+    }
+
+    Value value;
+    memset(&value, 0, sizeof(value));
+    if (spec.conversion == 's') {
+      const char *str = va_arg(ap, const char *);
+      if (str == NULL) {
+        str = "(null)";
+      }
+      /* With a precision, the string need not be terminated within it, so
+       * never read past it. A negative precision is taken as if omitted. */
+      const size_t length = (precision < 0) ? strlen(str)
+                                            : strnlen(str, (size_t)precision);
+      if (!Append(slot, str, length) || !Append(slot, "", 1)) {
+        return false;
+      }
+      continue;
+    } else if (spec.conversion == 'p') {
+      value.p = va_arg(ap, void *);
+    } else if (IsFloat(&spec)) {
+      value.f = (strcmp(spec.length, "L") == 0) ? va_arg(ap, long double)
+                                                : va_arg(ap, double);
+    } else if (spec.conversion == 'c') {
+      value.i = va_arg(ap, int);
+    } else if (strcmp(spec.length, "ll") == 0) {
+      value.u = va_arg(ap, unsigned long long);
+    } else if (strcmp(spec.length, "l") == 0) {
+      value.u = va_arg(ap, unsigned long);
+    } else if (strcmp(spec.length, "z") == 0) {
+      value.u = va_arg(ap, size_t);
+    } else if (strcmp(spec.length, "j") == 0) {
+      value.u = va_arg(ap, uintmax_t);
+    } else if (strcmp(spec.length, "t") == 0) {
+      value.i = va_arg(ap, ptrdiff_t);
+    } else if (IsSigned(&spec)) {
+      value.i = va_arg(ap, int);
+    } else {
+      value.u = va_arg(ap, unsigned int);
+    }
+
+    if (!Append(slot, &value, sizeof(value))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Format a conversion specification, taking its arguments from the
+ *        binary encoding at *args.
+ */
+static void FormatSpec(Buffer *const buf, const Spec *const spec,
+                       const char **const args) {
+  /* Rewrite the specification with any '*' replaced by the encoded value, so
+   * that it only takes a single argument. */
+  char format[64];
+  size_t n = 0;
+  for (const char *ch = spec->start; ch < spec->end; ch++) {
+    if (*ch == '*') {
+      int value;
+      memcpy(&value, *args, sizeof(value));
+      *args += sizeof(value);
+      if (value < 0 && ch[-1] == '.') {
+        n -= 1; // A negative precision is taken as if omitted
+      } else {
+        n += (size_t)snprintf(format + n, sizeof(format) - n, "%d", value);
+      }
+    } else if (n < sizeof(format) - 1) {
+      format[n++] = *ch;
+    }
+    if (n >= sizeof(format)) {
+      BufferPrint(buf, "(format too long)");
+      return;
+    }
+  }
+  format[n] = '\0';
+
+  if (spec->conversion == 's') {
+    BufferPrintFormat(buf, format, *args);
+    *args += strlen(*args) + 1;
+    return;
+  }
+
+  Value value;
+  memcpy(&value, *args, sizeof(value));
+  *args += sizeof(value);
+
+  const char *const length = spec->length;
+  if (spec->conversion == 'p') {
+    BufferPrintFormat(buf, format, value.p);
+  } else if (IsFloat(spec)) {
+    if (strcmp(length, "L") == 0) {
+      BufferPrintFormat(buf, format, value.f);
+    } else {
+      BufferPrintFormat(buf, format, (double)value.f);
+    }
+  } else if (spec->conversion == 'c') {
+    BufferPrintFormat(buf, format, (int)value.i);
+  } else if (strcmp(length, "ll") == 0) {
+    BufferPrintFormat(buf, format, value.u);
+  } else if (strcmp(length, "l") == 0) {
+    BufferPrintFormat(buf, format, (unsigned long)value.u);
+  } else if (strcmp(length, "z") == 0) {
+    BufferPrintFormat(buf, format, (size_t)value.u);
+  } else if (strcmp(length, "j") == 0) {
+    BufferPrintFormat(buf, format, (uintmax_t)value.u);
+  } else if (strcmp(length, "t") == 0) {
+    BufferPrintFormat(buf, format, (ptrdiff_t)value.i);
+  } else if (IsSigned(spec)) {
+    BufferPrintFormat(buf, format, (int)value.i);
+  } else {
+    BufferPrintFormat(buf, format, (unsigned int)value.u);
+  }
+}
+
+static void Decode(Buffer *const buf, const Slot *const slot) {
+  if (slot->formatted) {
+    BufferPrintN(buf, slot->data, slot->length);
+    return;
+  }
+
+  const char *format = slot->data;
+  const char *args = format + strlen(format) + 1;
+
+  for (const char *ch = strchr(format, '%'); ch != NULL;
+       ch = strchr(format, '%')) {
+    BufferPrintN(buf, format, (size_t)(ch - format));
+
+    Spec spec;
+    const bool supported = ParseSpec(ch, &spec);
+    assert(supported); // Checked by Encode()
+    (void)supported;
+
+    if (spec.conversion == '%') {
+      BufferAppend(buf, '%');
+    } else {
+      FormatSpec(buf, &spec, &args);
+    }
+    format = spec.end;
+  }
+  BufferPrint(buf, format);
+}
+
+/****************************************************************************/
+
+static void WriteAll(const int fd, const char *data, size_t length) {
+  while (length > 0) {
+    const ssize_t ret = write(fd, data, length);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return; // Nowhere left to report the error
+    }
+    data += ret;
+    length -= (size_t)ret;
+  }
+}
+
+static void WriteRecord(Buffer *const out, Buffer *const err,
+                        const Slot *const slot) {
+  switch (slot->level) {
+  case LOGGER_MESSAGE_TYPE_DEBUG:
+    BufferPrint(out, "[DEBUG][");
+    BufferPrint(out, slot->file);
+    BufferAppend(out, ':');
+    BufferPrintInt(out, slot->line);
+    BufferPrint(out, "]: ");
+    Decode(out, slot);
+    BufferAppend(out, '\n');
+    break;
+  case LOGGER_MESSAGE_TYPE_WARNING:
+    BufferPrint(out, "[WARNING]: ");
+    Decode(out, slot);
+    BufferAppend(out, '\n');
+    break;
+  case LOGGER_MESSAGE_TYPE_ERROR:
+    BufferPrint(err, "[ERROR]: ");
+    Decode(err, slot);
+    BufferAppend(err, '\n');
+    break;
+  default:
+    assert(false); // Critical messages are never queued
+    break;
+  }
+}
+
+/**
+ * @brief Write every message currently in the queue.
+ * @return True if any message was written.
+ */
+static bool Drain(Buffer *const out, Buffer *const err) {
+  size_t count = 0;
+
+  for (;;) {
+    Slot *const slot = &ASYNC.slots[ASYNC.dequeue_pos & QUEUE_MASK];
+    const size_t sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != ASYNC.dequeue_pos + 1) {
+      break; // Empty, or the producer is still filling in the slot
+    }
+
+    WriteRecord(out, err, slot);
+
+    // Hand the slot back to producers, one lap ahead
+    atomic_store_explicit(&slot->sequence, ASYNC.dequeue_pos + QUEUE_MASK + 1,
+                          memory_order_release);
+    ASYNC.dequeue_pos += 1;
+    count += 1;
+
+    if (BufferLength(out) + BufferLength(err) >= DEFAULT_BUFFER_CAPACITY * 64) {
+      break;
+    }
+  }
+
+  if (count == 0) {
+    return false;
+  }
+
+  WriteAll(STDOUT_FILENO, BufferData(out), BufferLength(out));
+  WriteAll(STDERR_FILENO, BufferData(err), BufferLength(err));
+  BufferClear(out);
+  BufferClear(err);
+
+  atomic_fetch_add_explicit(&ASYNC.logged, count, memory_order_relaxed);
+  atomic_fetch_add_explicit(&ASYNC.batches, 1, memory_order_relaxed);
+  atomic_store_explicit(&ASYNC.written_pos, ASYNC.dequeue_pos,
+                        memory_order_release);
+  return true;
+}
+
+static void *BackgroundThread(void *const arg) {
+  (void)arg;
+
+  Buffer out, err;
+  BufferInit(&out);
+  BufferInit(&err);
+
+  long idle = 1000;
+  while (atomic_load_explicit(&ASYNC.running, memory_order_acquire)) {
+    if (Drain(&out, &err)) {
+      idle = 1000;
+      continue;
+    }
+
+    const struct timespec ts = {.tv_sec = 0, .tv_nsec = idle};
+    nanosleep(&ts, NULL);
+    idle = (idle * 2 < MAX_IDLE_NANOSECONDS) ? idle * 2 : MAX_IDLE_NANOSECONDS;
+  }
+
+  // Producers are gone, write whatever they left behind
+  while (Drain(&out, &err)) {
+  }
+
+  BufferDeinit(&out);
+  BufferDeinit(&err);
+  return NULL;
+}
+
+/**
+ * @brief Queue a message for the background thread.
+ * @return False if the message was dropped.
+ */
+static bool Enqueue(const enum LoggerLogLevel level, const char *const file,
+                    const int line, const char *const format, va_list ap) {
+  size_t pos = atomic_load_explicit(&ASYNC.enqueue_pos, memory_order_relaxed);
+  Slot *slot;
+
+  for (;;) {
+    slot = &ASYNC.slots[pos & QUEUE_MASK];
+    const size_t sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&ASYNC.enqueue_pos, &pos,
+                                                pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break; // The slot is ours
+      }
+    } else if (diff < 0) {
+      // The queue is full
+      if (ASYNC.policy == LOGGER_OVERFLOW_DROP) {
+        atomic_fetch_add_explicit(&ASYNC.dropped, 1, memory_order_relaxed);
+        return false;
+      }
+      sched_yield();
+      pos = atomic_load_explicit(&ASYNC.enqueue_pos, memory_order_relaxed);
+    } else {
+      // Another producer claimed the slot first
+      pos = atomic_load_explicit(&ASYNC.enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  slot->level = level;
+  slot->file = file;
+  slot->line = line;
+
+  va_list aq;
+  va_copy(aq, ap);
+  slot->formatted = !Encode(slot, format, aq);
+  va_end(aq);
+
+  if (slot->formatted) {
+    const int ret = vsnprintf(slot->data, SLOT_SIZE, format, ap);
+    slot->length = (ret < 0) ? 0 : ((size_t)ret < SLOT_SIZE) ? (size_t)ret
+                                                             : SLOT_SIZE - 1;
+  }
+
+  atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+  return true;
+}
+
+void LoggerStartAsync(const enum LoggerOverflowPolicy policy) {
+  if (atomic_load(&ASYNC.running)) {
+    return;
+  }
+
+  ASYNC.slots = xcalloc(DEFAULT_LOGGER_QUEUE_SIZE, sizeof(Slot));
+  for (size_t i = 0; i < DEFAULT_LOGGER_QUEUE_SIZE; i++) {
+    atomic_init(&ASYNC.slots[i].sequence, i);
+  }
+
+  ASYNC.policy = policy;
+  ASYNC.dequeue_pos = 0;
+  atomic_store(&ASYNC.enqueue_pos, 0);
+  atomic_store(&ASYNC.written_pos, 0);
+  atomic_store(&ASYNC.logged, 0);
+  atomic_store(&ASYNC.dropped, 0);
+  atomic_store(&ASYNC.batches, 0);
+
+  // Anything already buffered by stdio must precede the queued messages
+  fflush(stdout);
+  fflush(stderr);
+
+  atomic_store(&ASYNC.running, true);
+  const int ret = pthread_create(&ASYNC.thread, NULL, BackgroundThread, NULL);
+  if (ret != 0) {
+    atomic_store(&ASYNC.running, false);
+    xfree(ASYNC.slots);
+    ASYNC.slots = NULL;
+    LOG_WARNING("pthread_create(3): Failed to start logger thread: %s",
+                strerror(ret));
+  }
+}
+
+void LoggerFlush(void) {
+  if (!atomic_load(&ASYNC.running) ||
+      pthread_equal(pthread_self(), ASYNC.thread)) {
+    return;
+  }
+
+  const size_t pos = atomic_load(&ASYNC.enqueue_pos);
+  while (atomic_load_explicit(&ASYNC.written_pos, memory_order_acquire) <
+         pos) {
+    sched_yield();
+  }
+}
+
+void LoggerStopAsync(void) {
+  if (!atomic_load(&ASYNC.running)) {
+    return;
+  }
+
+  atomic_store(&ASYNC.running, false);
+  pthread_join(ASYNC.thread, NULL);
+  xfree(ASYNC.slots);
+  ASYNC.slots = NULL;
+
+  const size_t dropped = atomic_load(&ASYNC.dropped);
+  if (dropped > 0) {
+    LOG_WARNING("Dropped %zu log messages: Logging faster than output is "
+                "written",
+                dropped);
+  }
+}
+
+void LoggerGetStats(LoggerStats *const stats) {
+  assert(stats != NULL);
+  stats->logged = atomic_load(&ASYNC.logged);
+  stats->dropped = atomic_load(&ASYNC.dropped);
+  stats->batches = atomic_load(&ASYNC.batches);
+}
+
+/****************************************************************************/
+
 void LoggerLogMessage(enum LoggerLogLevel level, const char *file,
                       const int line, const char *format, ...) {
   assert(format != NULL);
 
+  if (level == LOGGER_MESSAGE_TYPE_DEBUG && !LOGGER_LOG_DEBUG) {
+    return;
+  }
+
   va_list ap;
   va_start(ap, format);
 
+  if (level != LOGGER_MESSAGE_TYPE_CRITICAL && atomic_load(&ASYNC.running)) {
+    Enqueue(level, file, line, format, ap);
+    va_end(ap);
+    return;
+  }
+
   char message[4096];
   int size = vsnprintf(message, sizeof(message), format, ap);
   if (size < 0 || (size_t)size >= sizeof(message)) {
@@ -27,9 +653,7 @@ void LoggerLogMessage(enum LoggerLogLevel level, const char *file,
 
   switch (level) {
   case LOGGER_MESSAGE_TYPE_DEBUG:
-    if (LOGGER_LOG_DEBUG) {
-      fprintf(stdout, "[DEBUG][%s:%d]: %s\n", file, line, message);
-    }
+    fprintf(stdout, "[DEBUG][%s:%d]: %s\n", file, line, message);
     break;
   case LOGGER_MESSAGE_TYPE_WARNING:
     fprintf(stdout, "[WARNING]: %s\n", message);
@@ -38,6 +662,8 @@ void LoggerLogMessage(enum LoggerLogLevel level, const char *file,
     fprintf(stderr, "[ERROR]: %s\n", message);
     break;
   case LOGGER_MESSAGE_TYPE_CRITICAL:
+    // Messages logged before this one must not get lost in the abort
+    LoggerFlush();
     fprintf(stderr, "[CRITICAL][%s:%d]: %s: ", file, line, message);
     abort(); // It is not safe to proceed
   }
@@ -2,6 +2,7 @@
 #define _AETHER_LOGGER_H
 
 #include <stdbool.h>
+#include <stdlib.h>
 
 enum LoggerLogLevel {
   LOGGER_MESSAGE_TYPE_DEBUG,
@@ -10,6 +11,21 @@ enum LoggerLogLevel {
   LOGGER_MESSAGE_TYPE_CRITICAL,
 };
 
+/**
+ * @brief What to do when a message is logged while the queue of the
+ *        asynchronous logger is full.
+ */
+enum LoggerOverflowPolicy {
+  LOGGER_OVERFLOW_DROP,  // Discard the message and count it as dropped
+  LOGGER_OVERFLOW_BLOCK, // Wait for the background thread to make room
+};
+
+typedef struct {
+  size_t logged;  // Messages written by the background thread
+  size_t dropped; // Messages discarded because the queue was full
+  size_t batches; // Number of times the background thread wrote output
+} LoggerStats;
+
 /**
  * @brief Log a debug message using a format string and arguments.
  * @note Debug messages are printed to stdout if and only if debug messaging
@@ -50,6 +66,49 @@ enum LoggerLogLevel {
  */
 void LoggerSetDebug(bool enable);
 
+/**
+ * @brief Check if debug log messages are enabled, see LoggerSetDebug().
+ * @return True if debug log messages are enabled.
+ * @note Allows callers to skip preparing debug messages in hot paths.
+ */
+bool LoggerGetDebug(void);
+
+/**
+ * @brief Hand log messages over to a background thread.
+ * @param policy What to do when messages are logged faster than they can be
+ *               written.
+ * @note Messages are queued in a lock-free ring buffer holding up to
+ *       DEFAULT_LOGGER_QUEUE_SIZE messages. The format string and a binary
+ *       copy of the arguments are queued, and formatting is left to the
+ *       background thread, which writes its output in batches. Hence, logging
+ *       never blocks on terminal or pipe I/O, unless policy is
+ *       LOGGER_OVERFLOW_BLOCK and the queue is full. Critical messages are
+ *       still written synchronously, once all queued messages are flushed.
+ */
+void LoggerStartAsync(enum LoggerOverflowPolicy policy);
+
+/**
+ * @brief Wait until all messages queued so far are written.
+ * @note If the asynchronous logger is not started, no operation is performed.
+ */
+void LoggerFlush(void);
+
+/**
+ * @brief Flush queued messages and go back to logging synchronously.
+ * @note If any messages were dropped, a warning saying how many is logged.
+ *       If the asynchronous logger is not started, no operation is
+ *       performed.
+ * @warning Other threads must have stopped logging before this is called.
+ */
+void LoggerStopAsync(void);
+
+/**
+ * @brief Get the counters of the asynchronous logger.
+ * @param stats Is set to the counters accumulated since the asynchronous
+ *              logger was last started.
+ */
+void LoggerGetStats(LoggerStats *stats);
+
 /**
  * @brief Format log message.
  * @param level Type of message. One of; LOG_DEBUG, LOG_WARNING, LOG_ERROR or
@@ -0,0 +1,319 @@
+#include "pool.h"
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "logger.h"
+
+#define GRANULARITY alignof(max_align_t)
+#define NUM_SIZE_CLASSES (POOL_MAX_SIZE / GRANULARITY)
+
+/* Slabs are aligned to their size, so that the slab of an object is found by
+ * masking its address. */
+#if (DEFAULT_POOL_SLAB_SIZE & (DEFAULT_POOL_SLAB_SIZE - 1)) != 0
+#error "DEFAULT_POOL_SLAB_SIZE must be a power of two"
+#endif
+
+typedef struct Object {
+  struct Object *next;
+} Object;
+
+typedef struct Pool Pool;
+
+/* Each slab starts with this header, padded to keep the objects aligned. The
+ * links keep slabs reachable for leak checkers. */
+typedef struct Slab {
+  struct Slab *next;
+  Pool *owner;
+  size_t size_class;
+  size_t num_free; // Only used while releasing slabs, see ReleasePool()
+} Slab;
+
+#define SLAB_HEADER_SIZE                                                       \
+  (((sizeof(Slab) + GRANULARITY - 1) / GRANULARITY) * GRANULARITY)
+
+/* A pool is owned by one thread at a time, which is the only one to touch
+ * its free lists. Other threads push the objects they release onto the remote
+ * lists instead, which the owner takes over once a free list runs dry. */
+struct Pool {
+  Object *free_lists[NUM_SIZE_CLASSES];
+  _Atomic(Object *) remote_lists[NUM_SIZE_CLASSES];
+  Slab *slabs;
+  Pool *next; // Next orphaned pool, see ReleasePool()
+};
+
+typedef enum {
+  POOL_MODE_UNKNOWN = 0,
+  POOL_MODE_POOLED,
+  POOL_MODE_BYPASS, // Tracking call sites, see Initialize()
+} PoolMode;
+
+static pthread_once_t INITIALIZED = PTHREAD_ONCE_INIT;
+static PoolMode GLOBAL_MODE;
+static pthread_key_t KEY;
+
+/* Pools of exited threads that still had objects allocated. They are adopted
+ * by the next threads to use the pool. */
+static pthread_mutex_t ORPHANS_MUTEX = PTHREAD_MUTEX_INITIALIZER;
+static Pool *ORPHANS = NULL;
+
+/* The initial-exec model spares the lookup through __tls_get_addr() otherwise
+ * needed in a shared library, which would cost as much as the rest of an
+ * allocation. */
+#ifdef __GNUC__
+static _Thread_local PoolMode MODE __attribute__((tls_model("initial-exec")));
+static _Thread_local Pool *POOL __attribute__((tls_model("initial-exec")));
+#else
+static _Thread_local PoolMode MODE;
+static _Thread_local Pool *POOL;
+#endif
+
+static void ReleasePool(void *ptr);
+
+/**
+ * @brief Decide once for the whole process whether objects are pooled.
+ * @note Latching the mode per thread would let a thread that bypasses the
+ *       pool xfree() an object carved out of a slab by another thread, or vice
+ *       versa.
+ */
+static void Initialize(void) {
+  GLOBAL_MODE = (AllocGetTracking() & ALLOC_TRACK_SITES) ? POOL_MODE_BYPASS
+                                                         : POOL_MODE_POOLED;
+
+  const int ret = pthread_key_create(&KEY, ReleasePool);
+  if (ret != 0) {
+    LOG_CRITICAL("pthread_key_create(3): Failed to create key: %s",
+                 strerror(ret));
+  }
+}
+
+static size_t GetSizeClass(const size_t size) {
+  return (size > 0) ? (size - 1) / GRANULARITY : 0;
+}
+
+static size_t GetNumObjects(const size_t size_class) {
+  const size_t size = (size_class + 1) * GRANULARITY;
+  return (DEFAULT_POOL_SLAB_SIZE - SLAB_HEADER_SIZE) / size;
+}
+
+static Slab *GetSlab(const void *const object) {
+  return (Slab *)((uintptr_t)object &
+                  ~(uintptr_t)(DEFAULT_POOL_SLAB_SIZE - 1));
+}
+
+/**
+ * @brief Check whether an object is allocated through xmalloc() rather than
+ *        the pool.
+ */
+static bool Bypass(const size_t size) {
+  if (MODE == POOL_MODE_UNKNOWN) {
+    pthread_once(&INITIALIZED, Initialize);
+    MODE = GLOBAL_MODE;
+  }
+  return size > POOL_MAX_SIZE || MODE == POOL_MODE_BYPASS;
+}
+
+/**
+ * @brief Get the pool of the calling thread, adopting an orphaned pool or
+ *        creating a new one on first use.
+ */
+static Pool *GetPool(void) {
+  if (POOL != NULL) {
+    return POOL;
+  }
+
+  pthread_mutex_lock(&ORPHANS_MUTEX);
+  Pool *pool = ORPHANS;
+  if (pool != NULL) {
+    ORPHANS = pool->next;
+  }
+  pthread_mutex_unlock(&ORPHANS_MUTEX);
+
+  if (pool == NULL) {
+    // Bypass the pluggable allocator, pools outlive any arena
+    pool = (Pool *)malloc(sizeof(Pool));
+    if (pool == NULL) {
+      LOG_CRITICAL("malloc(3): Failed to allocate pool: %s", strerror(errno));
+    }
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+      pool->free_lists[i] = NULL;
+      atomic_init(&pool->remote_lists[i], NULL);
+    }
+    pool->slabs = NULL;
+  }
+  pool->next = NULL;
+
+  const int ret = pthread_setspecific(KEY, pool);
+  if (ret != 0) {
+    LOG_CRITICAL("pthread_setspecific(3): Failed to set pool: %s",
+                 strerror(ret));
+  }
+  POOL = pool;
+  return pool;
+}
+
+/**
+ * @brief Carve a new slab into objects of the given size class. The first
+ *        object is returned, the rest are put on the free list.
+ * @note Slabs come straight from the system allocator rather than xmalloc(),
+ *       which may be backed by an arena that is destroyed while pool objects
+ *       are still around.
+ */
+static void *Refill(Pool *const pool, const size_t size_class) {
+  const size_t size = (size_class + 1) * GRANULARITY;
+  const size_t num_objects = GetNumObjects(size_class);
+  assert(num_objects > 0);
+
+  void *memory = NULL;
+  const int ret =
+      posix_memalign(&memory, DEFAULT_POOL_SLAB_SIZE, DEFAULT_POOL_SLAB_SIZE);
+  if (ret != 0) {
+    LOG_CRITICAL("posix_memalign(3): Failed to allocate slab: %s",
+                 strerror(ret));
+  }
+
+  Slab *const slab = (Slab *)memory;
+  slab->next = pool->slabs;
+  slab->owner = pool;
+  slab->size_class = size_class;
+  pool->slabs = slab;
+
+  unsigned char *const objects = (unsigned char *)slab + SLAB_HEADER_SIZE;
+  Object *next = NULL;
+  for (size_t i = num_objects - 1; i > 0; i--) {
+    Object *const object = (Object *)(objects + i * size);
+    object->next = next;
+    next = object;
+  }
+  pool->free_lists[size_class] = next;
+  return objects;
+}
+
+/**
+ * @brief Release the pool of an exiting thread.
+ * @note Slabs whose objects are all free are returned to the system. If any
+ *       objects are still allocated, the pool is left for another thread to
+ *       adopt along with its remaining slabs, since other threads may still
+ *       release objects into it.
+ */
+static void ReleasePool(void *const ptr) {
+  Pool *const pool = (Pool *)ptr;
+  assert(pool != NULL);
+  POOL = NULL;
+
+  // Take over the objects released by other threads so far
+  for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+    Object *object = atomic_exchange_explicit(&pool->remote_lists[i], NULL,
+                                              memory_order_acquire);
+    while (object != NULL) {
+      Object *const next = object->next;
+      object->next = pool->free_lists[i];
+      pool->free_lists[i] = object;
+      object = next;
+    }
+  }
+
+  for (Slab *slab = pool->slabs; slab != NULL; slab = slab->next) {
+    slab->num_free = 0;
+  }
+  for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+    for (Object *object = pool->free_lists[i]; object != NULL;
+         object = object->next) {
+      GetSlab(object)->num_free += 1;
+    }
+  }
+
+  // Drop the objects of entirely free slabs from the free lists
+  for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+    Object **link = &pool->free_lists[i];
+    while (*link != NULL) {
+      const Slab *const slab = GetSlab(*link);
+      if (slab->num_free == GetNumObjects(slab->size_class)) {
+        *link = (*link)->next;
+      } else {
+        link = &(*link)->next;
+      }
+    }
+  }
+
+  Slab **link = &pool->slabs;
+  while (*link != NULL) {
+    Slab *const slab = *link;
+    if (slab->num_free == GetNumObjects(slab->size_class)) {
+      *link = slab->next;
+      free(slab);
+    } else {
+      link = &slab->next;
+    }
+  }
+
+  // Without any slabs left, no other thread can refer to the pool
+  if (pool->slabs == NULL) {
+    free(pool);
+    return;
+  }
+
+  pthread_mutex_lock(&ORPHANS_MUTEX);
+  pool->next = ORPHANS;
+  ORPHANS = pool;
+  pthread_mutex_unlock(&ORPHANS_MUTEX);
+}
+
+void *PoolAllocate(const size_t size, const char *const file,
+                   const int line) {
+  if (Bypass(size)) {
+    return AllocMalloc(size, file, line);
+  }
+
+  Pool *const pool = GetPool();
+  const size_t size_class = GetSizeClass(size);
+  Object *object = pool->free_lists[size_class];
+  if (object == NULL) {
+    object = atomic_exchange_explicit(&pool->remote_lists[size_class], NULL,
+                                      memory_order_acquire);
+    if (object == NULL) {
+      return Refill(pool, size_class);
+    }
+  }
+  pool->free_lists[size_class] = object->next;
+  return object;
+}
+
+void PoolFree(void *const ptr, const size_t size) {
+  if (ptr == NULL) {
+    return;
+  }
+  if (Bypass(size)) {
+    xfree(ptr);
+    return;
+  }
+
+  Slab *const slab = GetSlab(ptr);
+  assert(slab->size_class == GetSizeClass(size));
+  const size_t size_class = slab->size_class;
+  Object *const object = (Object *)ptr;
+
+  Pool *const owner = slab->owner;
+  if (owner == POOL) {
+    object->next = owner->free_lists[size_class];
+    owner->free_lists[size_class] = object;
+    return;
+  }
+
+  // Hand the object back to the thread owning its slab
+  object->next = atomic_load_explicit(&owner->remote_lists[size_class],
+                                      memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(
+      &owner->remote_lists[size_class], &object->next, object,
+      memory_order_release, memory_order_relaxed)) {
+  }
+}
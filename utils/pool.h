@@ -0,0 +1,46 @@
+#ifndef _AETHER_POOL_H
+#define _AETHER_POOL_H
+
+#include <stdlib.h>
+
+/**
+ * Pool allocator for the many small objects of fixed size, e.g., list
+ * elements and syntax tree symbols. Each thread keeps a free list per size
+ * class, which is refilled a slab at a time from the system allocator. Hence,
+ * allocating and releasing an object is a matter of popping and pushing a
+ * list, without any locking.
+ *
+ * Each slab belongs to the thread that carved it. An object released by
+ * another thread is handed back to the owner through a lock-free list, which
+ * the owner takes over once its own free list runs dry. When a thread exits,
+ * its entirely free slabs are released. Slabs with objects still allocated
+ * are adopted by the next thread to use the pool. If ALLOC_TRACK_SITES is
+ * enabled when the pool is first used, every thread allocates objects straight
+ * through xmalloc() instead, so that they are reported by their call site.
+ */
+
+/**
+ * Objects larger than this are allocated through xmalloc().
+ */
+#define POOL_MAX_SIZE 256
+
+void *PoolAllocate(size_t size, const char *file, int line);
+
+/**
+ * @brief Allocate an object, see xmalloc().
+ * @param size Size of the object.
+ * @return The object, aligned like memory returned by malloc(3).
+ */
+#define PoolAlloc(size) PoolAllocate((size), __FILE__, __LINE__)
+
+/**
+ * @brief Release an object allocated by PoolAlloc().
+ * @param ptr The object.
+ * @param size Size of the object, as passed to PoolAlloc().
+ * @note If ptr is NULL, no operation is performed.
+ * @warning The tracking flags must not be changed while pool objects are
+ *          allocated, see AllocSetTracking().
+ */
+void PoolFree(void *ptr, size_t size);
+
+#endif // _AETHER_POOL_H
@@ -0,0 +1,55 @@
+#include "ptr_dict.h"
+#include "config.h"
+
+#include <stdint.h>
+
+#include "int_dict.h"
+
+/* A pointer keyed dictionary is an integer keyed dictionary keyed by address.
+ * The distinct type only exists to keep the two from being mixed up. */
+
+#define TO_INT_DICT(dict) ((IntDict *)(dict))
+#define TO_CONST_INT_DICT(dict) ((const IntDict *)(dict))
+#define TO_KEY(ptr) ((uint64_t)(uintptr_t)(ptr))
+
+PtrDict *PtrDictCreate(void) { return (PtrDict *)IntDictCreate(); }
+
+PtrDict *PtrDictCreateWithCapacity(const size_t capacity) {
+  return (PtrDict *)IntDictCreateWithCapacity(capacity);
+}
+
+void PtrDictDestroy(void *const dict) { IntDictDestroy(dict); }
+
+size_t PtrDictLength(const PtrDict *const dict) {
+  return IntDictLength(TO_CONST_INT_DICT(dict));
+}
+
+void PtrDictSet(PtrDict *const dict, const void *const key, void *const value,
+                void (*destroy)(void *)) {
+  IntDictSet(TO_INT_DICT(dict), TO_KEY(key), value, destroy);
+}
+
+bool PtrDictHasKey(const PtrDict *const dict, const void *const key) {
+  return IntDictHasKey(TO_CONST_INT_DICT(dict), TO_KEY(key));
+}
+
+const void *PtrDictGet(const PtrDict *const dict, const void *const key) {
+  return IntDictGet(TO_CONST_INT_DICT(dict), TO_KEY(key));
+}
+
+void *PtrDictRemove(PtrDict *const dict, const void *const key) {
+  return IntDictRemove(TO_INT_DICT(dict), TO_KEY(key));
+}
+
+bool PtrDictIterate(const PtrDict *const dict, size_t *const cursor,
+                    const void **const key, const void **const value) {
+  uint64_t int_key;
+  if (!IntDictIterate(TO_CONST_INT_DICT(dict), cursor, &int_key, value)) {
+    return false;
+  }
+
+  if (key != NULL) {
+    *key = (const void *)(uintptr_t)int_key;
+  }
+  return true;
+}
@@ -0,0 +1,88 @@
+#ifndef _AETHER_PTR_DICT_H
+#define _AETHER_PTR_DICT_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct PtrDict PtrDict;
+
+/**
+ * @brief Create a pointer keyed dictionary.
+ * @return The dictionary.
+ * @note Caller takes ownership of returned value. Keys are compared by
+ *       address only, and are never dereferenced or destroyed.
+ */
+PtrDict *PtrDictCreate(void);
+
+/**
+ * @brief Create a pointer keyed dictionary with room for a given number of
+ *        entries.
+ * @param capacity Number of entries to allocate room for.
+ * @return The dictionary.
+ * @note Caller takes ownership of returned value.
+ */
+PtrDict *PtrDictCreateWithCapacity(size_t capacity);
+
+/**
+ * @brief Destroy the dictionary.
+ * @param dict Pointer to dictionary.
+ * @note If ptr is NULL, no operation is performed. Otherwise, values are
+ *       destroyed using passed destroy function unless it's NULL.
+ */
+void PtrDictDestroy(void *dict);
+
+/**
+ * @brief Get number of entries in dictionary.
+ * @param dict The dictionary.
+ * @return Number of entries in dictionary.
+ */
+size_t PtrDictLength(const PtrDict *dict);
+
+/**
+ * @brief Create/update entry in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @param value Value of entry.
+ * @param destroy Function to destroy the value of the entry or NULL.
+ */
+void PtrDictSet(PtrDict *dict, const void *key, void *value,
+                void (*destroy)(void *));
+
+/**
+ * @brief Check for existance of entry in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return True if entry with key exists.
+ */
+bool PtrDictHasKey(const PtrDict *dict, const void *key);
+
+/**
+ * @brief Get value of entry with key in dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return Value of entry.
+ */
+const void *PtrDictGet(const PtrDict *dict, const void *key);
+
+/**
+ * @brief Remove entry from dictionary.
+ * @param dict The dictionary.
+ * @param key Key of entry.
+ * @return Value of entry.
+ * @note Caller takes ownership of returned value.
+ */
+void *PtrDictRemove(PtrDict *dict, const void *key);
+
+/**
+ * @brief Advance an iterator over entries in dictionary.
+ * @param dict The dictionary.
+ * @param cursor Iterator state, must be initialized to zero.
+ * @param key Output for key of the next entry or NULL.
+ * @param value Output for value of the next entry or NULL.
+ * @return True if an entry was produced, false if there are no more entries.
+ * @note See IntDictIterate() for the iteration order.
+ */
+bool PtrDictIterate(const PtrDict *dict, size_t *cursor, const void **key,
+                    const void **value);
+
+#endif // _AETHER_PTR_DICT_H
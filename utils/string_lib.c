@@ -1,12 +1,15 @@
 #include "string_lib.h"
 
 #include <assert.h>
-#include <errno.h>
+#include <float.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
-#include <logger.h>
+#include "alloc.h"
+#include "logger.h"
 
 bool StringEqual(const char *const str_1, const char *const str_2) {
   assert(str_1 != NULL);
@@ -23,10 +26,7 @@ char *StringFormat(const char *const format, ...) {
   assert(length >= 0);
   va_end(ap);
 
-  char *const str = (char *)malloc((size_t)length + 1);
-  if (str == NULL) {
-    LOG_CRITICAL("malloc(3): Failed to allocate memory: %s", strerror(errno));
-  }
+  char *const str = (char *)xmalloc((size_t)length + 1);
 
   va_start(ap, format);
   const int ret = vsnprintf(str, (size_t)length + 1, format, ap);
@@ -42,21 +42,112 @@ char *StringFormat(const char *const format, ...) {
 char *StringDuplicate(const char *const str) {
   assert(str != NULL);
 
-  char *duplicate = strdup(str);
-  if (duplicate == NULL) {
-    LOG_CRITICAL("strdup(3): Failed to duplicate string: %s", strerror(errno));
-  }
-
+  const size_t length = strlen(str);
+  char *const duplicate = (char *)xmalloc(length + 1);
+  memcpy(duplicate, str, length + 1);
   return duplicate;
 }
 
 char *StringDuplicateN(const char *const str, const size_t num) {
   assert(str != NULL);
 
-  char *duplicate = strndup(str, num);
-  if (duplicate == NULL) {
-    LOG_CRITICAL("strdup(3): Failed to duplicate string: %s", strerror(errno));
+  const size_t length = strnlen(str, num);
+  char *const duplicate = (char *)xmalloc(length + 1);
+  memcpy(duplicate, str, length);
+  duplicate[length] = '\0';
+  return duplicate;
+}
+
+bool StringToUInt(const char *const str, const size_t length,
+                  unsigned long long *const value) {
+  assert(str != NULL);
+  assert(value != NULL);
+
+  if (length == 0) {
+    return false;
   }
 
-  return duplicate;
+  unsigned long long result = 0;
+  for (size_t i = 0; i < length; i++) {
+    const unsigned digit = (unsigned)(unsigned char)str[i] - '0';
+    if (digit > 9) {
+      return false;
+    }
+    if (result > (ULLONG_MAX - digit) / 10) {
+      return false;
+    }
+    result = (result * 10) + digit;
+  }
+
+  *value = result;
+  return true;
+}
+
+/* Powers of ten that are exactly representable as a double. */
+static const double EXACT_POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+#define MAX_EXACT_POWER_OF_TEN                                                 \
+  (sizeof(EXACT_POWERS_OF_TEN) / sizeof(EXACT_POWERS_OF_TEN[0]) - 1)
+
+/* Integers up to 2^53 are exactly representable as a double. */
+#define MAX_EXACT_MANTISSA (1ULL << 53)
+
+/* Any 19 digit number fits in 64 bits. */
+#define MAX_EXACT_DIGITS 19
+
+bool StringToDouble(const char *const str, const size_t length,
+                    double *const value) {
+  assert(str != NULL);
+  assert(value != NULL);
+
+  /* Accumulate the significant digits into a mantissa, and count the digits
+   * of the fraction it contains, i.e., the number is mantissa / 10^scale. */
+  uint64_t mantissa = 0;
+  size_t num_digits = 0; // Significant digits, i.e., after leading zeros
+  size_t scale = 0;
+  bool has_digits = false, has_point = false;
+
+  for (size_t i = 0; i < length; i++) {
+    const char ch = str[i];
+    if (ch == '.' && !has_point) {
+      has_point = true;
+      continue;
+    }
+    const unsigned digit = (unsigned)(unsigned char)ch - '0';
+    if (digit > 9) {
+      return false;
+    }
+    has_digits = true;
+
+    if (mantissa == 0 && digit == 0 && !has_point) {
+      continue; // Leading zero of the integer part
+    }
+    num_digits += (mantissa > 0 || digit > 0) ? 1 : 0;
+    if (num_digits <= MAX_EXACT_DIGITS) {
+      mantissa = (mantissa * 10) + digit;
+      scale += has_point ? 1 : 0;
+    }
+  }
+
+  if (!has_digits) {
+    return false;
+  }
+
+  /* Clinger's fast path: both operands are exact, hence the division rounds
+   * correctly. It requires doubles to be evaluated in double precision. */
+#if FLT_EVAL_METHOD == 0
+  if (num_digits <= MAX_EXACT_DIGITS && mantissa <= MAX_EXACT_MANTISSA &&
+      scale <= MAX_EXACT_POWER_OF_TEN) {
+    *value = (double)mantissa / EXACT_POWERS_OF_TEN[scale];
+    return true;
+  }
+#endif
+
+  char *const copy = StringDuplicateN(str, length);
+  *value = strtod(copy, NULL);
+  xfree(copy);
+  return true;
 }
@@ -36,4 +36,27 @@ char *StringDuplicate(const char *str);
  */
 char *StringDuplicateN(const char *str, size_t num);
 
+/**
+ * @brief Convert a string of decimal digits to an unsigned integer.
+ * @param str The digits, need not be null-terminated.
+ * @param length Number of digits.
+ * @param value Is set to the integer on success.
+ * @return False if the string is empty, contains anything but digits, or
+ *         the integer does not fit in an unsigned long long.
+ */
+bool StringToUInt(const char *str, size_t length, unsigned long long *value);
+
+/**
+ * @brief Convert a string of decimal digits, optionally followed by a
+ *        fraction (e.g., "3.14" or "42."), to the nearest double.
+ * @param str The number, need not be null-terminated.
+ * @param length Length of the number.
+ * @param value Is set to the double on success.
+ * @return False if the string is not such a number.
+ * @note Numbers with at most 19 significant digits whose mantissa fits in a
+ *       double are converted exactly with a single division. Others fall
+ *       back to strtod(3).
+ */
+bool StringToDouble(const char *str, size_t length, double *value);
+
 #endif // _AETHER_STRING_LIB_H
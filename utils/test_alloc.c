@@ -0,0 +1,126 @@
+#include "../tests/check.h"
+#include "alloc.c"
+
+static void test_AllocGetStats(void) {
+  AllocSetTracking(ALLOC_TRACK_TOTALS);
+
+  AllocStats before, after;
+  AllocGetStats(&before);
+
+  char *ptr = xmalloc(16);
+  AllocGetStats(&after);
+  check(after.calls == before.calls + 1);
+  check(after.bytes == before.bytes + 16);
+
+  ptr = xrealloc(ptr, 32);
+  AllocGetStats(&after);
+  check(after.calls == before.calls + 2);
+  check(after.bytes == before.bytes + 48);
+  xfree(ptr);
+
+  AllocSetTracking(0);
+  ptr = xmalloc(16);
+  AllocGetStats(&after);
+  check(after.calls == before.calls + 2);
+  xfree(ptr);
+}
+
+static void test_xcalloc(void) {
+  int *const array = xcalloc(64, sizeof(int));
+  for (size_t i = 0; i < 64; i++) {
+    check(array[i] == 0);
+  }
+  xfree(array);
+  xfree(NULL);
+}
+
+static void test_AllocReport(void) {
+  AllocSetTracking(ALLOC_TRACK_SITES);
+
+  void *ptrs[100];
+  for (size_t i = 0; i < 100; i++) {
+    ptrs[i] = xmalloc(i + 1);
+  }
+  ptrs[0] = xrealloc(ptrs[0], 1000);
+  for (size_t i = 0; i < 100; i += 2) {
+    xfree(ptrs[i]);
+  }
+
+  FILE *const stream = tmpfile();
+  check(stream != NULL);
+  check(AllocReport(stream) == 50);
+
+  char line[256];
+  bool found = false;
+  rewind(stream);
+  while (fgets(line, sizeof(line), stream) != NULL) {
+    if (strstr(line, "Leaked 2550 bytes in 50 blocks allocated at ") != NULL &&
+        strstr(line, "test_alloc.c:") != NULL) {
+      found = true;
+    }
+  }
+  check(found);
+  fclose(stream);
+
+  for (size_t i = 1; i < 100; i += 2) {
+    xfree(ptrs[i]);
+  }
+  check(AllocReport(stderr) == 0);
+
+  AllocSetTracking(0);
+}
+
+typedef struct {
+  size_t mallocs;
+  size_t reallocs;
+  size_t frees;
+} Counters;
+
+static void *CountingMalloc(void *const state, const size_t size) {
+  ((Counters *)state)->mallocs += 1;
+  return malloc(size);
+}
+
+static void *CountingRealloc(void *const state, void *const ptr,
+                             const size_t size) {
+  ((Counters *)state)->reallocs += 1;
+  return realloc(ptr, size);
+}
+
+static void CountingFree(void *const state, void *const ptr) {
+  ((Counters *)state)->frees += 1;
+  free(ptr);
+}
+
+static void test_AllocSetAllocator(void) {
+  Counters counters = {0};
+  const Allocator allocator = {
+      .malloc = CountingMalloc,
+      .realloc = CountingRealloc,
+      .free = CountingFree,
+      .state = &counters,
+  };
+
+  Allocator previous;
+  AllocSetAllocator(&allocator, &previous);
+  char *ptr = xcalloc(4, 4);
+  ptr = xrealloc(ptr, 32);
+  xfree(ptr);
+  AllocSetAllocator(&previous, NULL);
+
+  check(counters.mallocs == 1);
+  check(counters.reallocs == 1);
+  check(counters.frees == 1);
+
+  ptr = xmalloc(8);
+  xfree(ptr);
+  check(counters.mallocs == 1);
+  check(counters.frees == 1);
+}
+
+CHECK_BEGIN
+CHECK_ADD("AllocGetStats", test_AllocGetStats)
+CHECK_ADD("xcalloc", test_xcalloc)
+CHECK_ADD("AllocReport", test_AllocReport)
+CHECK_ADD("AllocSetAllocator", test_AllocSetAllocator)
+CHECK_END
@@ -0,0 +1,48 @@
+#include "../tests/check.h"
+#include "arena.c"
+
+static void test_ArenaAllocator(void) {
+  Arena *const arena = ArenaCreate(256);
+  Allocator allocator, previous;
+  ArenaAllocator(arena, &allocator);
+  AllocSetAllocator(&allocator, &previous);
+
+  char *const a = xmalloc(3);
+  memcpy(a, "ab", 3);
+  long double *const b = xmalloc(sizeof(long double));
+  check(((uintptr_t)b % alignof(max_align_t)) == 0);
+  *b = 1.5L;
+
+  // The most recent block grows in place
+  char *c = xmalloc(10);
+  memcpy(c, "foo", 4);
+  char *const grown = xrealloc(c, 100);
+  check(grown == c);
+  check(strcmp(grown, "foo") == 0);
+
+  // Other blocks are copied
+  char *const moved = xrealloc(a, 16);
+  check(moved != a);
+  check(strcmp(moved, "ab") == 0);
+
+  // Allocations larger than a chunk get a chunk of their own
+  char *const large = xmalloc(1000);
+  memset(large, 'x', 1000);
+  check(*b == 1.5L);
+  check(ArenaSize(arena) >= 1256);
+
+  // Releasing the most recent block gives it back
+  char *const d = xmalloc(8);
+  xfree(d);
+  char *const e = xmalloc(8);
+  check(d == e);
+  xfree(moved);
+
+  AllocSetAllocator(&previous, NULL);
+  ArenaDestroy(arena);
+  ArenaDestroy(NULL);
+}
+
+CHECK_BEGIN
+CHECK_ADD("ArenaAllocator", test_ArenaAllocator)
+CHECK_END
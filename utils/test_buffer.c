@@ -1,5 +1,6 @@
 #include "buffer.c"
 
+#include <limits.h>
 #include <stdlib.h>
 
 #include "../tests/check.h"
@@ -9,10 +10,58 @@ static void test_BufferCreate(void) {
   check(buf != NULL);
   check(buf->length == 0);
   check(strcmp(buf->buffer, "") == 0);
-  free(buf->buffer);
+  check(buf->buffer == buf->inline_buffer);
   free(buf);
 }
 
+static void test_BufferInit(void) {
+  Buffer buf;
+  BufferInit(&buf);
+  BufferPrint(&buf, "foo");
+  check(strcmp(BufferData(&buf), "foo") == 0);
+  check(buf.buffer == buf.inline_buffer);
+
+  // Contents move to the heap once they outgrow the inline buffer
+  for (size_t i = 0; i < BUFFER_INLINE_CAPACITY; i++) {
+    BufferAppend(&buf, 'x');
+  }
+  check(buf.buffer != buf.inline_buffer);
+  check(buf.length == BUFFER_INLINE_CAPACITY + 3);
+  check(strncmp(BufferData(&buf), "fooxxx", 6) == 0);
+
+  BufferDeinit(&buf);
+  check(buf.length == 0);
+  check(buf.buffer == buf.inline_buffer);
+}
+
+static void test_BufferReserve(void) {
+  Buffer buf;
+  BufferInit(&buf);
+  BufferPrint(&buf, "foo");
+
+  // Grows straight to the requested size, in a single step
+  BufferReserve(&buf, 10 * DEFAULT_BUFFER_CAPACITY);
+  const char *const data = BufferData(&buf);
+  check(buf.capacity > 10 * DEFAULT_BUFFER_CAPACITY);
+  for (size_t i = 0; i < 10 * DEFAULT_BUFFER_CAPACITY; i++) {
+    BufferAppend(&buf, 'x');
+  }
+  check(BufferData(&buf) == data);
+  check(strncmp(BufferData(&buf), "fooxxx", 6) == 0);
+
+  BufferDeinit(&buf);
+}
+
+static void test_BufferClear(void) {
+  Buffer buf;
+  BufferInit(&buf);
+  BufferPrint(&buf, "foo");
+  BufferClear(&buf);
+  check(BufferLength(&buf) == 0);
+  check(strcmp(BufferData(&buf), "") == 0);
+  BufferDeinit(&buf);
+}
+
 static void test_BufferData(void) {
   Buffer buf = {
       .buffer = "foo",
@@ -56,11 +105,91 @@ static void test_BufferPrintFormat(void) {
   free(buf.buffer);
 }
 
+static void test_BufferPrintFormatGrow(void) {
+  Buffer buf;
+  BufferInit(&buf);
+  BufferPrint(&buf, "foo");
+
+  // Does not fit in the spare capacity, so it is formatted a second time
+  char expected[3 * BUFFER_INLINE_CAPACITY];
+  memset(expected, 'x', sizeof(expected) - 1);
+  expected[sizeof(expected) - 1] = '\0';
+  BufferPrintFormat(&buf, "%s%d", expected, 42);
+  check(buf.length == 3 + (sizeof(expected) - 1) + 2);
+  check(strncmp(BufferData(&buf), "fooxxx", 6) == 0);
+  check(strcmp(BufferData(&buf) + buf.length - 3, "x42") == 0);
+
+  BufferDeinit(&buf);
+}
+
+static void test_BufferPrintN(void) {
+  Buffer buf;
+  BufferInit(&buf);
+  BufferPrintN(&buf, "foobar", 3);
+  BufferPrintN(&buf, NULL, 0);
+  check(strcmp(BufferData(&buf), "foo") == 0);
+  check(BufferLength(&buf) == 3);
+  BufferDeinit(&buf);
+}
+
+static void test_BufferPrintInt(void) {
+  const long long values[] = {0,  1,         -1,        9,        10,
+                              99, 100,       -100,      12345678, -987654321,
+                              LLONG_MAX, LLONG_MIN};
+  char expected[32];
+
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    Buffer buf;
+    BufferInit(&buf);
+    BufferPrintInt(&buf, values[i]);
+    snprintf(expected, sizeof(expected), "%lld", values[i]);
+    check(strcmp(BufferData(&buf), expected) == 0);
+    BufferDeinit(&buf);
+  }
+}
+
+static void test_BufferPrintUInt(void) {
+  const unsigned long long values[] = {0, 7, 42, 1000, ULLONG_MAX};
+  char expected[32];
+
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    Buffer buf;
+    BufferInit(&buf);
+    BufferPrintUInt(&buf, values[i]);
+    snprintf(expected, sizeof(expected), "%llu", values[i]);
+    check(strcmp(BufferData(&buf), expected) == 0);
+    BufferDeinit(&buf);
+  }
+}
+
+static void test_BufferPrintFloat(void) {
+  const double values[] = {0.0,     -0.0,   1.0,     -3.0,   0.5,
+                           3.14159, 1e-7,   2.5e-6,  1e15,   9007199254740992.0,
+                           -1e300,  1.0 / 3};
+  char expected[512];
+
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    Buffer buf;
+    BufferInit(&buf);
+    BufferPrintFloat(&buf, values[i]);
+    snprintf(expected, sizeof(expected), "%f", values[i]);
+    check(strcmp(BufferData(&buf), expected) == 0);
+    BufferDeinit(&buf);
+  }
+}
+
 static void test_BufferToString(void) {
   Buffer *buf = BufferCreate();
   char *str = BufferToString(buf);
   check(strcmp(str, "") == 0);
   free(str);
+
+  buf = BufferCreate();
+  BufferReserve(buf, BUFFER_INLINE_CAPACITY);
+  BufferPrint(buf, "foo");
+  str = BufferToString(buf);
+  check(strcmp(str, "foo") == 0);
+  free(str);
 }
 
 static void test_BufferFromString(void) {
@@ -68,8 +197,7 @@ static void test_BufferFromString(void) {
   Buffer *buf = BufferFromString(str);
   check(strcmp(buf->buffer, str) == 0);
   check(buf->length == 3);
-  free(buf->buffer);
-  free(buf);
+  BufferDestroy(buf);
 }
 
 static void test_BufferReadFile(void) {
@@ -93,6 +221,7 @@ static void test_BufferReadFile(void) {
   check(BufferReadFile(&buf, filename));
   check(strcmp(buf.buffer, str) == 0);
   check(buf.length == 3);
+  free(buf.buffer);
   unlink(filename);
 }
 
@@ -104,11 +233,19 @@ static void test_BufferDestroy(void) {
 
 CHECK_BEGIN
 CHECK_ADD("BufferCreate", test_BufferCreate)
+CHECK_ADD("BufferInit", test_BufferInit)
+CHECK_ADD("BufferReserve", test_BufferReserve)
+CHECK_ADD("BufferClear", test_BufferClear)
 CHECK_ADD("BufferData", test_BufferData)
 CHECK_ADD("BufferLength", test_BufferLength)
 CHECK_ADD("BufferAppend", test_BufferAppend)
 CHECK_ADD("BufferPrint", test_BufferPrint)
 CHECK_ADD("BufferPrintFormat", test_BufferPrintFormat)
+CHECK_ADD("BufferPrintFormatGrow", test_BufferPrintFormatGrow)
+CHECK_ADD("BufferPrintN", test_BufferPrintN)
+CHECK_ADD("BufferPrintInt", test_BufferPrintInt)
+CHECK_ADD("BufferPrintUInt", test_BufferPrintUInt)
+CHECK_ADD("BufferPrintFloat", test_BufferPrintFloat)
 CHECK_ADD("BufferToString", test_BufferToString)
 CHECK_ADD("BufferFromString", test_BufferFromString)
 CHECK_ADD("BufferReadFile", test_BufferReadFile)
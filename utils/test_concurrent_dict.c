@@ -0,0 +1,100 @@
+#include "../tests/check.h"
+#include "concurrent_dict.c"
+
+#define N_THREADS 4
+#define N_KEYS 2000
+
+static void test_ConcurrentDictSet(void) {
+  ConcurrentDict *dict = ConcurrentDictCreate();
+  ConcurrentDictSet(dict, "foo", "bar", NULL);
+  ConcurrentDictSet(dict, "baz", strdup("qux"), free);
+  ConcurrentDictSet(dict, "baz", strdup("quux"), free);
+  check(ConcurrentDictLength(dict) == 2);
+  check(ConcurrentDictHasKey(dict, "foo"));
+  check(!ConcurrentDictHasKey(dict, "bar"));
+  ConcurrentDictDestroy(dict);
+}
+
+static void *CopyString(const void *const str) { return strdup(str); }
+
+static void test_ConcurrentDictGet(void) {
+  ConcurrentDict *dict = ConcurrentDictCreate();
+  ConcurrentDictSet(dict, "foo", strdup("bar"), free);
+
+  void *value;
+  check(ConcurrentDictGet(dict, "foo", CopyString, &value));
+  check(strcmp(value, "bar") == 0);
+  free(value);
+
+  check(ConcurrentDictGet(dict, "foo", NULL, &value));
+  check(strcmp(value, "bar") == 0);
+
+  check(!ConcurrentDictGet(dict, "baz", CopyString, &value));
+
+  ConcurrentDictDestroy(dict);
+}
+
+static void test_ConcurrentDictRemove(void) {
+  ConcurrentDict *dict = ConcurrentDictCreate();
+  ConcurrentDictSet(dict, "foo", "bar", NULL);
+
+  void *value;
+  check(ConcurrentDictRemove(dict, "foo", &value));
+  check(strcmp(value, "bar") == 0);
+  check(!ConcurrentDictRemove(dict, "foo", &value));
+  check(ConcurrentDictLength(dict) == 0);
+
+  ConcurrentDictDestroy(dict);
+}
+
+static void *Worker(void *const arg) {
+  ConcurrentDict *const dict = *(ConcurrentDict **)arg;
+
+  char key[32];
+  for (size_t i = 0; i < N_KEYS; i++) {
+    // All threads write the same keys, and remove every other one
+    snprintf(key, sizeof(key), "key%zu", i);
+    ConcurrentDictSet(dict, key, strdup(key), free);
+
+    void *value;
+    if (ConcurrentDictGet(dict, key, CopyString, &value)) {
+      check(strcmp(value, key) == 0);
+      free(value);
+    }
+
+    if (i % 2 == 0 && ConcurrentDictRemove(dict, key, &value)) {
+      free(value);
+    }
+  }
+
+  return NULL;
+}
+
+static void test_ConcurrentDictThreads(void) {
+  ConcurrentDict *dict = ConcurrentDictCreate();
+
+  pthread_t threads[N_THREADS];
+  for (size_t i = 0; i < N_THREADS; i++) {
+    check(pthread_create(threads + i, NULL, Worker, &dict) == 0);
+  }
+  for (size_t i = 0; i < N_THREADS; i++) {
+    check(pthread_join(threads[i], NULL) == 0);
+  }
+
+  // Odd keys are never removed, even keys may be reinserted after removal
+  char key[32];
+  for (size_t i = 1; i < N_KEYS; i += 2) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    check(ConcurrentDictHasKey(dict, key));
+  }
+  check(ConcurrentDictLength(dict) >= N_KEYS / 2);
+
+  ConcurrentDictDestroy(dict);
+}
+
+CHECK_BEGIN
+CHECK_ADD("ConcurrentDictSet", test_ConcurrentDictSet)
+CHECK_ADD("ConcurrentDictGet", test_ConcurrentDictGet)
+CHECK_ADD("ConcurrentDictRemove", test_ConcurrentDictRemove)
+CHECK_ADD("ConcurrentDictThreads", test_ConcurrentDictThreads)
+CHECK_END
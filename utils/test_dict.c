@@ -3,10 +3,29 @@
 
 static void test_DictCreate(void) {
   Dict *dict = DictCreate();
-  free(dict->buffer);
+  free(dict->segments[0]);
+  free(dict->segments);
+  free(dict->index);
   free(dict);
 }
 
+static void test_DictCreateWithCapacity(void) {
+  Dict *dict = DictCreateWithCapacity(3);
+  const size_t capacity = dict->capacity;
+  check(capacity < DEFAULT_DICT_CAPACITY);
+  DictSet(dict, "foo", NULL, NULL);
+  DictSet(dict, "bar", NULL, NULL);
+  DictSet(dict, "baz", NULL, NULL);
+  check(dict->capacity == capacity);
+  DictDestroy(dict);
+
+  dict = DictCreateWithCapacity(0);
+  DictSet(dict, "foo", "bar", NULL);
+  check(strcmp(DictGet(dict, "foo"), "bar") == 0);
+  check(!DictHasKey(dict, "baz"));
+  DictDestroy(dict);
+}
+
 static void test_DictDestroy(void) {
   Dict *dict = DictCreate();
   DictDestroy(dict);
@@ -85,8 +104,250 @@ static void test_DictRemove(void) {
   DictDestroy(dict);
 }
 
+static void test_DictShrinkToFit(void) {
+  Dict *dict = DictCreate();
+  DictSet(dict, "foo", "one", NULL);
+  DictSet(dict, "bar", "two", NULL);
+  DictShrinkToFit(dict);
+  check(dict->capacity < DEFAULT_DICT_CAPACITY);
+  check(strcmp(DictGet(dict, "foo"), "one") == 0);
+  check(strcmp(DictGet(dict, "bar"), "two") == 0);
+  check(!DictHasKey(dict, "baz"));
+  DictSet(dict, "baz", "three", NULL);
+  check(strcmp(DictGet(dict, "baz"), "three") == 0);
+  DictDestroy(dict);
+}
+
+static void CountEntry(const char *const key, const void *const value,
+                       void *const data) {
+  check(strcmp(key, value) == 0);
+  *(size_t *)data += 1;
+}
+
+static void test_DictForEach(void) {
+  Dict *dict = DictCreate();
+  DictSet(dict, "foo", "foo", NULL);
+  DictSet(dict, "bar", "bar", NULL);
+  DictSet(dict, "baz", "baz", NULL);
+  DictRemove(dict, "bar");
+
+  size_t count = 0;
+  DictForEach(dict, CountEntry, &count);
+  check(count == 2);
+
+  DictDestroy(dict);
+}
+
+static void test_DictIterate(void) {
+  Dict *dict = DictCreate();
+  char key[32];
+  for (size_t i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    DictSet(dict, key, (void *)i, NULL);
+  }
+  for (size_t i = 0; i < 1000; i += 2) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    DictRemove(dict, key);
+  }
+  DictSet(dict, "key0", (void *)1000, NULL);
+
+  // Entries are visited in insertion order, key0 was reinserted last
+  size_t cursor = 0, n = 0;
+  const char *k;
+  const void *v;
+  while (DictIterate(dict, &cursor, &k, &v)) {
+    const size_t i = (n < 500) ? (2 * n) + 1 : 0;
+    snprintf(key, sizeof(key), "key%zu", i);
+    check(strcmp(k, key) == 0);
+    check((size_t)v == ((n < 500) ? i : 1000));
+    n += 1;
+  }
+  check(n == 501);
+
+  DictShrinkToFit(dict);
+  cursor = 0;
+  check(DictIterate(dict, &cursor, &k, NULL));
+  check(strcmp(k, "key1") == 0);
+
+  DictDestroy(dict);
+}
+
+static void test_DictIncrementalRehash(void) {
+  Dict *dict = DictCreateWithCapacity(8);
+  char key[32];
+
+  size_t n_keys = 0;
+  while (dict->old_index == NULL) {
+    snprintf(key, sizeof(key), "key%zu", n_keys++);
+    DictSet(dict, key, strdup(key), free);
+  }
+
+  // Resize in progress, lookups must consult both tables
+  for (size_t i = 0; i < n_keys; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    check(DictHasKey(dict, key));
+    check(strcmp(DictGet(dict, key), key) == 0);
+  }
+
+  // Update and remove entries while they may still be in the old table
+  DictSet(dict, "key0", strdup("updated"), free);
+  free(DictRemove(dict, "key1"));
+  check(DictLength(dict) == n_keys - 1);
+  check(strcmp(DictGet(dict, "key0"), "updated") == 0);
+  check(!DictHasKey(dict, "key1"));
+
+  /* Each insert does a bounded amount of work. At most a step of slots is
+   * migrated, and growing the entry array never moves existing entries. */
+  const Entry *const first = GetEntry(dict, 0);
+  for (size_t i = n_keys; i < 1000; i++) {
+    const size_t rehash_index = dict->rehash_index;
+    snprintf(key, sizeof(key), "key%zu", i);
+    DictSet(dict, key, strdup(key), free);
+
+    check(GetEntry(dict, 0) == first);
+    if (dict->old_index != NULL) {
+      check(dict->rehash_index <= rehash_index + DEFAULT_DICT_REHASH_STEP);
+    }
+  }
+  check(DictLength(dict) == 999);
+  check(dict->num_segments > 1);
+
+  List *keys = DictGetKeys(dict);
+  check(ListLength(keys) == 999);
+  ListDestroy(keys);
+
+  for (size_t i = 2; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    check(strcmp(DictGet(dict, key), key) == 0);
+  }
+
+  // Holes are squeezed out a step at a time as well
+  for (size_t i = 2; i < 700; i++) {
+    const size_t compact_read = dict->compact_read;
+    snprintf(key, sizeof(key), "key%zu", i);
+    free(DictRemove(dict, key));
+
+    if (dict->compacting) {
+      check(dict->compact_read <= compact_read + DEFAULT_DICT_REHASH_STEP);
+    }
+  }
+  check(DictLength(dict) == 301);
+  check(dict->num_entries < 1000);
+
+  // Compaction preserves insertion order
+  keys = DictGetKeys(dict);
+  check(ListLength(keys) == 301);
+  check(strcmp(ListGet(keys, 0), "key0") == 0);
+  for (size_t i = 1; i < 301; i++) {
+    snprintf(key, sizeof(key), "key%zu", i + 699);
+    check(strcmp(ListGet(keys, i), key) == 0);
+    check(strcmp(DictGet(dict, key), key) == 0);
+  }
+  ListDestroy(keys);
+
+  DictDestroy(dict);
+}
+
+static void test_DictCollisionAttack(void) {
+  /* "ab" and "bA" collide under DJB2 (h * 33 + c), and so does any
+   * concatenation of them. This gives 2^12 keys sharing a single DJB2 hash. */
+  const size_t n_blocks = 12, n_keys = (size_t)1 << n_blocks;
+  char key[32];
+
+  Dict *dict = DictCreate();
+  for (size_t i = 0; i < n_keys; i++) {
+    for (size_t j = 0; j < n_blocks; j++) {
+      memcpy(key + (j * 2), ((i >> j) & 1) ? "bA" : "ab", 2);
+    }
+    key[n_blocks * 2] = '\0';
+    DictSet(dict, key, NULL, NULL);
+  }
+  check(DictLength(dict) == n_keys);
+  DictShrinkToFit(dict);
+
+  // The keyed hash must spread them out, keeping probe sequences short
+  size_t max_distance = 0;
+  const size_t mask = dict->capacity - 1;
+  for (size_t slot = 0; slot < dict->capacity; slot++) {
+    const uint32_t position = dict->index[slot];
+    if (position == INDEX_EMPTY) {
+      continue;
+    }
+    const size_t home = GetEntry(dict, position - 1)->hash & mask;
+    const size_t distance = (slot - home) & mask;
+    if (distance > max_distance) {
+      max_distance = distance;
+    }
+  }
+  check(max_distance < 256);
+
+  DictDestroy(dict);
+}
+
+static void test_DictChurn(void) {
+  const size_t n_keys = 1000;
+  char key[32];
+
+  Dict *dict = DictCreate();
+  for (size_t i = 0; i < n_keys; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    DictSet(dict, key, NULL, NULL);
+  }
+  DictShrinkToFit(dict);
+  const size_t capacity = dict->capacity;
+
+  // Insert/remove cycles at steady size must neither grow the index nor
+  // leave anything behind in it
+  for (size_t i = 0; i < 100 * n_keys; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    DictRemove(dict, key);
+    snprintf(key, sizeof(key), "key%zu", i + n_keys);
+    DictSet(dict, key, NULL, NULL);
+
+    check(dict->capacity == capacity);
+    check(dict->in_use == n_keys);
+  }
+  check(dict->num_entries <= 2 * n_keys);
+  check(dict->entries_capacity <= 3 * n_keys);
+
+  for (size_t i = 0; i < n_keys; i++) {
+    snprintf(key, sizeof(key), "key%zu", i + (100 * n_keys));
+    check(DictHasKey(dict, key));
+    snprintf(key, sizeof(key), "key%zu", i);
+    check(!DictHasKey(dict, key));
+  }
+
+  DictDestroy(dict);
+}
+
+static void test_DictHashed(void) {
+  Dict *dict = DictCreate();
+  const uint64_t hash = DictHashKey("foo");
+  check(hash == DictHashKey("foo"));
+
+  const void *value = NULL;
+  check(!DictGetHashed(dict, "foo", hash, &value));
+  check(!DictRemoveHashed(dict, "foo", hash, NULL));
+
+  DictSetHashed(dict, "foo", hash, strdup("bar"), free);
+  check(DictHasKey(dict, "foo"));
+  check(DictGetHashed(dict, "foo", hash, &value));
+  check(strcmp(value, "bar") == 0);
+  check(DictGetHashed(dict, "foo", hash, NULL));
+
+  void *removed = NULL;
+  check(DictRemoveHashed(dict, "foo", hash, &removed));
+  check(strcmp(removed, "bar") == 0);
+  free(removed);
+  check(!DictHasKey(dict, "foo"));
+  check(!DictGetHashed(dict, "foo", hash, NULL));
+
+  DictDestroy(dict);
+}
+
 CHECK_BEGIN
 CHECK_ADD("DictCreate", test_DictCreate)
+CHECK_ADD("DictCreateWithCapacity", test_DictCreateWithCapacity)
 CHECK_ADD("DictDestroy", test_DictDestroy)
 CHECK_ADD("DictLength", test_DictLength)
 CHECK_ADD("DictSet", test_DictSet)
@@ -94,4 +355,11 @@ CHECK_ADD("DictHasKey", test_DictHasKey)
 CHECK_ADD("DictGetKeys", test_DictGetKeys)
 CHECK_ADD("DictGet", test_DictGet)
 CHECK_ADD("DictRemove", test_DictRemove)
+CHECK_ADD("DictShrinkToFit", test_DictShrinkToFit)
+CHECK_ADD("DictForEach", test_DictForEach)
+CHECK_ADD("DictIterate", test_DictIterate)
+CHECK_ADD("DictIncrementalRehash", test_DictIncrementalRehash)
+CHECK_ADD("DictCollisionAttack", test_DictCollisionAttack)
+CHECK_ADD("DictChurn", test_DictChurn)
+CHECK_ADD("DictHashed", test_DictHashed)
 CHECK_END
@@ -0,0 +1,72 @@
+#include "../tests/check.h"
+#include "hash.c"
+
+static void test_HashBytes(void) {
+  const char key[] = "The quick brown fox jumps over the lazy dog";
+  const uint64_t hash = HashBytes(key, sizeof(key) - 1);
+  check(HashBytes(key, sizeof(key) - 1) == hash);
+
+  // Every prefix length exercises a different tail
+  for (size_t i = 0; i < sizeof(key) - 1; i++) {
+    check(HashBytes(key, i) != hash);
+    check(HashBytes(key, i) != HashBytes(key, i + 1));
+  }
+}
+
+static void test_HashSetSeed(void) {
+  const char key[] = "foo";
+
+  HashSetSeed(0, 0);
+  const uint64_t hash = HashBytes(key, sizeof(key) - 1);
+  HashSetSeed(0, 1);
+  check(HashBytes(key, sizeof(key) - 1) != hash);
+  HashSetSeed(0, 0);
+  check(HashBytes(key, sizeof(key) - 1) == hash);
+}
+
+static void test_HashBytesKeyed(void) {
+  const char key[] = "foo";
+
+  HashSetSeed(1, 2);
+  check(HashBytesKeyed(key, sizeof(key) - 1, 1, 2) ==
+        HashBytes(key, sizeof(key) - 1));
+  check(HashBytesKeyed(key, sizeof(key) - 1, 2, 1) !=
+        HashBytes(key, sizeof(key) - 1));
+}
+
+static void test_HashBytesKeyedVectors(void) {
+  /* Reference SipHash-1-3 outputs for the key 00 01 .. 0f and the messages
+   * 00 01 .. (length - 1). The lengths cover every tail size, as well as
+   * messages spanning one and several full words. */
+  static const struct {
+    size_t length;
+    uint64_t hash;
+  } VECTORS[] = {
+      {0, 0xabac0158050fc4dcULL},  {1, 0xc9f49bf37d57ca93ULL},
+      {2, 0x82cb9b024dc7d44dULL},  {3, 0x8bf80ab8e7ddf7fbULL},
+      {4, 0xcf75576088d38328ULL},  {5, 0xdef9d52f49533b67ULL},
+      {6, 0xc50d2b50c59f22a7ULL},  {7, 0xd3927d989bb11140ULL},
+      {8, 0x369095118d299a8eULL},  {9, 0x25a48eb36c063de4ULL},
+      {15, 0xd320d86d2a519956ULL}, {16, 0xcc4fdd1a7d908b66ULL},
+      {17, 0x9cf2689063dbd80cULL}, {31, 0x2370dd1f8c21d1bcULL},
+      {63, 0x9d199062b7bbb3a8ULL},
+  };
+  const uint64_t k0 = 0x0706050403020100ULL, k1 = 0x0f0e0d0c0b0a0908ULL;
+
+  unsigned char message[64];
+  for (size_t i = 0; i < sizeof(message); i++) {
+    message[i] = (unsigned char)i;
+  }
+
+  for (size_t i = 0; i < sizeof(VECTORS) / sizeof(VECTORS[0]); i++) {
+    check(HashBytesKeyed(message, VECTORS[i].length, k0, k1) ==
+          VECTORS[i].hash);
+  }
+}
+
+CHECK_BEGIN
+CHECK_ADD("HashBytes", test_HashBytes)
+CHECK_ADD("HashSetSeed", test_HashSetSeed)
+CHECK_ADD("HashBytesKeyed", test_HashBytesKeyed)
+CHECK_ADD("HashBytesKeyedVectors", test_HashBytesKeyedVectors)
+CHECK_END
@@ -0,0 +1,99 @@
+#include "../tests/check.h"
+#include "int_dict.c"
+
+static void test_IntDictCreate(void) {
+  IntDict *dict = IntDictCreate();
+  check(dict->length == 0);
+  check(dict->capacity == DEFAULT_DICT_CAPACITY);
+  free(dict->entries);
+  free(dict->index);
+  free(dict);
+}
+
+static void test_IntDictCreateWithCapacity(void) {
+  IntDict *dict = IntDictCreateWithCapacity(3);
+  const size_t capacity = dict->capacity;
+  check(capacity < DEFAULT_DICT_CAPACITY);
+  IntDictSet(dict, 1, NULL, NULL);
+  IntDictSet(dict, 2, NULL, NULL);
+  IntDictSet(dict, 3, NULL, NULL);
+  check(dict->capacity == capacity);
+  IntDictDestroy(dict);
+
+  dict = IntDictCreateWithCapacity(0);
+  IntDictSet(dict, 0, "foo", NULL);
+  IntDictSet(dict, UINT64_MAX, "bar", NULL);
+  check(strcmp(IntDictGet(dict, 0), "foo") == 0);
+  check(strcmp(IntDictGet(dict, UINT64_MAX), "bar") == 0);
+  IntDictDestroy(dict);
+}
+
+static void test_IntDictSet(void) {
+  IntDict *dict = IntDictCreate();
+  IntDictSet(dict, 1, "foo", NULL);
+  IntDictSet(dict, 2, strdup("bar"), free);
+  IntDictSet(dict, 2, strdup("baz"), free);
+  check(IntDictLength(dict) == 2);
+  check(strcmp(IntDictGet(dict, 2), "baz") == 0);
+  IntDictDestroy(dict);
+}
+
+static void test_IntDictHasKey(void) {
+  IntDict *dict = IntDictCreate();
+  IntDictSet(dict, 1, NULL, NULL);
+  IntDictSet(dict, 3, NULL, NULL);
+  check(IntDictHasKey(dict, 1));
+  check(!IntDictHasKey(dict, 2));
+  check(IntDictHasKey(dict, 3));
+  IntDictDestroy(dict);
+}
+
+static void test_IntDictRemove(void) {
+  IntDict *dict = IntDictCreate();
+  for (uint64_t i = 0; i < 1000; i++) {
+    IntDictSet(dict, i, (void *)(uintptr_t)i, NULL);
+  }
+  for (uint64_t i = 0; i < 1000; i += 2) {
+    check((uint64_t)(uintptr_t)IntDictRemove(dict, i) == i);
+  }
+  check(IntDictLength(dict) == 500);
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    check(IntDictHasKey(dict, i) == (i % 2 == 1));
+    if (i % 2 == 1) {
+      check((uint64_t)(uintptr_t)IntDictGet(dict, i) == i);
+    }
+  }
+
+  IntDictDestroy(dict);
+}
+
+static void test_IntDictIterate(void) {
+  IntDict *dict = IntDictCreate();
+  IntDictSet(dict, 10, "foo", NULL);
+  IntDictSet(dict, 20, "bar", NULL);
+  IntDictSet(dict, 30, "baz", NULL);
+  IntDictRemove(dict, 10);
+
+  size_t cursor = 0;
+  uint64_t key;
+  const void *value;
+  check(IntDictIterate(dict, &cursor, &key, &value));
+  check(key == 30);
+  check(strcmp(value, "baz") == 0);
+  check(IntDictIterate(dict, &cursor, &key, &value));
+  check(key == 20);
+  check(strcmp(value, "bar") == 0);
+  check(!IntDictIterate(dict, &cursor, &key, &value));
+
+  IntDictDestroy(dict);
+}
+
+CHECK_BEGIN
+CHECK_ADD("IntDictCreate", test_IntDictCreate)
+CHECK_ADD("IntDictCreateWithCapacity", test_IntDictCreateWithCapacity)
+CHECK_ADD("IntDictSet", test_IntDictSet)
+CHECK_ADD("IntDictHasKey", test_IntDictHasKey)
+CHECK_ADD("IntDictRemove", test_IntDictRemove)
+CHECK_ADD("IntDictIterate", test_IntDictIterate)
+CHECK_END
@@ -12,6 +12,24 @@ static void test_ListCreate(void) {
   free(list);
 }
 
+static void test_ListCreateWithCapacity(void) {
+  List *list = ListCreateWithCapacity(3);
+  check(list->capacity == 3);
+  ListAppend(list, "foo", NULL);
+  ListAppend(list, "bar", NULL);
+  ListAppend(list, "baz", NULL);
+  check(list->capacity == 3);
+  ListAppend(list, "qux", NULL);
+  check(list->capacity == 6);
+  ListDestroy(list);
+
+  list = ListCreateWithCapacity(0);
+  ListAppend(list, "foo", NULL);
+  ListAppend(list, "bar", NULL);
+  check(strcmp(ListGet(list, 1), "bar") == 0);
+  ListDestroy(list);
+}
+
 static void test_ListDestroy(void) {
   List *list = ListCreate();
   ListDestroy(list);
@@ -108,8 +126,22 @@ static void test_ListInsert(void) {
   ListDestroy(list);
 }
 
+static void test_ListShrinkToFit(void) {
+  List *list = ListCreate();
+  ListAppend(list, "foo", NULL);
+  ListAppend(list, "bar", NULL);
+  ListShrinkToFit(list);
+  check(list->capacity == 2);
+  check(strcmp(ListGet(list, 0), "foo") == 0);
+  check(strcmp(ListGet(list, 1), "bar") == 0);
+  ListAppend(list, "baz", NULL);
+  check(strcmp(ListGet(list, 2), "baz") == 0);
+  ListDestroy(list);
+}
+
 CHECK_BEGIN
 CHECK_ADD("ListCreate", test_ListCreate)
+CHECK_ADD("ListCreateWithCapacity", test_ListCreateWithCapacity)
 CHECK_ADD("ListDestroy", test_ListDestroy)
 CHECK_ADD("ListLength", test_ListLength)
 CHECK_ADD("ListAppend", test_ListAppend)
@@ -117,4 +149,5 @@ CHECK_ADD("ListGet", test_ListGet)
 CHECK_ADD("ListSet", test_ListSet)
 CHECK_ADD("ListRemove", test_ListRemove)
 CHECK_ADD("ListInsert", test_ListInsert)
+CHECK_ADD("ListShrinkToFit", test_ListShrinkToFit)
 CHECK_END
\ No newline at end of file
@@ -13,9 +13,93 @@ static void test_LOG_ERROR(void) { LOG_ERROR("%s", "foo"); }
 
 static void test_LOG_CRITICAL(void) { LOG_CRITICAL("%s", "foo"); }
 
+static void test_LoggerAsync(void) {
+  LoggerStartAsync(LOGGER_OVERFLOW_BLOCK);
+  LOG_WARNING("%d|%5s|%-5s|%.2f|%zu|%c|%x|%lld|%%|%*d|%.*s", -42, "foo", "bar",
+              3.14159, (size_t)7, 'z', 255u, -1234567890123LL, 4, 12, 2,
+              "baz");
+  LOG_ERROR("%s", "foo");
+  LOG_DEBUG("%s", "hidden");
+
+  // Positional arguments are formatted by the caller
+  LOG_WARNING("%2$s %1$s", "foo", "bar");
+
+  LoggerSetDebug(true);
+  LOG_DEBUG("%hhu %hd %lu %jd %td %p", (unsigned char)255, (short)-1, 1UL,
+            (intmax_t)-2, (ptrdiff_t)3, NULL);
+  LoggerStopAsync();
+
+  LoggerStats stats;
+  LoggerGetStats(&stats);
+  check(stats.logged == 4);
+  check(stats.dropped == 0);
+}
+
+#define NUM_THREADS 4
+#define NUM_MESSAGES 10000
+
+static void *LogMessages(void *const arg) {
+  for (size_t i = 0; i < NUM_MESSAGES; i++) {
+    LOG_WARNING("thread %zu message %zu", (size_t)arg, i);
+  }
+  return NULL;
+}
+
+static void LogFromThreads(const enum LoggerOverflowPolicy policy,
+                           LoggerStats *const stats) {
+  LoggerStartAsync(policy);
+
+  pthread_t threads[NUM_THREADS];
+  for (size_t i = 0; i < NUM_THREADS; i++) {
+    check(pthread_create(&threads[i], NULL, LogMessages, (void *)i) == 0);
+  }
+  for (size_t i = 0; i < NUM_THREADS; i++) {
+    check(pthread_join(threads[i], NULL) == 0);
+  }
+
+  LoggerFlush();
+  LoggerGetStats(stats);
+  LoggerStopAsync();
+}
+
+static void test_LoggerAsyncThreads(void) {
+  LoggerStats stats;
+
+  // Nothing is lost while producers wait for room in the queue
+  LogFromThreads(LOGGER_OVERFLOW_BLOCK, &stats);
+  check(stats.logged == NUM_THREADS * NUM_MESSAGES);
+  check(stats.dropped == 0);
+  check(stats.batches > 0 && stats.batches <= stats.logged);
+
+  // Otherwise, every message is accounted for
+  LogFromThreads(LOGGER_OVERFLOW_DROP, &stats);
+  check(stats.logged + stats.dropped == NUM_THREADS * NUM_MESSAGES);
+}
+
+static void test_LoggerAsyncPrecision(void) {
+  // Strings need not be terminated within their precision
+  char *const str = xmalloc(3);
+  memcpy(str, "foo", 3);
+
+  LoggerStartAsync(LOGGER_OVERFLOW_BLOCK);
+  LOG_WARNING("%.3s|%.*s|%.*s|%.10s", str, 2, str, -1, "bar", "baz");
+  LoggerStopAsync();
+  xfree(str);
+}
+
+static void test_LoggerAsyncCritical(void) {
+  LoggerStartAsync(LOGGER_OVERFLOW_DROP);
+  LOG_WARNING("%s", "foo");
+  LOG_CRITICAL("%s", "bar");
+}
+
 CHECK_BEGIN
 CHECK_ADD("LOG_DEBUG", test_LOG_DEBUG)
 CHECK_ADD("LOG_WARNING", test_LOG_WARNING)
 CHECK_ADD("LOG_ERROR", test_LOG_ERROR)
 CHECK_ADD("LOG_CRITICAL", test_LOG_CRITICAL)
+CHECK_ADD("LoggerAsync", test_LoggerAsync)
+CHECK_ADD("LoggerAsyncThreads", test_LoggerAsyncThreads)
+CHECK_ADD("LoggerAsyncPrecision", test_LoggerAsyncPrecision)
+CHECK_ADD("LoggerAsyncCritical", test_LoggerAsyncCritical)
 CHECK_END
@@ -0,0 +1,139 @@
+#include "../tests/check.h"
+#include "pool.c"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+static void test_PoolAlloc(void) {
+  // Objects of one size class never overlap
+  char *objects[1000];
+  for (size_t i = 0; i < 1000; i++) {
+    objects[i] = PoolAlloc(24);
+    check(((uintptr_t)objects[i] % alignof(max_align_t)) == 0);
+    memset(objects[i], (int)(i % 256), 24);
+  }
+  for (size_t i = 0; i < 1000; i++) {
+    for (size_t j = 0; j < 24; j++) {
+      check(objects[i][j] == (char)(i % 256));
+    }
+  }
+
+  // Released objects are reused first
+  PoolFree(objects[500], 24);
+  check(PoolAlloc(32) == objects[500]);
+
+  for (size_t i = 0; i < 1000; i++) {
+    PoolFree(objects[i], 24);
+  }
+  PoolFree(NULL, 24);
+
+  // Objects of other sizes are allocated elsewhere
+  void *const small = PoolAlloc(0);
+  void *const large = PoolAlloc(POOL_MAX_SIZE + 1);
+  check(small != large);
+  PoolFree(small, 0);
+  PoolFree(large, POOL_MAX_SIZE + 1);
+}
+
+static void *AllocObjects(void *const arg) {
+  void **const objects = (void **)arg;
+  for (size_t i = 0; i < 100; i++) {
+    objects[i] = PoolAlloc(sizeof(void *));
+  }
+  return NULL;
+}
+
+static void *ReuseSlab(void *const arg) {
+  Slab *const slab = (Slab *)arg;
+  const size_t num_objects = GetNumObjects(slab->size_class);
+  void **const objects = malloc(num_objects * sizeof(void *));
+
+  bool reused = true;
+  for (size_t i = 0; i < num_objects; i++) {
+    objects[i] = PoolAlloc(sizeof(void *));
+    reused = reused && (GetSlab(objects[i]) == slab);
+  }
+  for (size_t i = 0; i < num_objects; i++) {
+    PoolFree(objects[i], sizeof(void *));
+  }
+
+  free(objects);
+  return reused ? slab : NULL;
+}
+
+static void test_PoolFree(void) {
+  // Objects may be released by another thread than they were allocated by
+  void *objects[100];
+  pthread_t thread;
+  check(pthread_create(&thread, NULL, AllocObjects, objects) == 0);
+  check(pthread_join(thread, NULL) == 0);
+
+  // The thread exited with objects allocated, so its pool is left behind
+  Slab *const slab = GetSlab(objects[0]);
+  check(ORPHANS != NULL);
+  check(slab->owner == ORPHANS);
+
+  // Objects are handed back to the pool owning their slab
+  for (size_t i = 0; i < 100; i++) {
+    PoolFree(objects[i], sizeof(void *));
+  }
+  check(POOL == NULL);
+
+  /* The next thread adopts the pool, and takes over the handed back objects
+   * before carving a new slab. */
+  void *result;
+  check(pthread_create(&thread, NULL, ReuseSlab, slab) == 0);
+  check(pthread_join(thread, &result) == 0);
+  check(result == slab);
+
+  // That thread exited with every object released, so was the pool
+  check(ORPHANS == NULL);
+}
+
+static void *AllocObject(void *const arg) {
+  (void)arg;
+  return PoolAlloc(16);
+}
+
+static void test_PoolTrackingLatch(void) {
+  // Whether objects are pooled is decided once for every thread
+  PoolFree(PoolAlloc(16), 16);
+  AllocSetTracking(ALLOC_TRACK_SITES);
+
+  pthread_t thread;
+  void *object;
+  check(pthread_create(&thread, NULL, AllocObject, NULL) == 0);
+  check(pthread_join(thread, &object) == 0);
+  check(object != NULL);
+
+  FILE *const stream = tmpfile();
+  check(stream != NULL);
+  check(AllocReport(stream) == 0);
+  fclose(stream);
+
+  PoolFree(object, 16);
+  AllocSetTracking(0);
+}
+
+static void test_PoolTracking(void) {
+  // Objects are allocated by call site while tracking call sites
+  AllocSetTracking(ALLOC_TRACK_SITES);
+  void *const object = PoolAlloc(16);
+
+  FILE *const stream = tmpfile();
+  check(stream != NULL);
+  check(AllocReport(stream) == 1);
+  fclose(stream);
+
+  PoolFree(object, 16);
+  check(AllocReport(stderr) == 0);
+  AllocSetTracking(0);
+}
+
+CHECK_BEGIN
+CHECK_ADD("PoolAlloc", test_PoolAlloc)
+CHECK_ADD("PoolFree", test_PoolFree)
+CHECK_ADD("PoolTracking", test_PoolTracking)
+CHECK_ADD("PoolTrackingLatch", test_PoolTrackingLatch)
+CHECK_END
@@ -0,0 +1,41 @@
+#include "../tests/check.h"
+#include "ptr_dict.c"
+
+static void test_PtrDictSet(void) {
+  int a, b;
+  PtrDict *dict = PtrDictCreate();
+  PtrDictSet(dict, &a, "foo", NULL);
+  PtrDictSet(dict, &b, strdup("bar"), free);
+  PtrDictSet(dict, NULL, "baz", NULL);
+  check(PtrDictLength(dict) == 3);
+
+  check(strcmp(PtrDictGet(dict, &a), "foo") == 0);
+  check(strcmp(PtrDictGet(dict, &b), "bar") == 0);
+  check(strcmp(PtrDictGet(dict, NULL), "baz") == 0);
+
+  check(strcmp(PtrDictRemove(dict, &a), "foo") == 0);
+  check(!PtrDictHasKey(dict, &a));
+  check(PtrDictHasKey(dict, &b));
+
+  PtrDictDestroy(dict);
+}
+
+static void test_PtrDictIterate(void) {
+  int a;
+  PtrDict *dict = PtrDictCreateWithCapacity(1);
+  PtrDictSet(dict, &a, "foo", NULL);
+
+  size_t cursor = 0;
+  const void *key, *value;
+  check(PtrDictIterate(dict, &cursor, &key, &value));
+  check(key == &a);
+  check(strcmp(value, "foo") == 0);
+  check(!PtrDictIterate(dict, &cursor, &key, &value));
+
+  PtrDictDestroy(dict);
+}
+
+CHECK_BEGIN
+CHECK_ADD("PtrDictSet", test_PtrDictSet)
+CHECK_ADD("PtrDictIterate", test_PtrDictIterate)
+CHECK_END
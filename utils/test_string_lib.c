@@ -1,6 +1,7 @@
 #include "../tests/check.h"
 #include "string_lib.c"
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,9 +40,71 @@ static void test_StringDuplicateN(void) {
   free(duplicate);
 }
 
+static void test_StringToUInt(void) {
+  unsigned long long value = 0;
+  check(StringToUInt("0", 1, &value) && value == 0);
+  check(StringToUInt("1234567", 4, &value) && value == 1234);
+  check(StringToUInt("18446744073709551615", 20, &value) &&
+        value == ULLONG_MAX);
+
+  check(!StringToUInt("18446744073709551616", 20, &value));
+  check(!StringToUInt("99999999999999999999", 20, &value));
+  check(!StringToUInt("", 0, &value));
+  check(!StringToUInt("12a", 3, &value));
+  check(!StringToUInt("-1", 2, &value));
+  check(value == ULLONG_MAX);
+}
+
+static void test_StringToDouble(void) {
+  static const char *const NUMBERS[] = {
+      "0.",
+      "0.0",
+      "3.14",
+      "42.",
+      "0.1",
+      "0.001",
+      "000.5",
+      "123456789.987654321",
+      "9007199254740993.0",
+      "0.30000000000000004",
+      "1.7976931348623157",
+      "12345678901234567890123456789.5",
+      "0.00000000000000000000000000001",
+      "4503599627370497.5",
+  };
+
+  for (size_t i = 0; i < sizeof(NUMBERS) / sizeof(NUMBERS[0]); i++) {
+    double value = -1.0;
+    check(StringToDouble(NUMBERS[i], strlen(NUMBERS[i]), &value));
+    check(value == strtod(NUMBERS[i], NULL));
+  }
+
+  // Every prefix of numbers with two to six digits and a four digit fraction
+  char str[16];
+  for (int i = 0; i < 1000000; i += 7) {
+    const int length =
+        snprintf(str, sizeof(str), "%d.%04d", i / 10000, i % 10000);
+    for (int j = length; j > 0 && str[j - 1] != '.'; j--) {
+      str[j] = '\0';
+      double value = -1.0;
+      check(StringToDouble(str, (size_t)j, &value));
+      check(value == strtod(str, NULL));
+    }
+  }
+
+  double value = 0.0;
+  check(StringToDouble("2.5xyz", 3, &value) && value == 2.5);
+  check(!StringToDouble("", 0, &value));
+  check(!StringToDouble(".", 1, &value));
+  check(!StringToDouble("1.2.3", 5, &value));
+  check(!StringToDouble("1e5", 3, &value));
+}
+
 CHECK_BEGIN
 CHECK_ADD("StringEqual", test_StringEqual)
 CHECK_ADD("StringFormat", test_StringFormat)
 CHECK_ADD("StringDuplicate", test_StringDuplicate)
 CHECK_ADD("StringDuplicateN", test_StringDuplicateN)
+CHECK_ADD("StringToUInt", test_StringToUInt)
+CHECK_ADD("StringToDouble", test_StringToDouble)
 CHECK_END